@@ -76,6 +76,11 @@ class IoTest {
   }
 
   void TestRead() {
+    // Blocks are freed in one batch per container after reading
+    size_t num_containers = CHI_ADMIN->GetDomainSize(
+        HSHM_MCTX, chi::DomainQuery::GetLocalHash(0),
+        chi::DomainId(client_.pool_id_, chi::SubDomain::kGlobalContainers));
+    std::vector<std::vector<chi::Block>> frees(num_containers);
     hshm::MpiTimer timer(MPI_COMM_WORLD);
     timer.Resume();
     int node_id = 1;
@@ -91,7 +96,7 @@ class IoTest {
       if (data.IsNull()) {
         HELOG(kFatal, "Buffer allocated was null");
       }
-      client_.Free(HSHM_MCTX, dom_query, block);
+      frees[node_id % num_containers].emplace_back(block);
       if (!Verify(data.ptr_, key_, block.size_)) {
         size_t sum = Sum(data.ptr_, block.size_);
         HELOG(kFatal, "Read invalid: sum={} when expected {}", sum,
@@ -100,6 +105,15 @@ class IoTest {
       CHI_CLIENT->FreeBuffer(HSHM_MCTX, data);
       node_id++;
     }
+    for (size_t i = 0; i < num_containers; ++i) {
+      if (frees[i].empty()) {
+        continue;
+      }
+      client_.FreeBatch(HSHM_MCTX,
+                        chi::DomainQuery::GetDirectHash(
+                            chi::SubDomain::kGlobalContainers, i),
+                        frees[i]);
+    }
     timer.Pause();
     timer.Collect();
     if (rank_ == 0) {
@@ -0,0 +1,228 @@
+#include <hermes_shm/util/logging.h>
+#include <hermes_shm/util/timer.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "chimaera/api/chimaera_runtime.h"
+#include "small_message/small_message_client.h"
+
+/**
+ * Compares the switch-based Run() of a generated lib_exec against the
+ * table-driven Module::DispatchRun registered by CHI_TASK_CC.
+ * The first case dispatches one method of the real small_message ChiMod,
+ * which the branch predictor learns. The second dispatches a seeded
+ * random mix of kNumMethods tiny methods shaped like the generated code,
+ * which exposes the cost of mispredicted switch branches.
+ * */
+
+/** Allocate a container of the linked ChiMod, as the module registry does */
+extern "C" void *alloc_state(const chi::PoolId *pool_id,
+                             const char *pool_name);
+
+struct BenchTask {
+  size_t count_ = 0;
+};
+
+struct BenchBase {
+  virtual ~BenchBase() = default;
+  virtual void Run(uint32_t method, BenchTask *task) = 0;
+};
+
+typedef void (*BenchMethod_t)(BenchBase *exec, BenchTask *task);
+
+#define BENCH_METHOD(N)                                                        \
+  __attribute__((noinline)) void Method##N(BenchTask *task) {                  \
+    task->count_ += N;                                                         \
+  }
+
+#define BENCH_CASE(N)                                                          \
+  case N: {                                                                    \
+    Method##N(task);                                                           \
+    break;                                                                     \
+  }
+
+#define BENCH_ENTRY(N)                                                         \
+  [](BenchBase *exec, BenchTask *task) {                                       \
+    static_cast<BenchServer *>(exec)->Method##N(task);                         \
+  }
+
+class BenchServer : public BenchBase {
+public:
+  static constexpr uint32_t kNumMethods = 32;
+
+public:
+  BENCH_METHOD(0)
+  BENCH_METHOD(1)
+  BENCH_METHOD(2)
+  BENCH_METHOD(3)
+  BENCH_METHOD(4)
+  BENCH_METHOD(5)
+  BENCH_METHOD(6)
+  BENCH_METHOD(7)
+  BENCH_METHOD(8)
+  BENCH_METHOD(9)
+  BENCH_METHOD(10)
+  BENCH_METHOD(11)
+  BENCH_METHOD(12)
+  BENCH_METHOD(13)
+  BENCH_METHOD(14)
+  BENCH_METHOD(15)
+  BENCH_METHOD(16)
+  BENCH_METHOD(17)
+  BENCH_METHOD(18)
+  BENCH_METHOD(19)
+  BENCH_METHOD(20)
+  BENCH_METHOD(21)
+  BENCH_METHOD(22)
+  BENCH_METHOD(23)
+  BENCH_METHOD(24)
+  BENCH_METHOD(25)
+  BENCH_METHOD(26)
+  BENCH_METHOD(27)
+  BENCH_METHOD(28)
+  BENCH_METHOD(29)
+  BENCH_METHOD(30)
+  BENCH_METHOD(31)
+
+  /** Switch-based dispatch (as in the generated Run) */
+  void Run(uint32_t method, BenchTask *task) override {
+    switch (method) {
+      BENCH_CASE(0)
+      BENCH_CASE(1)
+      BENCH_CASE(2)
+      BENCH_CASE(3)
+      BENCH_CASE(4)
+      BENCH_CASE(5)
+      BENCH_CASE(6)
+      BENCH_CASE(7)
+      BENCH_CASE(8)
+      BENCH_CASE(9)
+      BENCH_CASE(10)
+      BENCH_CASE(11)
+      BENCH_CASE(12)
+      BENCH_CASE(13)
+      BENCH_CASE(14)
+      BENCH_CASE(15)
+      BENCH_CASE(16)
+      BENCH_CASE(17)
+      BENCH_CASE(18)
+      BENCH_CASE(19)
+      BENCH_CASE(20)
+      BENCH_CASE(21)
+      BENCH_CASE(22)
+      BENCH_CASE(23)
+      BENCH_CASE(24)
+      BENCH_CASE(25)
+      BENCH_CASE(26)
+      BENCH_CASE(27)
+      BENCH_CASE(28)
+      BENCH_CASE(29)
+      BENCH_CASE(30)
+      BENCH_CASE(31)
+    }
+  }
+
+  /** Table-driven dispatch (as in the generated GetMethodTable) */
+  static const BenchMethod_t *GetRunTable() {
+    static constexpr BenchMethod_t kRun[kNumMethods] = {
+        BENCH_ENTRY(0),  BENCH_ENTRY(1),  BENCH_ENTRY(2),  BENCH_ENTRY(3),
+        BENCH_ENTRY(4),  BENCH_ENTRY(5),  BENCH_ENTRY(6),  BENCH_ENTRY(7),
+        BENCH_ENTRY(8),  BENCH_ENTRY(9),  BENCH_ENTRY(10), BENCH_ENTRY(11),
+        BENCH_ENTRY(12), BENCH_ENTRY(13), BENCH_ENTRY(14), BENCH_ENTRY(15),
+        BENCH_ENTRY(16), BENCH_ENTRY(17), BENCH_ENTRY(18), BENCH_ENTRY(19),
+        BENCH_ENTRY(20), BENCH_ENTRY(21), BENCH_ENTRY(22), BENCH_ENTRY(23),
+        BENCH_ENTRY(24), BENCH_ENTRY(25), BENCH_ENTRY(26), BENCH_ENTRY(27),
+        BENCH_ENTRY(28), BENCH_ENTRY(29), BENCH_ENTRY(30), BENCH_ENTRY(31),
+    };
+    return kRun;
+  }
+};
+
+/** Dispatch Md tasks of depth 0 on small_message, which only set ret_ */
+void BenchSingleMethod(size_t ops) {
+  chi::PoolId pool_id = chi::PoolId::GetNull();
+  chi::Container *exec = reinterpret_cast<chi::Container *>(
+      alloc_state(&pool_id, "bench_dispatch"));
+  if (exec->methods_.count_ == 0) {
+    HELOG(kFatal, "small_message did not register a method table");
+  }
+  hipc::CtxAllocator<CHI_ALLOC_T> alloc;
+  chi::small_message::MdTask task(alloc);
+  task.method_ = chi::small_message::Method::kMd;
+  task.depth_ = 0;
+  chi::RunContext &rctx = task.rctx_;
+  size_t checksum = 0;
+
+  // Switch-based dispatch
+  hshm::Timer t;
+  t.Resume();
+  for (size_t i = 0; i < ops; ++i) {
+    task.ret_ = 0;
+    exec->Run(task.method_, &task, rctx);
+    checksum += task.ret_;
+  }
+  t.Pause();
+  HILOG(kInfo, "Single method, switch dispatch: {} MOps (checksum {})",
+        ops / t.GetUsec(), checksum);
+
+  // Table-driven dispatch
+  checksum = 0;
+  t.Reset();
+  t.Resume();
+  for (size_t i = 0; i < ops; ++i) {
+    task.ret_ = 0;
+    exec->DispatchRun(task.method_, &task, rctx);
+    checksum += task.ret_;
+  }
+  t.Pause();
+  HILOG(kInfo, "Single method, table dispatch: {} MOps (checksum {})",
+        ops / t.GetUsec(), checksum);
+  delete exec;
+}
+
+/** Dispatch a seeded random sequence of the synthetic methods */
+void BenchMethodMix(size_t ops) {
+  std::mt19937 rng(1024);
+  std::uniform_int_distribution<uint32_t> dist(0,
+                                               BenchServer::kNumMethods - 1);
+  std::vector<uint32_t> methods(ops);
+  for (size_t i = 0; i < ops; ++i) {
+    methods[i] = dist(rng);
+  }
+  BenchServer server;
+  BenchBase *exec = &server;
+  const BenchMethod_t *table = BenchServer::GetRunTable();
+  BenchTask task;
+
+  // Switch-based dispatch
+  hshm::Timer t;
+  t.Resume();
+  for (size_t i = 0; i < ops; ++i) {
+    exec->Run(methods[i], &task);
+  }
+  t.Pause();
+  HILOG(kInfo, "Method mix, switch dispatch: {} MOps (checksum {})",
+        ops / t.GetUsec(), task.count_);
+
+  // Table-driven dispatch
+  task.count_ = 0;
+  t.Reset();
+  t.Resume();
+  for (size_t i = 0; i < ops; ++i) {
+    table[methods[i]](exec, &task);
+  }
+  t.Pause();
+  HILOG(kInfo, "Method mix, table dispatch: {} MOps (checksum {})",
+        ops / t.GetUsec(), task.count_);
+}
+
+int main(int argc, char **argv) {
+  size_t ops = (1 << 24);
+  if (argc > 1) {
+    ops = std::stoul(argv[1]);
+  }
+  BenchSingleMethod(ops);
+  BenchMethodMix(ops);
+}
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Regenerate the *_lib_exec.h of every ChiMod under a directory from its
+*_methods.compiled.yaml. The lib_exec holds the virtual method switches
+and the GetMethodTable() dispatch tables registered by CHI_TASK_CC.
+
+Usage: refresh_lib_exec.py <tasks dir> [<tasks dir> ...]
+"""
+
+import os
+import re
+import sys
+
+
+def load_methods(path):
+    """Parse "kName: {'val': id, ...}" lines, skipping negative ids"""
+    methods = []
+    pattern = re.compile(r"(\w+): \{'val': (-?\d+)")
+    with open(path) as fp:
+        for line in fp:
+            match = pattern.match(line.strip())
+            if match and int(match.group(2)) >= 0:
+                methods.append((match.group(1), int(match.group(2))))
+    return methods
+
+
+def switch(lines, header, methods, case_fn, footer='}'):
+    lines.append(header)
+    lines.append('  switch (method) {')
+    for name, _ in methods:
+        lines.append(f'    case Method::{name}: {{')
+        lines.extend(case_fn(name[1:]))
+        lines.append('      break;')
+        lines.append('    }')
+    lines.append('  }')
+    lines.append(footer)
+
+
+def table(lines, decl, count, methods, entry_fn):
+    by_id = dict((val, name[1:]) for name, val in methods)
+    lines.append(f'  static constexpr {decl}[Method::kCount] = {{')
+    for i in range(count):
+        if i in by_id:
+            lines.extend(entry_fn(by_id[i]))
+        else:
+            lines.append('    nullptr,')
+    lines.append('  };')
+
+
+def gen_lib_exec(mod_name, methods):
+    guard = f'CHI_{mod_name.upper()}_LIB_EXEC_H_'
+    count = max(val for _, val in methods) + 1
+    lines = [f'#ifndef {guard}', f'#define {guard}', '']
+    switch(lines, '/** Execute a task */\n'
+           'void Run(u32 method, Task *task, RunContext &rctx) override {',
+           methods, lambda t: [
+               f'      {t}(reinterpret_cast<{t}Task *>(task), rctx);'])
+    switch(lines, '/** Execute a task */\n'
+           'void Monitor(MonitorModeId mode, MethodId method, Task *task, '
+           'RunContext &rctx) override {',
+           methods, lambda t: [
+               f'      Monitor{t}(mode, reinterpret_cast<{t}Task *>(task), '
+               'rctx);'])
+    switch(lines, '/** Delete a task */\n'
+           'void Del(const hipc::MemContext &mctx, u32 method, Task *task) '
+           'override {',
+           methods, lambda t: [
+               f'      CHI_CLIENT->DelTask<{t}Task>(mctx, '
+               f'reinterpret_cast<{t}Task *>(task));'])
+    switch(lines, '/** Duplicate a task */\n'
+           'void CopyStart(u32 method, const Task *orig_task, Task *dup_task, '
+           'bool deep) override {',
+           methods, lambda t: [
+               '      chi::CALL_COPY_START(',
+               f'        reinterpret_cast<const {t}Task*>(orig_task), ',
+               f'        reinterpret_cast<{t}Task*>(dup_task), deep);'])
+    switch(lines, '/** Duplicate a task */\n'
+           'void NewCopyStart(u32 method, const Task *orig_task, '
+           'FullPtr<Task> &dup_task, bool deep) override {',
+           methods, lambda t: [
+               '      chi::CALL_NEW_COPY_START(reinterpret_cast<const '
+               f'{t}Task*>(orig_task), dup_task, deep);'])
+    switch(lines, '/** Serialize a task when initially pushing into remote */\n'
+           'void SaveStart(\n'
+           '    u32 method, BinaryOutputArchive<true> &ar,\n'
+           '    Task *task) override {',
+           methods, lambda t: [
+               f'      ar << *reinterpret_cast<{t}Task*>(task);'])
+    switch(lines, '/** Deserialize a task when popping from remote queue */\n'
+           'TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> '
+           '&ar) override {\n'
+           '  TaskPointer task_ptr;',
+           methods, lambda t: [
+               f'      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<{t}Task>(',
+               '             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);',
+               f'      ar >> *reinterpret_cast<{t}Task*>(task_ptr.ptr_);'],
+           footer='  return task_ptr;\n}')
+    switch(lines, '/** Serialize a task when returning from remote queue */\n'
+           'void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, '
+           'Task *task) override {',
+           methods, lambda t: [
+               f'      ar << *reinterpret_cast<{t}Task*>(task);'])
+    switch(lines, '/** Deserialize a task when popping from remote queue */\n'
+           'void LoadEnd(u32 method, BinaryInputArchive<false> &ar, '
+           'Task *task) override {',
+           methods, lambda t: [
+               f'      ar >> *reinterpret_cast<{t}Task*>(task);'])
+    lines.append('/** Method dispatch table (indexed by method) */')
+    lines.append('static const chi::MethodTable &GetMethodTable() {')
+    table(lines, 'chi::RunMethod_t kRun', count, methods, lambda t: [
+        '    [](Container *exec, Task *task, RunContext &rctx) {',
+        f'      static_cast<Server *>(exec)->{t}(',
+        f'        reinterpret_cast<{t}Task *>(task), rctx);',
+        '    },'])
+    table(lines, 'chi::MonitorMethod_t kMonitor', count, methods, lambda t: [
+        '    [](Container *exec, MonitorModeId mode, Task *task, '
+        'RunContext &rctx) {',
+        f'      static_cast<Server *>(exec)->Monitor{t}(',
+        f'        mode, reinterpret_cast<{t}Task *>(task), rctx);',
+        '    },'])
+    table(lines, 'chi::DelMethod_t kDel', count, methods, lambda t: [
+        '    [](const hipc::MemContext &mctx, Task *task) {',
+        f'      CHI_CLIENT->DelTask<{t}Task>(',
+        f'        mctx, reinterpret_cast<{t}Task *>(task));',
+        '    },'])
+    lines.append('  static constexpr chi::MethodTable kTable = '
+                 '{kRun, kMonitor, kDel, Method::kCount};')
+    lines.append('  return kTable;')
+    lines.append('}')
+    lines.append('')
+    lines.append(f'#endif  // {guard}')
+    return '\n'.join(lines)
+
+
+def refresh(tasks_dir):
+    for root, _, files in os.walk(tasks_dir):
+        for file in files:
+            if not file.endswith('_methods.compiled.yaml'):
+                continue
+            mod_name = file[:-len('_methods.compiled.yaml')]
+            methods = load_methods(os.path.join(root, file))
+            path = os.path.join(root, f'{mod_name}_lib_exec.h')
+            with open(path, 'w') as fp:
+                fp.write(gen_lib_exec(mod_name, methods))
+            print(f'Generated {path}')
+
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    for tasks_dir in sys.argv[1:]:
+        refresh(tasks_dir)
@@ -70,26 +70,23 @@ void Client::CreateClientOnHostForGpu() {
 /** Allocate a buffer */
 template <bool FROM_REMOTE>
 HSHM_INLINE_CROSS_FUN FullPtr<char> Client::AllocateBufferSafe(
-    const hipc::CtxAllocator<CHI_DATA_ALLOC_T> &alloc, size_t size) {
-  FullPtr<char> p(FullPtr<char>::GetNull());
+    const hipc::CtxAllocator<CHI_DATA_ALLOC_T> &alloc, size_t size,
+    size_t alignment) {
   // HILOG(kInfo, "(node {}) Beginning to allocate {} from {}",
   //       CHI_CLIENT->node_id_, size, alloc->GetId());
   if (size == 0) {
     return FullPtr<char>::GetNull();
   }
-  while (true) {
-#ifdef HSHM_IS_HOST
-    try {
-      p = alloc->AllocateLocalPtr<char>(alloc.ctx_, size);
-    } catch (hshm::Error &e) {
-      p.shm_.SetNull();
-    }
+  FullPtr<char> p = TryAllocateDataPtr(alloc, size, alignment);
+  if (!p.shm_.IsNull()) {
+    return p;
+  }
+  header_->buffer_exhausted_ += 1;
+#if defined(HSHM_IS_HOST) && !defined(CHIMAERA_RUNTIME)
+  return WaitForBuffer(alloc, size, alignment);
 #else
-    p = alloc->AllocateLocalPtr<char>(alloc.ctx_, size);
-#endif
-    if (!p.shm_.IsNull()) {
-      break;
-    }
+  // Workers cannot block, since the tasks they run are what free space
+  while (true) {
 #ifdef CHIMAERA_RUNTIME
     if constexpr (FROM_REMOTE) {
       HSHM_THREAD_MODEL->Yield();
@@ -103,10 +100,15 @@ HSHM_INLINE_CROSS_FUN FullPtr<char> Client::AllocateBufferSafe(
 
     // HILOG(kInfo, "(node {}) Trying {} from {}", CHI_CLIENT->node_id_, size,
     //       alloc->GetId());
+    p = TryAllocateDataPtr(alloc, size, alignment);
+    if (!p.shm_.IsNull()) {
+      break;
+    }
   }
   // HILOG(kInfo, "(node {}) Allocated {} from {}", CHI_CLIENT->node_id_, size,
   //       alloc->GetId());
   return p;
+#endif
 }
 
 /** Send a task to the runtime */
@@ -114,11 +116,35 @@ template <typename TaskT>
 HSHM_INLINE_CROSS_FUN void Client::ScheduleTask(Task *parent_task,
                                                 const FullPtr<TaskT> &task) {
 #ifndef CHIMAERA_RUNTIME
+#ifdef HSHM_IS_HOST
+  if (lane_policy_ == LanePolicy::kKey) {
+    // Tasks without an object key keep to the lane of their domain query
+    if constexpr (HasLaneKey<TaskT>::value) {
+      task->rctx_.lane_key_ = task->GetLaneKey();
+    } else {
+      task->rctx_.lane_key_ = hshm::hash<chi::DomainQuery>{}(task->dom_query_);
+    }
+  }
+  if (header_->admission_.IsEnabled() && !Admit(task.ptr_, admission_reject_)) {
+    task->SetRejected();
+    if (task->IsFireAndForget()) {
+      // Nobody waits on the task to resend it, so it never runs
+      header_->admission_.dropped_ += 1;
+      FullPtr<TaskT> rejected = task;
+      DelTask(HSHM_MCTX, rejected);
+    } else {
+      task->SetComplete();
+    }
+    return;
+  }
+  u32 lane_hash = SelectLane(task.ptr_);
+#else
+  u32 lane_hash = hshm::hash<chi::DomainQuery>{}(task->dom_query_);
+#endif
   chi::ingress::MultiQueue *queue = CHI_CLIENT->GetQueue(chi::PROCESS_QUEUE_ID);
   // HILOG(kInfo, "Scheduling task (client, prior, node={}): {} pool={} dom={}",
   //       node_id_, task->task_node_, task->pool_, task->dom_query_);
-  queue->Emplace(chi::TaskPrioOpt::kLowLatency,
-                 hshm::hash<chi::DomainQuery>{}(task->dom_query_), task.shm_);
+  queue->Emplace(chi::TaskPrioOpt::kLowLatency, lane_hash, task.shm_);
   // HILOG(kInfo, "Scheduling task (client, node={}): {} pool={} dom={}",
   // node_id_,
   //       task->task_node_, task->pool_, task->dom_query_);
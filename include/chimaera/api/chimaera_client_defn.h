@@ -14,6 +14,7 @@
 #define CHI_INCLUDE_CHI_CLIENT_CHI_CLIENT_DEFN_H_
 
 #include <string>
+#include <vector>
 
 #include "chimaera/network/serialize_defn.h"
 #include "chimaera/queue_manager/queue_manager.h"
@@ -32,6 +33,32 @@ public:
   int data_;
   hipc::atomic<hshm::min_u64> *unique_;
   NodeId node_id_;
+  /** Freed task objects kept per task type per thread */
+  size_t task_cache_depth_ = 0;
+  /** Give up allocating a buffer after this long. 0 waits forever. */
+  size_t buffer_wait_timeout_ms_ = 0;
+  /** Reject tasks of a pool at its in-flight limit, rather than block */
+  bool admission_reject_ = false;
+  /** How tasks are spread over the ingress lanes */
+  LanePolicy lane_policy_ = LanePolicy::kHash;
+
+#ifdef HSHM_IS_HOST
+  /**
+   * Freed objects of one task type, kept by a thread so that NewTask
+   * and DelTask do not go to the shared allocator each time
+   * */
+  template <typename TaskT>
+  struct TaskCache {
+    CHI_MAIN_ALLOC_T *alloc_ = nullptr;
+    std::vector<FullPtr<TaskT>> free_;
+
+    ~TaskCache() {
+      for (FullPtr<TaskT> &task : free_) {
+        alloc_->FreeLocalPtr(HSHM_MCTX, task);
+      }
+    }
+  };
+#endif
 
 public:
   /** Default constructor */
@@ -129,12 +156,63 @@ public:
     return task;
   }
 
+#ifdef HSHM_IS_HOST
+  /** Get this thread's cache of freed \a TaskT objects */
+  template <typename TaskT>
+  TaskCache<TaskT> &GetTaskCache() {
+    static thread_local TaskCache<TaskT> cache;
+    if (cache.alloc_ == nullptr) {
+      cache.alloc_ = main_alloc_;
+      cache.free_.reserve(task_cache_depth_);
+    }
+    return cache;
+  }
+#endif
+
+  /** Destroy a task and keep its memory for reuse, unless the cache is full */
+  template <typename TaskT>
+  HSHM_INLINE_CROSS_FUN bool CacheTask(const FullPtr<TaskT> &task) {
+#if defined(HSHM_IS_HOST) && !defined(CHIMAERA_TASK_DEBUG)
+    TaskCache<TaskT> &cache = GetTaskCache<TaskT>();
+    if (cache.free_.size() >= task_cache_depth_) {
+      return false;
+    }
+    task.ptr_->~TaskT();
+    cache.free_.emplace_back(task);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /** Take the memory of a cached task, or null if there is none */
+  template <typename TaskT>
+  HSHM_INLINE_CROSS_FUN FullPtr<TaskT> PopCachedTask() {
+#if defined(HSHM_IS_HOST) && !defined(CHIMAERA_TASK_DEBUG)
+    TaskCache<TaskT> &cache = GetTaskCache<TaskT>();
+    if (!cache.free_.empty()) {
+      FullPtr<TaskT> task = cache.free_.back();
+      cache.free_.pop_back();
+      return task;
+    }
+#endif
+    FullPtr<TaskT> task;
+    task.ptr_ = nullptr;
+    return task;
+  }
+
   /** Create a task */
   template <typename TaskT, typename... Args>
   HSHM_INLINE_CROSS_FUN FullPtr<TaskT> NewTask(const hipc::MemContext &mctx,
                                                const TaskNode &task_node,
                                                Args &&...args) {
-    FullPtr<TaskT> ptr = main_alloc_->NewObjLocal<TaskT>(
+    FullPtr<TaskT> ptr = PopCachedTask<TaskT>();
+    if (ptr.ptr_ != nullptr) {
+      ConstructTask<TaskT>(mctx, ptr.ptr_, task_node,
+                           std::forward<Args>(args)...);
+      return ptr;
+    }
+    ptr = main_alloc_->NewObjLocal<TaskT>(
         mctx, hipc::CtxAllocator<CHI_ALLOC_T>{main_alloc_, mctx}, task_node,
         std::forward<Args>(args)...);
     if (ptr.shm_.IsNull()) {
@@ -204,7 +282,9 @@ public:
 #ifdef CHIMAERA_TASK_DEBUG
     MonitorTaskFrees(task);
 #else
-    main_alloc_->DelObj<TaskT>(mctx, task);
+    if (!CacheTask(FullPtr<TaskT>(task))) {
+      main_alloc_->DelObj<TaskT>(mctx, task);
+    }
 #endif
   }
 
@@ -215,7 +295,9 @@ public:
 #ifdef CHIMAERA_TASK_DEBUG
     MonitorTaskFrees(task);
 #else
-    main_alloc_->DelObjLocal<TaskT>(mctx, task);
+    if (!CacheTask(task)) {
+      main_alloc_->DelObjLocal<TaskT>(mctx, task);
+    }
 #endif
   }
 
@@ -227,7 +309,7 @@ public:
 #ifdef CHIMAERA_TASK_DEBUG
     MonitorTaskFrees(task);
 #else
-    exec->Del(mctx, task->method_, task);
+    exec->DispatchDel(mctx, task->method_, task);
 #endif
   }
 
@@ -238,7 +320,7 @@ public:
 #ifdef CHIMAERA_TASK_DEBUG
     MonitorTaskFrees(task);
 #else
-    exec->Del(mctx, task->method_, task);
+    exec->DispatchDel(mctx, task->method_, task.ptr_);
 #endif
   }
 #endif
@@ -249,6 +331,22 @@ public:
     return AllocateBufferSafe<false>({mctx, data_alloc_}, size);
   }
 
+  /**
+   * Allocate a buffer starting at a multiple of \a alignment.
+   * Used for I/O to devices opened with O_DIRECT.
+   * */
+  HSHM_INLINE_CROSS_FUN
+  FullPtr<char> AllocateBuffer(const hipc::MemContext &mctx, size_t size,
+                               size_t alignment) {
+    return AllocateBufferSafe<false>({mctx, data_alloc_}, size, alignment);
+  }
+
+  /** Allocate a buffer, or return null at once if data shm is exhausted */
+  HSHM_INLINE_CROSS_FUN
+  FullPtr<char> TryAllocateBuffer(const hipc::MemContext &mctx, size_t size) {
+    return TryAllocateDataPtr({mctx, data_alloc_}, size, 0);
+  }
+
   /** Allocate a buffer (used in remote queue only) */
 #ifdef CHIMAERA_RUNTIME
   HSHM_INLINE
@@ -263,7 +361,57 @@ private:
   template <bool FROM_REMOTE = false>
   HSHM_INLINE_CROSS_FUN FullPtr<char>
   AllocateBufferSafe(const hipc::CtxAllocator<CHI_DATA_ALLOC_T> &alloc,
-                     size_t size);
+                     size_t size, size_t alignment = 0);
+
+  /** Allocate from a data allocator, aligned if \a alignment is set */
+  HSHM_INLINE_CROSS_FUN
+  static FullPtr<char>
+  AllocateDataPtr(const hipc::CtxAllocator<CHI_DATA_ALLOC_T> &alloc,
+                  size_t size, size_t alignment) {
+    if (alignment) {
+      return alloc->AlignedAllocateLocalPtr<char>(alloc.ctx_, size, alignment);
+    }
+    return alloc->AllocateLocalPtr<char>(alloc.ctx_, size);
+  }
+
+  /** Allocate from a data allocator, or null if it is exhausted */
+  HSHM_INLINE_CROSS_FUN
+  static FullPtr<char>
+  TryAllocateDataPtr(const hipc::CtxAllocator<CHI_DATA_ALLOC_T> &alloc,
+                     size_t size, size_t alignment) {
+    FullPtr<char> p(FullPtr<char>::GetNull());
+#ifdef HSHM_IS_HOST
+    try {
+      p = AllocateDataPtr(alloc, size, alignment);
+    } catch (hshm::Error &e) {
+      p.shm_.SetNull();
+    }
+#else
+    p = AllocateDataPtr(alloc, size, alignment);
+#endif
+    return p;
+  }
+
+  /**
+   * Sleep on the buffer_free_seq_ futex until FreeBuffer makes room
+   * for \a size bytes, or until buffer_wait_timeout_ms_ passes.
+   * */
+  FullPtr<char>
+  WaitForBuffer(const hipc::CtxAllocator<CHI_DATA_ALLOC_T> &alloc,
+                size_t size, size_t alignment);
+
+  /** Wake the allocations waiting in WaitForBuffer */
+  void WakeBufferWaiters();
+
+  /** Wake waiting allocations after a buffer is freed */
+  HSHM_INLINE_CROSS_FUN
+  void NotifyBufferFreed() {
+#ifdef HSHM_IS_HOST
+    if (header_->buffer_waiters_.load() > 0) {
+      WakeBufferWaiters();
+    }
+#endif
+  }
 
 public:
   /** Free a buffer */
@@ -272,6 +420,7 @@ public:
     auto alloc =
         HSHM_MEMORY_MANAGER->GetAllocator<CHI_DATA_ALLOC_T>(p.alloc_id_);
     alloc->Free(mctx, p);
+    NotifyBufferFreed();
     // HILOG(kInfo, "(node {}) Freeing to {}", node_id_, alloc->GetId());
   }
 
@@ -281,9 +430,74 @@ public:
     auto alloc =
         HSHM_MEMORY_MANAGER->GetAllocator<CHI_DATA_ALLOC_T>(p.shm_.alloc_id_);
     alloc->FreeLocalPtr(mctx, p);
+    NotifyBufferFreed();
     // HILOG(kInfo, "(node {}) Freeing to {}", node_id_, alloc->GetId());
   }
 
+  /**
+   * Count a task against the in-flight limits of its pool and client.
+   * Sleeps on the release_seq_ futex while the pool is at its limit,
+   * or returns false if \a reject is set.
+   * */
+  bool Admit(Task *task, bool reject);
+
+  /** Wake the tasks waiting in Admit */
+  void WakeAdmissionWaiters();
+
+  /**
+   * Send a task that admission control rejected, blocking until it is
+   * admitted. Waiting on a rejected task does this unless the wait passes
+   * TASK_KEEP_REJECTED, so the sync wrappers never return the output of a
+   * task that did not run.
+   * */
+  void ResubmitRejected(Task *task);
+
+  /** Release the admission of a task that has ended */
+  HSHM_INLINE_CROSS_FUN
+  void ReleaseAdmission(Task *task) {
+    AdmissionTable &table = header_->admission_;
+    table.Get(task->rctx_.admit_slot_).Release();
+    if (task->rctx_.client_slot_ >= 0) {
+      table.Get(task->rctx_.client_slot_).Release();
+    }
+    task->rctx_.admit_slot_ = -1;
+    task->rctx_.client_slot_ = -1;
+#ifdef HSHM_IS_HOST
+    if (table.waiters_.load() > 0) {
+      WakeAdmissionWaiters();
+    }
+#endif
+  }
+
+  /** Count the ingress lanes, and map them to NUMA nodes for kNuma */
+  void InitLanes();
+
+  /** Pick the ingress lane of a task according to lane_policy_ */
+  u32 SelectLane(Task *task);
+
+  /** Get the number of tasks this process put in each ingress lane */
+  std::vector<size_t> GetLaneStats();
+
+  /** Get the counters of exhausted buffer allocations */
+  HSHM_INLINE_CROSS_FUN
+  BufferStats GetBufferStats() {
+    BufferStats stats;
+    stats.exhausted_ = header_->buffer_exhausted_.load();
+    stats.timeouts_ = header_->buffer_timeouts_.load();
+    stats.waiters_ = header_->buffer_waiters_.load();
+    return stats;
+  }
+
+  /** Get the counters of tasks turned away by admission control */
+  HSHM_INLINE_CROSS_FUN
+  AdmissionStats GetAdmissionStats() {
+    AdmissionStats stats;
+    stats.rejected_ = header_->admission_.rejected_.load();
+    stats.dropped_ = header_->admission_.dropped_.load();
+    stats.waiters_ = header_->admission_.waiters_.load();
+    return stats;
+  }
+
   /** Get the queue ID */
   HSHM_INLINE_CROSS_FUN
   QueueId GetQueueId(const PoolId &id) {
@@ -13,10 +13,18 @@
 #ifndef CHI_INCLUDE_CHI_MANAGER_MANAGER_H_
 #define CHI_INCLUDE_CHI_MANAGER_MANAGER_H_
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
 #include "chimaera/chimaera_constants.h"
 #include "chimaera/chimaera_types.h"
 #include "chimaera/config/config_client.h"
 #include "chimaera/config/config_server.h"
+#include "chimaera/queue_manager/admission.h"
 #include "chimaera/queue_manager/queue_manager.h"
 
 namespace chi {
@@ -27,6 +35,16 @@ struct ChiShm {
   hipc::atomic<hshm::min_u64> unique_;
   u64 num_nodes_;
   NodeId node_id_;
+  /** Futex word bumped by FreeBuffer while allocations wait for space */
+  hipc::atomic<hshm::min_u32> buffer_free_seq_;
+  /** Number of allocations waiting for space */
+  hipc::atomic<hshm::min_u32> buffer_waiters_;
+  /** Allocations that found data shm exhausted */
+  hipc::atomic<hshm::min_u64> buffer_exhausted_;
+  /** Allocations that gave up waiting */
+  hipc::atomic<hshm::min_u64> buffer_timeouts_;
+  /** In-flight limits of pools */
+  AdmissionTable admission_;
 };
 
 /** The configuration used inherited by runtime + client */
@@ -44,6 +62,8 @@ class ConfigurationManager {
   CHI_MAIN_ALLOC_T *main_alloc_;
   CHI_DATA_ALLOC_T *data_alloc_;
   CHI_RDATA_ALLOC_T *rdata_alloc_;
+  /** Whether the main, data and rdata backends are mapped from hugetlbfs */
+  bool hugetlb_backend_[3] = {false, false, false};
   CHI_SHM_GPU_ALLOC_T *gpu_alloc_[HSHM_MAX_GPUS];
   int ngpu_ = 0;
   bool is_being_initialized_;
@@ -152,6 +172,192 @@ class ConfigurationManager {
     client_config_->LoadFromFile(config_path);
   }
 
+  /** Path of the hugetlbfs file backing the shared memory region \a name */
+  std::string GetHugetlbPath(const std::string &name) {
+    size_t off = name.find_first_not_of('/');
+    return server_config_->queue_manager_.hugetlbfs_path_ + "/" +
+           name.substr(off == std::string::npos ? name.size() : off);
+  }
+
+  /**
+   * Create the shared memory backend \a backend_id. Hugepage regions are
+   * first mapped from a file on hugetlbfs, which the kernel places on a
+   * hugepage boundary in every process that maps it. If hugetlbfs has no
+   * free pages, the region falls back to POSIX shm, which AdviseHugepages
+   * then asks to use transparent hugepages.
+   * */
+  void CreateShmBackend(int backend_id, size_t size, const std::string &name,
+                        bool hugepages) {
+    auto mem_mngr = HSHM_MEMORY_MANAGER;
+    if (hugepages) {
+      // Remove a stale file so clients never attach to a previous runtime
+      std::string path = GetHugetlbPath(name);
+      unlink(path.c_str());
+      char *region = MapHugetlb(path, size, true);
+      if (region) {
+        mem_mngr->CreateBackend<hipc::ArrayBackend>(
+            hipc::MemoryBackendId::Get(backend_id), size, region);
+        hugetlb_backend_[backend_id] = true;
+        return;
+      }
+    }
+    mem_mngr->CreateBackend<hipc::PosixShmMmap>(
+        hipc::MemoryBackendId::Get(backend_id), size, name);
+  }
+
+  /**
+   * Attach to the shared memory backend \a backend_id created by the
+   * runtime. The hugetlbfs file only exists if the runtime could map it.
+   * */
+  void AttachShmBackend(int backend_id, const std::string &name,
+                        bool hugepages) {
+    auto mem_mngr = HSHM_MEMORY_MANAGER;
+    if (hugepages) {
+      size_t size = 0;
+      char *region = MapHugetlb(GetHugetlbPath(name), size, false);
+      if (region) {
+        mem_mngr->CreateBackend<hipc::ArrayBackend>(
+            hipc::MemoryBackendId::Get(backend_id), size, region);
+        mem_mngr->ScanBackends();
+        hugetlb_backend_[backend_id] = true;
+        return;
+      }
+    }
+    mem_mngr->AttachBackend(hipc::MemoryBackendType::kPosixShmMmap, name);
+  }
+
+  /** Remove the hugetlbfs files so their hugepages return to the pool */
+  void UnlinkHugetlb() {
+    config::QueueManagerInfo &qm = server_config_->queue_manager_;
+    const std::string *names[3] = {&qm.shm_name_, &qm.data_shm_name_,
+                                   &qm.rdata_shm_name_};
+    for (int i = 0; i < 3; ++i) {
+      if (hugetlb_backend_[i]) {
+        unlink(GetHugetlbPath(*names[i]).c_str());
+      }
+    }
+  }
+
+  /**
+   * Map a file on hugetlbfs. When \a create is set the file is sized to
+   * \a size rounded up to a 2MB hugepage; either way \a size is set to
+   * the size of the file, so every process sees the same backend size. Returns null if hugetlbfs is not mounted or
+   * has too few free hugepages to reserve the mapping.
+   * */
+  static char *MapHugetlb(const std::string &path, size_t &size, bool create) {
+    int fd = open(path.c_str(), O_RDWR | (create ? O_CREAT | O_EXCL : 0),
+                  0666);
+    if (fd < 0) {
+      if (create) {
+        HILOG(kWarning, "Could not use hugetlbfs for {}: {}", path,
+              strerror(errno));
+      }
+      return nullptr;
+    }
+    size_t page_size = MEGABYTES(2);
+    size_t map_size = (size + page_size - 1) / page_size * page_size;
+    struct stat st;
+    if (create) {
+      if (ftruncate(fd, map_size)) {
+        map_size = 0;
+      }
+      size = map_size;
+    } else if (fstat(fd, &st) == 0) {
+      map_size = st.st_size;
+      size = map_size;
+    }
+    void *region = MAP_FAILED;
+    if (map_size) {
+      // Hugetlbfs reserves the pages here, so a short pool fails now
+      // rather than with SIGBUS on first touch
+      region = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                    0);
+    }
+    if (region == MAP_FAILED) {
+      HILOG(kWarning, "Could not map hugetlbfs file {}: {}", path,
+            strerror(errno));
+      if (create) {
+        unlink(path.c_str());
+      }
+      close(fd);
+      return nullptr;
+    }
+    close(fd);
+    return reinterpret_cast<char *>(region);
+  }
+
+  /** Back the shared memory regions with hugepages, if configured */
+  void AdviseHugepages() {
+    config::QueueManagerInfo &qm = server_config_->queue_manager_;
+    if (qm.shm_hugepages_ && !hugetlb_backend_[0]) {
+      AdviseHugepages(main_alloc_->buffer_, main_alloc_->buffer_size_,
+                      qm.shm_name_);
+    }
+    if (qm.data_shm_hugepages_ && !hugetlb_backend_[1]) {
+      AdviseHugepages(data_alloc_->buffer_, data_alloc_->buffer_size_,
+                      qm.data_shm_name_);
+    }
+    if (qm.rdata_shm_hugepages_ && !hugetlb_backend_[2]) {
+      AdviseHugepages(rdata_alloc_->buffer_, rdata_alloc_->buffer_size_,
+                      qm.rdata_shm_name_);
+    }
+  }
+
+  /**
+   * Ask the kernel to back a region with transparent hugepages.
+   * The fallback backends are shm_open + mmap, so the advice is per
+   * mapping, and regular pages are used when shmem hugepages are
+   * disabled or run out.
+   * */
+  static void AdviseHugepages(char *buffer, size_t size,
+                              const std::string &name) {
+#ifdef MADV_HUGEPAGE
+    static const std::string shmem_enabled = []() {
+      std::ifstream file("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+      std::string mode;
+      std::getline(file, mode);
+      return mode;
+    }();
+    if (shmem_enabled.find("[never]") != std::string::npos ||
+        shmem_enabled.find("[deny]") != std::string::npos) {
+      HILOG(kWarning, "Hugepages are disabled for shmem, {} uses regular pages",
+            name);
+      return;
+    }
+    size_t page_size = MEGABYTES(2);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(buffer);
+    uintptr_t end = begin + size;
+    begin = (begin + page_size - 1) / page_size * page_size;
+    end = end / page_size * page_size;
+    if (end <= begin) {
+      return;
+    }
+    if (madvise(reinterpret_cast<void *>(begin), end - begin, MADV_HUGEPAGE)) {
+      HILOG(kWarning, "Could not use hugepages for {}: {}", name,
+            strerror(errno));
+    }
+#else
+    HILOG(kWarning, "Hugepages are not supported, {} uses regular pages",
+          name);
+#endif
+  }
+
+  /** Get the NUMA node of \a cpu, or 0 if unknown */
+  static int GetNumaNode(int cpu) {
+    std::string path =
+        hshm::Formatter::format("/sys/devices/system/cpu/cpu{}", cpu);
+    std::error_code err;
+    for (const stdfs::directory_entry &entry :
+         stdfs::directory_iterator(path, err)) {
+      std::string name = entry.path().filename().string();
+      if (name.rfind("node", 0) == 0 && name.size() > 4 &&
+          isdigit(name[4])) {
+        return std::stoi(name.substr(4));
+      }
+    }
+    return 0;
+  }
+
   /** Get number of nodes */
   HSHM_INLINE int GetNumNodes() {
     return server_config_->rpc_.host_names_.size();
@@ -249,10 +249,13 @@ struct CreateContext {
   u32 global_containers_ = 0;
   u32 local_containers_pn_ = 0;
   u32 lanes_per_container_ = 0;
+  u32 max_inflight_ = 0;            /**< Tasks in flight in the pool, 0 = any */
+  u32 max_inflight_per_client_ = 0; /**< Tasks in flight per client, 0 = any */
 
   /** Serialization */
   template <typename Ar> HSHM_INLINE_CROSS_FUN void serialize(Ar &ar) {
-    ar(id_, global_containers_, local_containers_pn_, lanes_per_container_);
+    ar(id_, global_containers_, local_containers_pn_, lanes_per_container_,
+       max_inflight_, max_inflight_per_client_);
   }
 };
 
@@ -1056,6 +1059,100 @@ struct WorkerStats {
   }
 };
 
+/** Contention statistics of a named coroutine lock site */
+struct CoLockStats {
+  chi::ipc::string name_;
+  size_t acquires_ = 0;
+  size_t contended_ = 0;
+  size_t total_wait_ns_ = 0;
+  size_t max_wait_ns_ = 0;
+  TaskId max_wait_holder_;
+
+  CoLockStats() = default;
+  CoLockStats(hipc::CtxAllocator<CHI_ALLOC_T> &alloc) : name_(alloc) {}
+
+  template <typename Ar> void serialize(Ar &ar) {
+    ar(name_, acquires_, contended_, total_wait_ns_, max_wait_ns_,
+       max_wait_holder_);
+  }
+
+  /** Print operator */
+  friend std::ostream &operator<<(std::ostream &os, const CoLockStats &stats) {
+    return os << "CoLockStats(name=" << stats.name_.str()
+              << ", acquires=" << stats.acquires_
+              << ", contended=" << stats.contended_
+              << ", total_wait_ns=" << stats.total_wait_ns_
+              << ", max_wait_ns=" << stats.max_wait_ns_
+              << ", max_wait_holder=" << stats.max_wait_holder_ << ")";
+  }
+};
+
+/** How often a work orchestrator policy has run its scheduler */
+struct SchedulerStats {
+  PoolId policy_id_;
+  size_t runs_ = 0;
+
+  template <typename Ar> void serialize(Ar &ar) { ar(policy_id_, runs_); }
+
+  /** Print operator */
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const SchedulerStats &stats) {
+    return os << "SchedulerStats(policy_id=" << stats.policy_id_
+              << ", runs=" << stats.runs_ << ")";
+  }
+};
+
+/** How often buffer allocations found data shm exhausted */
+struct BufferStats {
+  /** Allocations that had to wait for space */
+  size_t exhausted_ = 0;
+  /** Allocations that gave up after the wait timeout */
+  size_t timeouts_ = 0;
+  /** Allocations waiting right now */
+  size_t waiters_ = 0;
+
+  template <typename Ar> void serialize(Ar &ar) {
+    ar(exhausted_, timeouts_, waiters_);
+  }
+
+  /** Print operator */
+  friend std::ostream &operator<<(std::ostream &os, const BufferStats &stats) {
+    return os << "BufferStats(exhausted=" << stats.exhausted_
+              << ", timeouts=" << stats.timeouts_
+              << ", waiters=" << stats.waiters_ << ")";
+  }
+};
+
+/** How often admission control turned tasks away */
+struct AdmissionStats {
+  /** Tasks rejected because their pool was at its limit */
+  size_t rejected_ = 0;
+  /** Rejected fire & forget tasks, which are deleted without running */
+  size_t dropped_ = 0;
+  /** Tasks waiting to be admitted right now */
+  size_t waiters_ = 0;
+
+  template <typename Ar> void serialize(Ar &ar) {
+    ar(rejected_, dropped_, waiters_);
+  }
+
+  /** Print operator */
+  friend std::ostream &operator<<(std::ostream &os,
+                                  const AdmissionStats &stats) {
+    return os << "AdmissionStats(rejected=" << stats.rejected_
+              << ", dropped=" << stats.dropped_
+              << ", waiters=" << stats.waiters_ << ")";
+  }
+};
+
+/** How a client spreads its tasks over the ingress lanes */
+enum class LanePolicy {
+  kHash,   /**< Hash the domain query of the task */
+  kSticky, /**< Each client thread keeps to one lane */
+  kNuma,   /**< Hash over the lanes polled on the thread's NUMA node */
+  kKey,    /**< Hash the pool and object key, keeping each key on one lane */
+};
+
 } // namespace chi
 
 namespace hshm {
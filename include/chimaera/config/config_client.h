@@ -14,6 +14,8 @@
 #define CHI_SRC_CONFIG_CLIENT_H_
 
 #include <filesystem>
+
+#include "chimaera/chimaera_types.h"
 #include "config.h"
 
 namespace stdfs = std::filesystem;
@@ -27,6 +29,14 @@ class ClientConfig : public BaseConfig {
  public:
   /** The thread model of the application */
   std::string thread_model_;
+  /** Freed task objects kept per task type per thread */
+  size_t task_cache_depth_ = 64;
+  /** Give up allocating a buffer after this long. 0 waits forever. */
+  size_t buffer_wait_timeout_ms_ = 0;
+  /** Reject tasks of a pool at its in-flight limit, rather than block */
+  bool admission_reject_ = false;
+  /** How tasks are spread over the ingress lanes */
+  LanePolicy lane_policy_ = LanePolicy::kHash;
 
  private:
   void ParseYAML(YAML::Node &yaml_conf) override;
@@ -1,5 +1,21 @@
 #ifndef CHI_SRC_CONFIG_CHI_CLIENT_DEFAULT_H_
 #define CHI_SRC_CONFIG_CHI_CLIENT_DEFAULT_H_
 const inline char* kChiDefaultClientConfigStr = 
-"thread_model: kStd\n";
+"thread_model: kStd\n"
+"# Freed task objects kept per task type per thread for reuse. 0 disables.\n"
+"task_cache_depth: 64\n"
+"# Milliseconds to wait for data shm before AllocateBuffer returns null.\n"
+"# 0 waits forever.\n"
+"buffer_wait_timeout_ms: 0\n"
+"# What to do with a task whose pool is at its in-flight limit:\n"
+"# block until it is admitted, or reject it (Task::IsRejected).\n"
+"# Waiting on a rejected task sends it again and blocks.\n"
+"admission_mode: block\n"
+"# How tasks are spread over the ingress lanes:\n"
+"# hash: by the domain query of the task\n"
+"# sticky: each thread keeps to one lane, and so one worker\n"
+"# numa: over the lanes polled by workers on the thread's NUMA node\n"
+"# key: by pool and the key or blob a task touches, so tasks on one key\n"
+"#      stay in order on one lane. Tasks without a key are hashed as in hash.\n"
+"lane_policy: hash\n";
 #endif  // CHI_SRC_CONFIG_CHI_CLIENT_DEFAULT_H_
\ No newline at end of file
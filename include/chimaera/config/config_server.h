@@ -13,6 +13,8 @@
 #ifndef CHI_SRC_CONFIG_SERVER_H_
 #define CHI_SRC_CONFIG_SERVER_H_
 
+#include <unordered_map>
+
 #include "chimaera/chimaera_types.h"
 #include "config.h"
 
@@ -64,6 +66,14 @@ struct QueueManagerInfo {
   size_t gpu_md_shm_size_;
   /** GPU data shm size */
   size_t gpu_data_shm_size_;
+  /** Back the shared memory region with hugepages */
+  bool shm_hugepages_ = false;
+  /** Back the client data shared memory region with hugepages */
+  bool data_shm_hugepages_ = false;
+  /** Back the runtime data shared memory region with hugepages */
+  bool rdata_shm_hugepages_ = false;
+  /** The hugetlbfs mount that hugepage regions are mapped from */
+  std::string hugetlbfs_path_ = "/dev/hugepages";
   HSHM_HOST_FUN
   QueueManagerInfo() = default;
 
@@ -71,6 +81,16 @@ struct QueueManagerInfo {
   ~QueueManagerInfo() = default;
 };
 
+/**
+ * In-flight limits of a pool, used when CreatePool does not set them
+ * */
+struct AdmissionInfo {
+  /** Tasks in flight in the pool. 0 is unlimited. */
+  u32 max_inflight_ = 0;
+  /** Tasks in flight per client. 0 is unlimited. */
+  u32 max_inflight_per_client_ = 0;
+};
+
 /**
  * RPC information defined in server config
  * */
@@ -102,8 +122,12 @@ public:
   QueueManagerInfo queue_manager_;
   /** The RPC information */
   RpcInfo rpc_;
+  /** In-flight limits of pools, by pool name */
+  std::unordered_map<std::string, AdmissionInfo> admission_;
   /** Bootstrap task registry */
   std::vector<std::string> modules_;
+  /** YAML file mapping module names to library paths */
+  std::string module_manifest_;
 
 public:
   ServerConfig() = default;
@@ -114,6 +138,7 @@ private:
   void ParseWorkOrchestrator(YAML::Node yaml_conf);
   void ParseQueueManager(YAML::Node yaml_conf);
   void ParseRpcInfo(YAML::Node yaml_conf);
+  void ParseAdmission(YAML::Node yaml_conf);
 };
 
 } // namespace chi::config
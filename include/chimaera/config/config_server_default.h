@@ -34,6 +34,16 @@ const inline char* kChiServerDefaultConfigStr =
 "  gpu_md_shm_size: 10m\n"
 "  # The size of shared memory to allocate from GPUs for data\n"
 "  gpu_data_shm_size: 100m\n"
+"  # Back each shared memory region with hugepages. The region is first\n"
+"  # mapped from a file under hugetlbfs_path (see /proc/sys/vm/nr_hugepages).\n"
+"  # Otherwise it falls back to transparent hugepages, which requires\n"
+"  # /sys/kernel/mm/transparent_hugepage/shmem_enabled to be advise or always,\n"
+"  # and then to regular pages.\n"
+"  shm_hugepages: false\n"
+"  data_shm_hugepages: false\n"
+"  rdata_shm_hugepages: false\n"
+"  # The hugetlbfs mount that hugepage regions are mapped from\n"
+"  hugetlbfs_path: /dev/hugepages\n"
 "\n"
 "### Define properties of RPCs\n"
 "rpc:\n"
@@ -62,5 +72,19 @@ const inline char* kChiServerDefaultConfigStr =
 "  cpus: [4, 5]\n"
 "\n"
 "### Task Registry\n"
-"module_registry: []\n";
+"module_registry: []\n"
+"# A YAML file mapping module names to library paths, e.g.:\n"
+"# chimaera_bdev: /opt/chimaera/lib/libchimaera_bdev.so\n"
+"# Modules not in the manifest are searched for in CHI_TASK_PATH and\n"
+"# LD_LIBRARY_PATH.\n"
+"module_manifest: \"\"\n"
+"\n"
+"### Admission control\n"
+"# In-flight task limits of pools, by pool name. Limits passed to CreatePool\n"
+"# take precedence. Clients block on a full pool, or have the task rejected\n"
+"# if admission_mode is reject in the client config. E.g.:\n"
+"# - pool: my_pool\n"
+"#   max_inflight: 4096\n"
+"#   max_inflight_per_client: 256\n"
+"admission: []\n";
 #endif  // CHI_SRC_CONFIG_CHI_SERVER_DEFAULT_H_
\ No newline at end of file
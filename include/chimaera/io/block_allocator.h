@@ -23,18 +23,20 @@ struct BdevStats {
   float write_latency_;
   size_t free_;
   size_t max_cap_;
+  size_t checksum_errors_; /**< Reads which failed checksum verification */
 
   template <typename Ar>
   void serialize(Ar &ar) {
-    ar(read_bw_, write_bw_, read_latency_, write_latency_, free_, max_cap_);
+    ar(read_bw_, write_bw_, read_latency_, write_latency_, free_, max_cap_,
+       checksum_errors_);
   }
 
   friend std::ostream &operator<<(std::ostream &os, const BdevStats &stats) {
     os << hshm::Formatter::format(
         "ReadLat: {}, ReadBW: {}, WriteLat: {}, WriteBw: {}, Free: {}, Max "
-        "Cap: {}",
+        "Cap: {}, Checksum Errors: {}",
         stats.read_latency_, stats.read_bw_, stats.write_latency_,
-        stats.write_bw_, stats.free_, stats.max_cap_);
+        stats.write_bw_, stats.free_, stats.max_cap_, stats.checksum_errors_);
     return os;
   }
 };
@@ -43,14 +45,26 @@ struct BdevStats {
 struct BlockUrl {
   u32 scheme_;
   std::string path_;
+  std::vector<std::string> paths_; /**< Devices to stripe across */
+  size_t stripe_size_;             /**< Stripe unit, 0 if not striped */
+  bool direct_;   /**< Bypass the page cache (O_DIRECT) */
+  bool hugetlb_;  /**< Back RAM with explicit hugepages (MAP_HUGETLB) */
+  bool thp_;      /**< Back RAM with transparent hugepages */
+  bool populate_; /**< Pre-fault RAM at creation */
+  int numa_node_; /**< NUMA node to bind RAM to, or -1 */
+  bool checksum_; /**< Verify reads against CRC32C of written data */
 
   CLS_CONST u32 kFs = 0;
   CLS_CONST u32 kRam = 1;
   CLS_CONST u32 kSpdk = 2;
 
   void Parse(const std::string &url) {
-    // URL Format: <scheme>://<path>
+    // URL Format: <scheme>://<path>[?<option>&<option>...]
     // Example: spdk://dev/nvme0n1
+    // Example: fs:///mnt/nvme/bdev.bin?direct
+    // Example: ram://?hugetlb&populate&numa=1
+    // Example: fs:///mnt/nvme/bdev.bin?direct&checksum
+    // Example: fs:///mnt/nvme0/bdev.bin,/mnt/nvme1/bdev.bin?stripe=1m
     // Parse the scheme
     size_t pos = url.find("://");
     if (pos == std::string::npos) {
@@ -59,6 +73,10 @@ struct BlockUrl {
     } else {
       std::string scheme = url.substr(0, pos);
       path_ = url.substr(pos + 3);
+      // Tolerate a doubled separator (e.g., ram:://)
+      while (!scheme.empty() && scheme.back() == ':') {
+        scheme.pop_back();
+      }
       if (scheme == "fs") {
         scheme_ = kFs;
       } else if (scheme == "ram") {
@@ -69,6 +87,60 @@ struct BlockUrl {
         scheme_ = kFs;
       }
     }
+    ParseOptions();
+    ParsePaths();
+  }
+
+ private:
+  /** Strip the options from the path */
+  void ParseOptions() {
+    stripe_size_ = 0;
+    direct_ = false;
+    hugetlb_ = false;
+    thp_ = false;
+    populate_ = false;
+    numa_node_ = -1;
+    checksum_ = false;
+    size_t pos = path_.find('?');
+    if (pos == std::string::npos) {
+      return;
+    }
+    std::stringstream options(path_.substr(pos + 1));
+    path_ = path_.substr(0, pos);
+    std::string option;
+    while (std::getline(options, option, '&')) {
+      if (option == "direct") {
+        direct_ = true;
+      } else if (option == "hugetlb") {
+        hugetlb_ = true;
+      } else if (option == "thp") {
+        thp_ = true;
+      } else if (option == "populate") {
+        populate_ = true;
+      } else if (option == "checksum") {
+        checksum_ = true;
+      } else if (option.rfind("numa=", 0) == 0) {
+        numa_node_ = std::stoi(option.substr(5));
+      } else if (option.rfind("stripe=", 0) == 0) {
+        stripe_size_ = hshm::ConfigParse::ParseSize(option.substr(7));
+      } else {
+        HELOG(kWarning, "Unknown block device option: {}", option);
+      }
+    }
+  }
+
+  /** Split the path into the devices to stripe across */
+  void ParsePaths() {
+    paths_.clear();
+    size_t start = 0;
+    while (true) {
+      size_t end = path_.find(',', start);
+      paths_.emplace_back(path_.substr(start, end - start));
+      if (end == std::string::npos) {
+        break;
+      }
+      start = end + 1;
+    }
   }
 };
 
@@ -89,7 +161,10 @@ struct PerCoreFreeList {
   hshm::Mutex lock_;
   std::vector<FREE_LIST> lanes_;
 
-  void resize(int num_lanes) { lanes_.resize(num_lanes); }
+  void resize(int num_lanes) {
+    lock_.Init();
+    lanes_.resize(num_lanes);
+  }
 };
 
 struct FreeListMap {
@@ -121,21 +196,50 @@ struct BlockAllocator {
   std::atomic<size_t> heap_off_ = 0;
   std::atomic<size_t> free_size_ = 0;
   size_t max_heap_size_;
+  size_t alignment_ = 1;
   FreeListMap free_list_;
   RwLock compact_lock_;
 
  public:
-  void Init(size_t num_lanes, size_t max_heap_size) {
-    max_heap_size_ = max_heap_size;
-    free_size_ = max_heap_size;
+  /**
+   * Initialize the allocator.
+   * Every block is placed at a multiple of \a alignment, e.g., the
+   * logical block size of a device opened with O_DIRECT.
+   * */
+  void Init(size_t num_lanes, size_t max_heap_size, size_t alignment = 1) {
+    alignment_ = alignment;
+    max_heap_size_ = max_heap_size - max_heap_size % alignment;
+    free_size_ = max_heap_size_;
     // TODO(llogan): Don't hardcode slab sizes
     slab_sizes_.emplace_back(KILOBYTES(4));
     slab_sizes_.emplace_back(KILOBYTES(16));
     slab_sizes_.emplace_back(KILOBYTES(64));
     slab_sizes_.emplace_back(MEGABYTES(1));
+    // Slabs are carved contiguously from the heap, so blocks stay
+    // aligned as long as every slab size is a multiple of the alignment
+    for (size_t &slab_size : slab_sizes_) {
+      slab_size = AlignUp(slab_size);
+    }
+    slab_sizes_.erase(std::unique(slab_sizes_.begin(), slab_sizes_.end()),
+                      slab_sizes_.end());
     free_list_.resize(num_lanes, slab_sizes_.size());
   }
 
+  /** Round a size up to the alignment */
+  size_t AlignUp(size_t size) const {
+    return (size + alignment_ - 1) / alignment_ * alignment_;
+  }
+
+  /** Whether a block lies on alignment boundaries */
+  bool IsAligned(const Block &block) const {
+    return block.off_ % alignment_ == 0 && block.size_ % alignment_ == 0;
+  }
+
+  /**
+   * Allocate blocks totaling at least \a size bytes.
+   * Each slab size takes its free list lock and CASes the heap at most
+   * once, regardless of how many blocks are allocated.
+   * */
   void Allocate(int lane, size_t size, chi::ipc::vector<Block> &buffers,
                 size_t &total_size) {
     u32 buffer_count = 0;
@@ -144,25 +248,71 @@ struct BlockAllocator {
     total_size = 0;
     int slab_idx = 0;
     for (auto &coin : coins) {
-      AllocateSlabs(coin.slab_size_, slab_idx, coin.count_, buffers,
-                    total_size);
+      if (coin.count_) {
+        AllocateSlabs(lane, coin.slab_size_, slab_idx, coin.count_, buffers,
+                      total_size);
+      }
       ++slab_idx;
     }
   }
 
+  /** Free a block */
   void Free(int lane, const Block &block) {
-    int free_list_id = 0;
-    for (size_t slab_size : slab_sizes_) {
-      if (block.size_ <= slab_size) {
-        free_list_.list_[free_list_id].lanes_[lane].push_back(block);
-        free_size_ += block.size_;
-        return;
+    int free_list_id = GetFreeListId(block);
+    if (free_list_id < 0) {
+      return;
+    }
+    PerCoreFreeList &free_list = free_list_.list_[free_list_id];
+    hshm::ScopedMutex scoped(free_list.lock_, 0);
+    free_list.lanes_[lane].push_back(block);
+    free_size_ += block.size_;
+  }
+
+  /**
+   * Free a batch of blocks.
+   * Blocks are grouped by free list first, so each free list is locked
+   * once per batch.
+   * */
+  void FreeBatch(int lane, const chi::ipc::vector<Block> &blocks) {
+    std::vector<FREE_LIST> batches(slab_sizes_.size());
+    size_t freed = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      const Block &block = blocks[i];
+      int free_list_id = GetFreeListId(block);
+      if (free_list_id < 0) {
+        continue;
       }
-      ++free_list_id;
+      batches[free_list_id].push_back(block);
+      freed += block.size_;
     }
+    for (size_t i = 0; i < batches.size(); ++i) {
+      if (batches[i].empty()) {
+        continue;
+      }
+      PerCoreFreeList &free_list = free_list_.list_[i];
+      hshm::ScopedMutex scoped(free_list.lock_, 0);
+      FREE_LIST &lane_list = free_list.lanes_[lane];
+      lane_list.splice(lane_list.end(), batches[i]);
+    }
+    free_size_ += freed;
   }
 
  private:
+  /** Get the free list a block returns to, or -1 if it cannot be freed */
+  int GetFreeListId(const Block &block) {
+    if (!IsAligned(block)) {
+      HELOG(kError, "Freeing a misaligned block (off={}, size={}, align={})",
+            block.off_, block.size_, alignment_);
+      return -1;
+    }
+    for (size_t i = 0; i < slab_sizes_.size(); ++i) {
+      if (block.size_ <= slab_sizes_[i]) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
   /** Find slab nearest to size */
   void FindNearestSlab(size_t size, size_t &slab_id, size_t &slab_size) {
     slab_id = 0;
@@ -205,39 +355,50 @@ struct BlockAllocator {
     return coins;
   }
 
-  /** Allocate slabs of a certain size */
-  void AllocateSlabs(size_t slab_size, int slab_idx, size_t count,
+  /**
+   * Allocate \a count slabs of a certain size.
+   * Free blocks are popped under one lock, and the rest are carved from
+   * the heap with a single CAS.
+   * */
+  void AllocateSlabs(int lane, size_t slab_size, int slab_idx, size_t count,
                      chi::ipc::vector<Block> &buffers, size_t &total_size) {
-    for (size_t i = 0; i < count; ++i) {
-      Block block = ListAllocate(slab_size, 0, slab_idx);
-      if (block.size_ == 0) {
-        break;
+    size_t alloc_size = 0;
+    PerCoreFreeList &free_list = free_list_.list_[slab_idx];
+    {
+      hshm::ScopedMutex scoped(free_list.lock_, 0);
+      FREE_LIST &lane_list = free_list.lanes_[lane];
+      for (; count > 0 && !lane_list.empty(); --count) {
+        Block &block = lane_list.front();
+        buffers.emplace_back(block);
+        alloc_size += block.size_;
+        lane_list.pop_front();
       }
-      buffers.emplace_back(block);
-      total_size += block.size_;
-      free_size_ -= block.size_;
     }
-  }
-
-  Block ListAllocate(size_t slab_size, int lane, int free_list_id) {
-    FREE_LIST &free_list = free_list_.list_[free_list_id].lanes_[lane];
-    if (!free_list.empty()) {
-      Block Block = free_list.front();
-      free_list.pop_front();
-      return Block;
-    } else {
-      Block block;
-      block.off_ = heap_off_.fetch_add(slab_size);
-      block.size_ = slab_size;
-      if (block.off_ + block.size_ > max_heap_size_) {
+    if (count > 0) {
+      size_t off = heap_off_.load();
+      size_t heap_count;
+      do {
+        size_t avail = off < max_heap_size_ ? max_heap_size_ - off : 0;
+        heap_count = std::min(count, avail / slab_size);
+        if (heap_count == 0) {
+          break;
+        }
+      } while (!heap_off_.compare_exchange_weak(
+          off, off + heap_count * slab_size));
+      for (size_t i = 0; i < heap_count; ++i) {
+        Block block;
+        block.off_ = off + i * slab_size;
+        block.size_ = slab_size;
+        buffers.emplace_back(block);
+      }
+      alloc_size += heap_count * slab_size;
+      if (heap_count < count) {
         HELOG(kError, "Out of space on device {} > {}",
-              block.off_ + block.size_, max_heap_size_);
-        block.off_ = 0;
-        block.size_ = 0;
-        return block;
+              off + count * slab_size, max_heap_size_);
       }
-      return block;
     }
+    total_size += alloc_size;
+    free_size_ -= alloc_size;
   }
 };
 
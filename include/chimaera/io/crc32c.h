@@ -0,0 +1,88 @@
+#ifndef CHIMAERA_INCLUDE_CHIMAERA_IO_CRC32C_H_
+#define CHIMAERA_INCLUDE_CHIMAERA_IO_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace chi {
+
+/**
+ * CRC32C (Castagnoli), as used by iSCSI, ext4 and NVMe.
+ * Uses the SSE4.2 crc32 instruction when the CPU supports it, and
+ * a table-driven software implementation otherwise.
+ * */
+class Crc32c {
+ public:
+  /** Compute the CRC of a buffer, continuing from \a crc */
+  static uint32_t Compute(const void *data, size_t size, uint32_t crc = 0) {
+#if defined(__x86_64__)
+    if (HasSse42()) {
+      return ComputeSse42(data, size, crc);
+    }
+#endif
+    return ComputeSoftware(data, size, crc);
+  }
+
+  /** Compute the CRC of a buffer without hardware acceleration */
+  static uint32_t ComputeSoftware(const void *data, size_t size,
+                                  uint32_t crc = 0) {
+    static const Table kTable;
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+      crc = kTable.entries_[(crc ^ ptr[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+  }
+
+#if defined(__x86_64__)
+  /** Whether the CPU has the SSE4.2 crc32 instruction */
+  static bool HasSse42() {
+    static const bool kHasSse42 = __builtin_cpu_supports("sse4.2");
+    return kHasSse42;
+  }
+
+  /** Compute the CRC of a buffer with the SSE4.2 crc32 instruction */
+  __attribute__((target("sse4.2"))) static uint32_t ComputeSse42(
+      const void *data, size_t size, uint32_t crc = 0) {
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    uint64_t crc64 = ~crc;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, ptr, sizeof(word));
+      crc64 = _mm_crc32_u64(crc64, word);
+      ptr += sizeof(uint64_t);
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc64);
+    for (; size > 0; --size) {
+      crc32 = _mm_crc32_u8(crc32, *ptr++);
+    }
+    return ~crc32;
+  }
+#endif
+
+ private:
+  /** Byte-at-a-time lookup table of the reflected polynomial */
+  struct Table {
+    uint32_t entries_[256];
+
+    Table() {
+      for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+          crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+        }
+        entries_[i] = crc;
+      }
+    }
+  };
+};
+
+}  // namespace chi
+
+#endif  // CHIMAERA_INCLUDE_CHIMAERA_IO_CRC32C_H_
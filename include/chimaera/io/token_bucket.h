@@ -0,0 +1,187 @@
+#ifndef CHIMAERA_INCLUDE_CHIMAERA_IO_TOKEN_BUCKET_H_
+#define CHIMAERA_INCLUDE_CHIMAERA_IO_TOKEN_BUCKET_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
+namespace chi {
+
+/** Bandwidth and IOPS limits. A limit of 0 is unlimited. */
+struct QosLimits {
+  size_t bw_;   /**< Bytes per second */
+  size_t iops_; /**< Operations per second */
+
+  /** The limits apply to the whole pool */
+  CLS_CONST u32 kPool = UINT32_MAX;
+  /** The limits apply to every tenant without limits of its own */
+  CLS_CONST u32 kDefaultTenant = UINT32_MAX - 1;
+
+  QosLimits() : bw_(0), iops_(0) {}
+  QosLimits(size_t bw, size_t iops) : bw_(bw), iops_(iops) {}
+
+  /** Whether any limit is set */
+  bool IsLimited() const { return bw_ != 0 || iops_ != 0; }
+
+  template <typename Ar>
+  void serialize(Ar &ar) {
+    ar(bw_, iops_);
+  }
+};
+
+/**
+ * A bucket refilled with tokens at a fixed rate.
+ * An operation is admitted whenever tokens remain, and may overdraw the
+ * bucket, so operations larger than the burst still make progress.
+ * */
+class TokenBucket {
+ public:
+  double rate_;   /**< Tokens per nanosecond, 0 if unlimited */
+  double burst_;  /**< Max tokens accumulated while idle */
+  double tokens_; /**< Tokens currently available */
+  size_t last_ns_;
+
+  /** Credit accumulated while idle is capped at 100ms of the rate */
+  CLS_CONST double kBurstSec = .1;
+
+ public:
+  TokenBucket() : rate_(0), burst_(0), tokens_(0), last_ns_(0) {}
+
+  /** Set the rate in tokens per second, starting with a full bucket */
+  void SetRate(size_t per_sec, size_t now_ns) {
+    rate_ = per_sec / 1e9;
+    burst_ = per_sec * kBurstSec;
+    tokens_ = burst_;
+    last_ns_ = now_ns;
+  }
+
+  /** Add the tokens accrued since the last refill */
+  void Refill(size_t now_ns) {
+    if (now_ns > last_ns_) {
+      tokens_ = std::min(burst_, tokens_ + (now_ns - last_ns_) * rate_);
+      last_ns_ = now_ns;
+    }
+  }
+
+  /** Whether an operation would be admitted */
+  bool HasTokens() const { return rate_ == 0 || tokens_ > 0; }
+
+  /** Consume tokens for an admitted operation */
+  void Take(size_t cost) {
+    if (rate_ != 0) {
+      tokens_ -= cost;
+    }
+  }
+};
+
+/** The token buckets enforcing one set of QosLimits */
+class QosBucket {
+ public:
+  TokenBucket bw_;
+  TokenBucket iops_;
+
+ public:
+  /** Apply new limits */
+  void SetLimits(const QosLimits &limits, size_t now_ns) {
+    bw_.SetRate(limits.bw_, now_ns);
+    iops_.SetRate(limits.iops_, now_ns);
+  }
+
+  /** Whether an operation would be admitted now */
+  bool CanAdmit(size_t now_ns) {
+    bw_.Refill(now_ns);
+    iops_.Refill(now_ns);
+    return bw_.HasTokens() && iops_.HasTokens();
+  }
+
+  /** Charge an admitted operation of \a size bytes */
+  void Charge(size_t size) {
+    bw_.Take(size);
+    iops_.Take(1);
+  }
+};
+
+/**
+ * Admission control for the I/O of a pool.
+ * An operation must fit both the pool-wide bucket and the bucket of
+ * the tenant issuing it. Tenants without limits of their own get the
+ * default tenant limits.
+ * */
+class QosPolicy {
+ public:
+  QosLimits pool_limits_;
+  QosLimits default_limits_;
+  QosBucket pool_;
+  std::unordered_map<u32, QosBucket> tenants_;
+  std::unordered_map<u32, QosLimits> tenant_limits_;
+  std::atomic<bool> enabled_;
+  hshm::Mutex lock_;
+
+ public:
+  QosPolicy() : enabled_(false) { lock_.Init(); }
+
+  /** Set the limits of the pool, the default tenant, or a tenant */
+  void SetLimits(u32 tenant, const QosLimits &limits) {
+    hshm::ScopedMutex scoped(lock_, 0);
+    size_t now = GetNsec();
+    if (tenant == QosLimits::kPool) {
+      pool_limits_ = limits;
+      pool_.SetLimits(limits, now);
+    } else if (tenant == QosLimits::kDefaultTenant) {
+      default_limits_ = limits;
+      for (auto &it : tenants_) {
+        if (tenant_limits_.find(it.first) == tenant_limits_.end()) {
+          it.second.SetLimits(limits, now);
+        }
+      }
+    } else {
+      tenant_limits_[tenant] = limits;
+      tenants_[tenant].SetLimits(limits, now);
+    }
+    bool enabled = pool_limits_.IsLimited() || default_limits_.IsLimited();
+    for (auto &it : tenant_limits_) {
+      enabled |= it.second.IsLimited();
+    }
+    enabled_ = enabled;
+  }
+
+  /** Admit and charge an operation, unless it must wait for tokens */
+  bool TryAdmit(u32 tenant, size_t size) {
+    if (!enabled_) {
+      return true;
+    }
+    hshm::ScopedMutex scoped(lock_, 0);
+    size_t now = GetNsec();
+    QosBucket &bucket = GetTenant(tenant, now);
+    if (!pool_.CanAdmit(now) || !bucket.CanAdmit(now)) {
+      return false;
+    }
+    pool_.Charge(size);
+    bucket.Charge(size);
+    return true;
+  }
+
+ private:
+  /** Get the bucket of a tenant, creating it on first use */
+  QosBucket &GetTenant(u32 tenant, size_t now) {
+    auto it = tenants_.find(tenant);
+    if (it != tenants_.end()) {
+      return it->second;
+    }
+    QosBucket &bucket = tenants_[tenant];
+    bucket.SetLimits(default_limits_, now);
+    return bucket;
+  }
+
+  /** Monotonic time in nanoseconds */
+  static size_t GetNsec() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+};
+
+}  // namespace chi
+
+#endif  // CHIMAERA_INCLUDE_CHIMAERA_IO_TOKEN_BUCKET_H_
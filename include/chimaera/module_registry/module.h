@@ -13,6 +13,8 @@
 #ifndef CHI_INCLUDE_CHI_TASK_TASK_H_
 #define CHI_INCLUDE_CHI_TASK_TASK_H_
 
+#include <type_traits>
+
 #include "chimaera/chimaera_types.h"
 #include "chimaera/network/serialize_defn.h"
 #include "module_queue.h"
@@ -26,6 +28,25 @@ class Module;
 /** Represents a Module in action */
 typedef Module Container;
 
+/** Run a method of a task (table-driven dispatch) */
+typedef void (*RunMethod_t)(Container *exec, Task *task, RunContext &rctx);
+/** Monitor a method of a task (table-driven dispatch) */
+typedef void (*MonitorMethod_t)(Container *exec, MonitorModeId mode,
+                                Task *task, RunContext &rctx);
+/** Delete a task (table-driven dispatch) */
+typedef void (*DelMethod_t)(const hipc::MemContext &mctx, Task *task);
+
+/**
+ * Per-module dispatch tables indexed by MethodId.
+ * Generated in the lib_exec of each module and registered by CHI_TASK_CC.
+ * */
+struct MethodTable {
+  const RunMethod_t *run_ = nullptr;
+  const MonitorMethod_t *monitor_ = nullptr;
+  const DelMethod_t *del_ = nullptr;
+  u32 count_ = 0;
+};
+
 /**
  * Represents a custom operation to perform.
  * Tasks are independent of Hermes.
@@ -42,12 +63,26 @@ public:
   std::vector<std::shared_ptr<LaneGroup>>
       lane_groups_; /**< The lanes of a pool */
   bool is_created_ = false;
+  MethodTable methods_; /**< Dispatch tables registered by CHI_TASK_CC.
+                            Never copied: they belong to the concrete class */
+  hipc::atomic<hshm::min_u64> inflight_; /**< Routed tasks not yet ended */
+  hipc::atomic<hshm::min_u64>
+      work_inflight_; /**< Routed tasks which are not long-running */
+  std::atomic<bool> retiring_{false}; /**< Draining for a live upgrade */
+  std::atomic<Module *> next_version_{
+      nullptr}; /**< Replacement once the upgrade has moved the state */
+  std::atomic<Task *> drain_waiter_{nullptr}; /**< Upgrade draining this */
+  hipc::atomic<hshm::min_u64>
+      flush_inflight_[2]; /**< Flushable tasks routed in each flush epoch */
+  hipc::atomic<hshm::min_u32> flush_epoch_; /**< The current flush epoch */
+  std::atomic<Task *> flush_waiter_; /**< Flush blocked on this container */
 
   /** Default constructor */
-  Module() : pool_id_(PoolId::GetNull()) {}
+  Module() : pool_id_(PoolId::GetNull()) { InitInFlight(); }
 
   /** Copy constructor */
   Module(const Module &other) : pool_id_(other.pool_id_) {
+    InitInFlight();
     name_ = other.name_;
     container_id_ = other.container_id_;
     is_created_ = other.is_created_;
@@ -56,6 +91,7 @@ public:
 
   /** Move constructor */
   Module(Module &&other) noexcept : pool_id_(std::move(other.pool_id_)) {
+    InitInFlight();
     name_ = other.name_;
     container_id_ = other.container_id_;
     is_created_ = other.is_created_;
@@ -138,6 +174,114 @@ public:
     }
   }
 
+  /** Zero the in-flight counters */
+  void InitInFlight() {
+    inflight_ = 0;
+    work_inflight_ = 0;
+    flush_inflight_[0] = 0;
+    flush_inflight_[1] = 0;
+    flush_epoch_ = 0;
+    flush_waiter_ = nullptr;
+  }
+
+  /**
+   * Count a task routed to this container.
+   * Long-running and flush tasks never hold up a flush.
+   * */
+  HSHM_INLINE void BeginInFlight(Task *task) {
+    inflight_ += 1;
+    task->SetInFlight();
+    if (!task->IsLongRunning()) {
+      work_inflight_ += 1;
+    }
+    if (!task->IsLongRunning() && !task->IsFlush()) {
+      u32 epoch = flush_epoch_.load() & 1;
+      flush_inflight_[epoch] += 1;
+      task->rctx_.flush_epoch_ = (int)epoch;
+    }
+  }
+
+  /**
+   * Count a task routed to this container, unless the container is being
+   * drained for an upgrade. Only subtasks of tasks already running here
+   * are let in while it drains, since their parents cannot end without
+   * them. The upgrade sets retiring_ before it waits for the counters, so
+   * either it sees this task counted or this sees retiring_.
+   * */
+  HSHM_INLINE bool TryBeginInFlight(Task *task) {
+    BeginInFlight(task);
+    if (retiring_.load() && !IsSubtaskOfInFlight(task)) {
+      EndInFlight(task);
+      return false;
+    }
+    return true;
+  }
+
+  /** Whether \a task was spawned by a task in flight on this container */
+  HSHM_INLINE bool IsSubtaskOfInFlight(Task *task) {
+    if (!task->ShouldSignalUnblock()) {
+      return false;
+    }
+    Task *parent = task->rctx_.pending_to_;
+    return parent && parent->IsInFlight() && parent->rctx_.exec_ == this;
+  }
+
+  /** Uncount a task routed to this container */
+  HSHM_INLINE void EndInFlight(Task *task) {
+    u64 inflight = inflight_.fetch_sub(1) - 1;
+    task->UnsetInFlight();
+    u64 work_inflight = 1;
+    if (!task->IsLongRunning()) {
+      work_inflight = work_inflight_.fetch_sub(1) - 1;
+    }
+    int epoch = task->rctx_.flush_epoch_;
+    if (epoch >= 0) {
+      task->rctx_.flush_epoch_ = -1;
+      if (flush_inflight_[epoch].fetch_sub(1) == 1) {
+        SignalFlushWaiter();
+      }
+    }
+    if ((inflight == 0 || work_inflight == 0) && retiring_.load()) {
+      SignalDrainWaiter();
+    }
+  }
+
+  /**
+   * Move a long-running task from \a old to this container between two
+   * of its runs. The task is counted here before it is uncounted on
+   * \a old, which is freed once drained.
+   * */
+  HSHM_INLINE void MigrateInFlight(Module *old, Task *task) {
+    int old_epoch = task->rctx_.flush_epoch_;
+    BeginInFlight(task);
+    int new_epoch = task->rctx_.flush_epoch_;
+    task->rctx_.flush_epoch_ = old_epoch;
+    old->EndInFlight(task);
+    task->rctx_.flush_epoch_ = new_epoch;
+    task->SetInFlight();
+  }
+
+  /** Get number of routed tasks which have not ended */
+  size_t GetNumInFlightTasks() { return inflight_.load(); }
+
+  /** Get number of routed tasks which are not long-running */
+  size_t GetNumInFlightWork() { return work_inflight_.load(); }
+
+  /**
+   * Begin a new flush epoch. Returns the previous epoch, which only
+   * contains the tasks routed before this call.
+   * */
+  u32 BeginFlushEpoch() { return flush_epoch_.fetch_add(1) & 1; }
+
+  /** Get number of flushable tasks routed during \a epoch */
+  size_t GetNumFlushing(u32 epoch) { return flush_inflight_[epoch].load(); }
+
+  /** Wake the flush waiting on this container, if any */
+  void SignalFlushWaiter();
+
+  /** Wake the upgrade draining this container, if any */
+  void SignalDrainWaiter();
+
   /** Get number of active tasks */
   size_t GetNumActiveTasks() {
     size_t num_active = 0;
@@ -149,6 +293,35 @@ public:
     return num_active;
   }
 
+  /** Run a method through the dispatch table */
+  HSHM_INLINE void DispatchRun(u32 method, Task *task, RunContext &rctx) {
+    if (method < methods_.count_ && methods_.run_[method]) {
+      methods_.run_[method](this, task, rctx);
+    } else {
+      Run(method, task, rctx);
+    }
+  }
+
+  /** Monitor a method through the dispatch table */
+  HSHM_INLINE void DispatchMonitor(MonitorModeId mode, u32 method, Task *task,
+                                   RunContext &rctx) {
+    if (method < methods_.count_ && methods_.monitor_[method]) {
+      methods_.monitor_[method](this, mode, task, rctx);
+    } else {
+      Monitor(mode, method, task, rctx);
+    }
+  }
+
+  /** Delete a task through the dispatch table */
+  HSHM_INLINE void DispatchDel(const hipc::MemContext &mctx, u32 method,
+                               Task *task) {
+    if (method < methods_.count_ && methods_.del_[method]) {
+      methods_.del_[method](mctx, task);
+    } else {
+      Del(mctx, method, task);
+    }
+  }
+
   /** Virtual destructor */
   HSHM_DLL virtual ~Module() = default;
 
@@ -190,6 +363,24 @@ public:
   HSHM_DLL virtual void LoadEnd(u32 method, BinaryInputArchive<false> &ar,
                                 Task *task) = 0;
 };
+
+/** Whether a module's lib_exec generates GetMethodTable() */
+template <typename T, typename = void>
+struct HasMethodTable : std::false_type {};
+template <typename T>
+struct HasMethodTable<T, std::void_t<decltype(T::GetMethodTable())>>
+    : std::true_type {};
+
+/**
+ * Register the dispatch tables of a module. Modules generated before
+ * GetMethodTable existed keep dispatching through the virtual switches.
+ * */
+template <typename T>
+void RegisterMethodTable(Container *exec) {
+  if constexpr (HasMethodTable<T>::value) {
+    exec->methods_ = T::GetMethodTable();
+  }
+}
 #endif // CHIMAERA_RUNTIME
 
 /** Represents the Module client-side */
@@ -261,12 +452,14 @@ typedef const char *(*get_module_name_t)(void);
                              const char *pool_name) {                          \
     chi::Container *exec =                                                     \
         reinterpret_cast<chi::Container *>(new TYPE_UNWRAP(TRAIT_CLASS)());    \
+    chi::RegisterMethodTable<TYPE_UNWRAP(TRAIT_CLASS)>(exec);                  \
     return exec;                                                               \
   }                                                                            \
   HSHM_DLL void *new_state(const chi::PoolId *pool_id,                         \
                            const char *pool_name) {                            \
     chi::Container *exec =                                                     \
         reinterpret_cast<chi::Container *>(new TYPE_UNWRAP(TRAIT_CLASS)());    \
+    chi::RegisterMethodTable<TYPE_UNWRAP(TRAIT_CLASS)>(exec);                  \
     exec->Init(*pool_id, pool_name);                                           \
     return exec;                                                               \
   }                                                                            \
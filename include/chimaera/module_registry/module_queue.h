@@ -13,6 +13,9 @@ namespace chi {
 
 /** Local runtime lanes. These are NOT used for interprocess communication. */
 class Lane {
+public:
+  CLS_CONST WorkerId kNoMigration = (WorkerId)-1;
+
 public:
   LaneId lane_id_;
   TaskPrio prio_;
@@ -25,6 +28,7 @@ public:
   chi::ext_ring_buffer<TaskPointer> active_tasks_;
   // chi::mpsc_queue<TaskPointer> active_tasks_;
   hipc::atomic<hshm::min_u64> count_;
+  std::atomic<WorkerId> migrate_to_; /**< Worker requested by the scheduler */
 
 public:
   /** Default constructor */
@@ -55,6 +59,16 @@ public:
   void SetPlugged() { plug_count_ += 1; }
 
   void UnsetPlugged() { plug_count_ -= 1; }
+
+  /**
+   * Ask the worker polling this lane to hand it to \a worker_id.
+   * The handoff happens on the owning worker, since only it may
+   * push to or pop from the lane.
+   * */
+  void RequestMigration(WorkerId worker_id) { migrate_to_ = worker_id; }
+
+  /** Whether a migration was requested */
+  bool IsMigrating() { return migrate_to_.load() != kNoMigration; }
 };
 
 /** A group of runtime lanes */
@@ -17,10 +17,13 @@
 
 #include <cstdlib>
 #include <filesystem>
+#include <list>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 
+#include <yaml-cpp/yaml.h>
+
 #include "chimaera/config/config_server.h"
 #include "module.h"
 // #include "chimaera_admin/chimaera_admin_client.h"
@@ -77,9 +80,16 @@ struct ModuleInfo {
   }
 };
 
+/** The previous version of a module after a live upgrade */
+struct RetiredModule {
+  ModuleInfo module_; /**< Keeps the old code loaded until it is freed */
+  std::vector<Container *> containers_; /**< Containers replaced */
+};
+
 struct PoolInfo {
   ModuleInfo *module_;
   std::string lib_name_;
+  std::string pool_name_;
   std::unordered_map<ContainerId, Container *> containers_;
 };
 
@@ -92,6 +102,10 @@ public:
   NodeId node_id_;
   /** The dirs to search for modules */
   std::vector<std::string> lib_dirs_;
+  /** Map of a module name to its path from the module manifest */
+  std::unordered_map<std::string, std::string> lib_manifest_;
+  /** Map of a module name to its candidate paths (in lib_dirs_ order) */
+  std::unordered_map<std::string, std::vector<std::string>> lib_index_;
   /** Map of a semantic lib name to lib info */
   std::unordered_map<std::string, ModuleInfo> libs_;
   /** Map of a semantic exec name to exec id */
@@ -105,7 +119,9 @@ public:
 
 public:
   /** Default constructor */
-  ModuleRegistry() { lock_.Init(); }
+  ModuleRegistry() : upgrade_lock_("module_registry.upgrade_lock") {
+    lock_.Init();
+  }
 
   /** Initialize the Task Registry */
   void ServerInit(ServerConfig *config, NodeId node_id,
@@ -135,6 +151,12 @@ public:
       lib_dirs_.emplace_back(lib_dir);
     }
 
+    // Resolve module paths once instead of probing per module
+    if (!config->module_manifest_.empty()) {
+      LoadModuleManifest(config->module_manifest_);
+    }
+    IndexLibDirs();
+
     // Find each lib in LD_LIBRARY_PATH
     for (const std::string &lib_name : config->modules_) {
       if (!RegisterModule(lib_name)) {
@@ -153,22 +175,117 @@ public:
     return "";
   }
 
+  /**
+   * Load a YAML manifest mapping module names to absolute paths.
+   * Modules in the manifest are never searched for in lib_dirs_.
+   * */
+  void LoadModuleManifest(const std::string &manifest_path) {
+    YAML::Node manifest;
+    try {
+      manifest = YAML::LoadFile(manifest_path);
+    } catch (std::exception &e) {
+      HELOG(kError, "Could not load the module manifest {}: {}", manifest_path,
+            e.what());
+      return;
+    }
+    for (auto it = manifest.begin(); it != manifest.end(); ++it) {
+      std::string lib_name = it->first.as<std::string>();
+      std::string lib_path =
+          hshm::ConfigParse::ExpandPath(it->second.as<std::string>());
+      lib_manifest_[lib_name] = lib_path;
+    }
+    HILOG(kInfo, "Loaded {} modules from the manifest {}", lib_manifest_.size(),
+          manifest_path);
+  }
+
+  /**
+   * Scan each of lib_dirs_ once and index the libraries in them by module
+   * name. A name can match several files in a directory (e.g., the GPU and
+   * host variants), so the file which FindMatchingPathInDirs would have
+   * probed first is kept for each directory.
+   * */
+  void IndexLibDirs() {
+    const std::vector<std::string> &variants = GetLibVariants();
+    const std::vector<std::string> &prefixes = GetLibPrefixes();
+    const std::vector<std::string> &suffixes = GetLibSuffixes();
+    const std::vector<std::string> &extensions = GetLibExtensions();
+    lib_index_.clear();
+    for (const std::string &lib_dir : lib_dirs_) {
+      std::error_code ec;
+      stdfs::directory_iterator dir_it(lib_dir, ec);
+      if (ec) {
+        continue;
+      }
+      // Lowest search rank per module in this directory
+      std::unordered_map<std::string, std::pair<size_t, std::string>> found;
+      for (const stdfs::directory_entry &entry : dir_it) {
+        std::string file_name = entry.path().filename().string();
+        for (size_t e = 0; e < extensions.size(); ++e) {
+          std::string stem;
+          if (!StripSuffix(file_name, extensions[e], stem)) {
+            continue;
+          }
+          for (size_t v = 0; v < variants.size(); ++v) {
+            for (size_t p = 0; p < prefixes.size(); ++p) {
+              for (size_t x = 0; x < suffixes.size(); ++x) {
+                std::string lib_name;
+                if (!StripPrefix(stem, prefixes[p], lib_name) ||
+                    !StripSuffix(lib_name, variants[v] + suffixes[x],
+                                 lib_name) ||
+                    lib_name.empty()) {
+                  continue;
+                }
+                size_t rank =
+                    ((v * prefixes.size() + p) * suffixes.size() + x) *
+                        extensions.size() +
+                    e;
+                auto it = found.find(lib_name);
+                if (it == found.end() || rank < it->second.first) {
+                  found[lib_name] = {rank, entry.path().string()};
+                }
+              }
+            }
+          }
+        }
+      }
+      for (auto &[lib_name, match] : found) {
+        lib_index_[lib_name].emplace_back(match.second);
+      }
+    }
+    HILOG(kDebug, "Indexed {} modules in {} library directories",
+          lib_index_.size(), lib_dirs_.size());
+  }
+
   /**
     Check if any path matches. It checks for GPU variants first, since the
     runtime supports GPU if enabled. */
   std::vector<std::string> FindMatchingPathInDirs(const std::string &lib_name) {
-    std::vector<std::string> variants = {"_gpu", "_host", ""};
-    std::vector<std::string> prefixes = {"", "lib", "libchimaera_"};
-    std::vector<std::string> suffixes = {"", "_runtime"};
-    std::vector<std::string> extensions = {".so", ".dll"};
+    auto manifest_it = lib_manifest_.find(lib_name);
+    if (manifest_it != lib_manifest_.end()) {
+      return {manifest_it->second};
+    }
+    auto index_it = lib_index_.find(lib_name);
+    if (index_it != lib_index_.end()) {
+      return index_it->second;
+    }
+    // The library may have been installed after the index was built
+    std::vector<std::string> concrete_libs = ProbeLibDirs(lib_name);
+    if (!concrete_libs.empty()) {
+      lib_index_[lib_name] = concrete_libs;
+    }
+    return concrete_libs;
+  }
+
+  /** Probe every candidate file name for the library in each lib dir */
+  std::vector<std::string> ProbeLibDirs(const std::string &lib_name) {
     std::vector<std::string> concrete_libs;
     for (const std::string &lib_dir : lib_dirs_) {
       // Determine if this directory contains the library
       std::vector<std::string> potential_paths;
-      for (const std::string &variant : variants) {
-        for (const std::string &prefix : prefixes) {
-          for (const std::string &suffix : suffixes) {
-            for (const std::string &extension : extensions) {
+      for (const std::string &variant : GetLibVariants()) {
+        for (const std::string &prefix : GetLibPrefixes()) {
+          for (const std::string &suffix : GetLibSuffixes()) {
+            for (const std::string &extension : GetLibExtensions()) {
               potential_paths.emplace_back(hshm::Formatter::format(
                   "{}/{}{}{}{}{}", lib_dir, prefix, lib_name, variant, suffix,
                   extension));
@@ -185,6 +302,52 @@ public:
     return concrete_libs;
   }
 
+  /** Library name variants, in search order */
+  static const std::vector<std::string> &GetLibVariants() {
+    static const std::vector<std::string> variants = {"_gpu", "_host", ""};
+    return variants;
+  }
+
+  /** Library name prefixes, in search order */
+  static const std::vector<std::string> &GetLibPrefixes() {
+    static const std::vector<std::string> prefixes = {"", "lib",
+                                                      "libchimaera_"};
+    return prefixes;
+  }
+
+  /** Library name suffixes, in search order */
+  static const std::vector<std::string> &GetLibSuffixes() {
+    static const std::vector<std::string> suffixes = {"", "_runtime"};
+    return suffixes;
+  }
+
+  /** Library file extensions, in search order */
+  static const std::vector<std::string> &GetLibExtensions() {
+    static const std::vector<std::string> extensions = {".so", ".dll"};
+    return extensions;
+  }
+
+  /** Remove \a prefix from \a str, if present */
+  static bool StripPrefix(const std::string &str, const std::string &prefix,
+                          std::string &out) {
+    if (str.size() < prefix.size() || str.compare(0, prefix.size(), prefix)) {
+      return false;
+    }
+    out = str.substr(prefix.size());
+    return true;
+  }
+
+  /** Remove \a suffix from \a str, if present */
+  static bool StripSuffix(const std::string &str, const std::string &suffix,
+                          std::string &out) {
+    if (str.size() < suffix.size() ||
+        str.compare(str.size() - suffix.size(), suffix.size(), suffix)) {
+      return false;
+    }
+    out = str.substr(0, str.size() - suffix.size());
+    return true;
+  }
+
   /** Load a module at path */
   bool LoadModuleAtPath(const std::string &lib_name,
                         const std::string &lib_path, ModuleInfo &info) {
@@ -308,6 +471,59 @@ public:
     delete old;
   }
 
+  /**
+   * Swap in the containers of an upgraded module.
+   * The old containers must already be drained and their state moved to
+   * \a new_containers. Newly-routed tasks go to the new containers, and
+   * long-running tasks follow them through next_version_ at their next
+   * run. The old containers and library are returned in \a retired.
+   * */
+  bool SwapModule(ModuleInfo &info,
+                  const std::vector<Container *> &new_containers,
+                  RetiredModule &retired) {
+    ScopedMutex lock(lock_, 0);
+    std::string module_name = info.get_module_name();
+    auto it = libs_.find(module_name);
+    if (it == libs_.end()) {
+      HELOG(kError, "Could not find the module: {}", module_name);
+      return false;
+    }
+    retired.module_ = std::move(it->second);
+    it->second = std::move(info);
+    for (Container *new_container : new_containers) {
+      auto pool_it = pools_.find(new_container->pool_id_);
+      if (pool_it == pools_.end()) {
+        HELOG(kError, "Could not find the pool: {}", new_container->pool_id_);
+        continue;
+      }
+      Container *&exec =
+          pool_it->second.containers_[new_container->container_id_];
+      Container *old = exec;
+      exec = new_container;
+      if (old) {
+        old->next_version_.store(new_container, std::memory_order_release);
+        retired.containers_.emplace_back(old);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Free the containers of a retired module and unload its library.
+   * No task or router may reference the old containers or the old static
+   * container anymore.
+   * */
+  void DestroyRetiredModule(RetiredModule &retired) {
+    for (Container *old : retired.containers_) {
+      delete old;
+    }
+    retired.containers_.clear();
+    delete retired.module_.static_state_;
+    retired.module_.static_state_ = nullptr;
+    // Destroying the ModuleInfo dlcloses the library
+    ModuleInfo unloaded(std::move(retired.module_));
+  }
+
   /** Get or create a pool's ID */
   PoolId GetOrCreatePoolId(const std::string &pool_name) {
     ScopedMutex lock(lock_, 0);
@@ -386,6 +602,16 @@ public:
     return it->second.lib_name_;
   }
 
+  /** Get pool name from pool */
+  std::string GetPoolName(const PoolId &pool_id) {
+    ScopedMutex lock(lock_, 0);
+    auto it = pools_.find(pool_id);
+    if (it == pools_.end()) {
+      return "";
+    }
+    return it->second.pool_name_;
+  }
+
   /** Get a pool instance */
   Container *GetContainer(const PoolId &pool_id,
                           const ContainerId &container_id) {
@@ -421,9 +647,8 @@ public:
       return;
     }
     PoolInfo &pool = it->second;
-    std::string pool_name = pool.containers_[0]->name_;
     // TODO(llogan): Iterate over shared_state + states and destroy them
-    pool_ids_.erase(pool_name);
+    pool_ids_.erase(pool.pool_name_);
     pools_.erase(it);
   }
 
@@ -442,6 +667,36 @@ public:
     return containers;
   }
 
+  /** Get all ChiContainers of a pool on this node */
+  std::vector<Container *> GetPoolContainers(const PoolId &pool_id) {
+    ScopedMutex lock(lock_, 0);
+    std::vector<Container *> containers;
+    auto it = pools_.find(pool_id);
+    if (it == pools_.end()) {
+      return containers;
+    }
+    for (auto &kv : it->second.containers_) {
+      if (kv.second) {
+        containers.emplace_back(kv.second);
+      }
+    }
+    return containers;
+  }
+
+  /** Get all ChiContainers on this node */
+  std::vector<Container *> GetAllContainers() {
+    ScopedMutex lock(lock_, 0);
+    std::vector<Container *> containers;
+    for (auto &kv : pools_) {
+      for (auto &kv2 : kv.second.containers_) {
+        if (kv2.second) {
+          containers.emplace_back(kv2.second);
+        }
+      }
+    }
+    return containers;
+  }
+
   /** Plug Module */
   void PlugModule(const std::string &lib_name) {
     ScopedMutex lock(lock_, 0);
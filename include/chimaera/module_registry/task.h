@@ -79,6 +79,12 @@ typedef FullPtr<Task> TaskPointer;
 #define TASK_REMOTE BIT_OPT(chi::IntFlag, 22)
 /** This task has been scheduled to a lane (deprecated) */
 #define TASK_IS_ROUTED BIT_OPT(chi::IntFlag, 23)
+/** This task is counted in the in-flight tasks of its container */
+#define TASK_IN_FLIGHT BIT_OPT(chi::IntFlag, 24)
+/** This task was not admitted because its pool was at its limit */
+#define TASK_REJECTED BIT_OPT(chi::IntFlag, 25)
+/** Passed to Wait: return a rejected task instead of sending it again */
+#define TASK_KEEP_REJECTED BIT_OPT(chi::IntFlag, 26)
 /** This task is apart of remote debugging */
 #define TASK_REMOTE_DEBUG_MARK BIT_OPT(chi::IntFlag, 31)
 
@@ -262,6 +268,17 @@ public:
   TASK_FLAG_T CMPGRP = FLAGS & TF_CMPGRP;
 };
 
+/**
+ * Whether a task names the object it touches (a key or blob) with
+ * GetLaneKey(), for LanePolicy::kKey
+ * */
+template <typename T, typename = void>
+struct HasLaneKey : std::false_type {};
+template <typename T>
+struct HasLaneKey<
+    T, std::void_t<decltype(std::declval<const T &>().GetLaneKey())>>
+    : std::true_type {};
+
 /** Prioritization of tasks */
 class TaskPrioOpt {
 public:
@@ -298,6 +315,10 @@ struct RunContext {
   size_t ret_task_addr_;
   NodeId ret_node_;
   hipc::atomic<int> block_count_ = 0;
+  int flush_epoch_ = -1; /**< Flush epoch the task was counted in */
+  int admit_slot_ = -1;  /**< Admission slot of the task's pool */
+  int client_slot_ = -1; /**< Admission slot of the task's client */
+  u32 lane_key_ = 0;     /**< Hash of the object the task touches */
   ContainerId route_container_id_;
   chi::Lane *route_lane_;
   Load load_;
@@ -349,6 +370,18 @@ public:
   HSHM_INLINE_CROSS_FUN
   bool IsComplete() const { return task_flags_.Any(TASK_COMPLETE); }
 
+  /** Set task as rejected by admission control */
+  HSHM_INLINE_CROSS_FUN
+  void SetRejected() { task_flags_.SetBits(TASK_REJECTED); }
+
+  /** Check if task was rejected by admission control */
+  HSHM_INLINE_CROSS_FUN
+  bool IsRejected() const { return task_flags_.Any(TASK_REJECTED); }
+
+  /** Unset task as rejected by admission control */
+  HSHM_INLINE_CROSS_FUN
+  void UnsetRejected() { task_flags_.UnsetBits(TASK_REJECTED); }
+
   /** Unset task as complete */
   HSHM_INLINE_CROSS_FUN
   void UnsetComplete() {
@@ -509,6 +542,18 @@ public:
   HSHM_INLINE_CROSS_FUN
   void UnsetRouted() { rctx_.run_flags_.UnsetBits(TASK_IS_ROUTED); }
 
+  /** Set this task as counted by its container */
+  HSHM_INLINE_CROSS_FUN
+  void SetInFlight() { rctx_.run_flags_.SetBits(TASK_IN_FLIGHT); }
+
+  /** Check if task is counted by its container */
+  HSHM_INLINE_CROSS_FUN
+  bool IsInFlight() const { return rctx_.run_flags_.Any(TASK_IN_FLIGHT); }
+
+  /** Unset this task as counted by its container */
+  HSHM_INLINE_CROSS_FUN
+  void UnsetInFlight() { rctx_.run_flags_.UnsetBits(TASK_IN_FLIGHT); }
+
   /** Set this task as started */
   HSHM_INLINE_CROSS_FUN
   void SetStarted() { rctx_.run_flags_.SetBits(TASK_HAS_STARTED); }
@@ -684,7 +729,11 @@ public:
 #endif
   }
 
-  /** Wait for tasks to complete (host) */
+  /**
+   * Wait for tasks to complete (host). On a client, a task that admission
+   * control rejected is sent again and waited on, blocking until its pool
+   * admits it. Pass TASK_KEEP_REJECTED to return the rejected task instead.
+   * */
   void WaitHost(chi::IntFlag flags = TASK_COMPLETE);
 
   /** Spin wait */
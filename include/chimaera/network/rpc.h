@@ -115,7 +115,7 @@ class RpcContext {
    * Add a set of subdomains to the domain
    * */
   void UpdateDomains(std::vector<UpdateDomainInfo> &ops) {
-    ScopedRwWriteLock(domain_map_lock_, 0);
+    ScopedRwWriteLock lock(domain_map_lock_, 0);
     for (UpdateDomainInfo &info : ops) {
       auto it = domain_map_.find(info.domain_id_);
       if (it == domain_map_.end()) {
@@ -0,0 +1,213 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef CHI_INCLUDE_CHI_QUEUE_MANAGER_ADMISSION_H_
+#define CHI_INCLUDE_CHI_QUEUE_MANAGER_ADMISSION_H_
+
+#include "chimaera/chimaera_types.h"
+
+#ifdef HSHM_IS_HOST
+#include <signal.h>
+
+#include <cerrno>
+#endif
+
+namespace chi {
+
+/**
+ * The number of tasks of a pool in flight, and the most allowed.
+ * A slot is either pool-wide (pid_ == 0) or for one client process.
+ * */
+struct AdmissionSlot {
+  hipc::atomic<hshm::min_u32> state_;    /**< kEmpty, kClaiming or kReady */
+  PoolId pool_;                          /**< The pool limited */
+  u32 pid_;                              /**< The client, or 0 */
+  u32 max_inflight_;                     /**< Most tasks in flight, 0 = any */
+  u32 max_per_client_;                   /**< Quota of each client slot */
+  hipc::atomic<hshm::min_u32> inflight_; /**< Tasks admitted, not ended */
+
+  /** Admit one task, unless the slot is at its limit */
+  HSHM_INLINE_CROSS_FUN
+  bool TryAcquire() {
+    u32 max_inflight = max_inflight_;
+    if (max_inflight == 0) {
+      inflight_ += 1;
+      return true;
+    }
+    u32 count = inflight_.load();
+    do {
+      if (count >= max_inflight) {
+        return false;
+      }
+    } while (!inflight_.compare_exchange_weak(count, count + 1));
+    return true;
+  }
+
+  /** End an admitted task */
+  HSHM_INLINE_CROSS_FUN
+  void Release() { inflight_ -= 1; }
+};
+
+/**
+ * In-flight limits of pools, checked by clients before a task enters
+ * the ingress queues and released by the runtime when the task ends.
+ * Lives in the shared-memory header, so it is a fixed-size
+ * open-addressed table. Slots are never emptied: the slot of a client
+ * that exited with no tasks in flight is reused for a new client.
+ * */
+struct AdmissionTable {
+  CLS_CONST u32 kNumSlots = 1024;
+  CLS_CONST u32 kEmpty = 0;
+  CLS_CONST u32 kClaiming = 1;
+  CLS_CONST u32 kReady = 2;
+  hipc::atomic<hshm::min_u32> num_limited_; /**< Pools with a limit */
+  hipc::atomic<hshm::min_u32> release_seq_; /**< Futex word bumped by Release */
+  hipc::atomic<hshm::min_u32> waiters_;     /**< Clients blocked in Admit */
+  hipc::atomic<hshm::min_u64> rejected_;    /**< Tasks rejected at a limit */
+  hipc::atomic<hshm::min_u64> dropped_;     /**< Rejected fire & forget tasks */
+  AdmissionSlot slots_[kNumSlots];
+
+  /** Clear the table */
+  void Init() {
+    num_limited_ = 0;
+    release_seq_ = 0;
+    waiters_ = 0;
+    rejected_ = 0;
+    dropped_ = 0;
+    for (AdmissionSlot &slot : slots_) {
+      slot.state_ = kEmpty;
+      slot.inflight_ = 0;
+    }
+  }
+
+  /** Whether any pool is limited */
+  HSHM_INLINE_CROSS_FUN
+  bool IsEnabled() { return num_limited_.load() > 0; }
+
+  /**
+   * Find the slot of \a pool for client \a pid (0 for the pool-wide slot).
+   * If \a create, a missing slot is created unlimited, reusing the slot
+   * of an exited client if one is passed while probing.
+   * Returns the slot index, or -1.
+   * */
+  HSHM_INLINE_CROSS_FUN
+  int Find(const PoolId &pool, u32 pid, bool create) {
+    u32 start = (u32)(hshm::hash<PoolId>{}(pool) * 31 + pid);
+    while (true) {
+      int reusable = -1;
+      u32 i = 0;
+      for (; i < kNumSlots; ++i) {
+        u32 idx = (start + i) % kNumSlots;
+        AdmissionSlot &slot = slots_[idx];
+        u32 state = slot.state_.load();
+        if (state == kEmpty) {
+          if (!create) {
+            return -1;
+          }
+          if (reusable >= 0) {
+            break;
+          }
+          hshm::min_u32 expected = kEmpty;
+          if (slot.state_.compare_exchange_strong(expected, kClaiming)) {
+            slot.pool_ = pool;
+            slot.pid_ = pid;
+            slot.max_inflight_ = 0;
+            slot.max_per_client_ = 0;
+            slot.inflight_ = 0;
+            slot.state_ = kReady;
+            return (int)idx;
+          }
+          state = slot.state_.load();
+        }
+        while (state == kClaiming) {
+          state = slot.state_.load();
+        }
+        if (slot.pool_ == pool && slot.pid_ == pid) {
+          return (int)idx;
+        }
+        if (create && pid && reusable < 0 && IsReusable(slot)) {
+          reusable = (int)idx;
+        }
+      }
+      if (reusable < 0) {
+        return -1;
+      }
+      if (Reuse(slots_[reusable], pool, pid)) {
+        return reusable;
+      }
+      // Another client took the slot first: probe again, it may be ours
+    }
+  }
+
+  /** Whether \a slot belongs to an exited client with no tasks in flight */
+  HSHM_INLINE_CROSS_FUN
+  static bool IsReusable(AdmissionSlot &slot) {
+#ifdef HSHM_IS_HOST
+    if (slot.pid_ == 0 || slot.inflight_.load() != 0) {
+      return false;
+    }
+    return kill((pid_t)slot.pid_, 0) == -1 && errno == ESRCH;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Give the slot of an exited client to client \a pid of \a pool.
+   * inflight_ is left as is: it is 0, and a racing TryAcquire of the old
+   * owner can only be balanced by its own Release.
+   * */
+  HSHM_INLINE_CROSS_FUN
+  bool Reuse(AdmissionSlot &slot, const PoolId &pool, u32 pid) {
+    hshm::min_u32 expected = kReady;
+    if (!slot.state_.compare_exchange_strong(expected, kClaiming)) {
+      return false;
+    }
+    if (!IsReusable(slot)) {
+      slot.state_ = kReady;
+      return false;
+    }
+    slot.pool_ = pool;
+    slot.pid_ = pid;
+    slot.max_inflight_ = 0;
+    slot.max_per_client_ = 0;
+    slot.state_ = kReady;
+    return true;
+  }
+
+  /** Set the limits of a pool. 0 is unlimited. */
+  void SetLimit(const PoolId &pool, u32 max_inflight, u32 max_per_client) {
+    if (max_inflight == 0 && max_per_client == 0) {
+      return;
+    }
+    int idx = Find(pool, 0, true);
+    if (idx < 0) {
+      HELOG(kWarning, "Admission table is full, pool {} is not limited", pool);
+      return;
+    }
+    AdmissionSlot &slot = slots_[idx];
+    bool was_limited = slot.max_inflight_ || slot.max_per_client_;
+    slot.max_inflight_ = max_inflight;
+    slot.max_per_client_ = max_per_client;
+    if (!was_limited) {
+      num_limited_ += 1;
+    }
+  }
+
+  /** Get a slot */
+  HSHM_INLINE_CROSS_FUN
+  AdmissionSlot &Get(int idx) { return slots_[idx]; }
+};
+
+}  // namespace chi
+
+#endif  // CHI_INCLUDE_CHI_QUEUE_MANAGER_ADMISSION_H_
@@ -147,6 +147,7 @@ public:
   hipc::mpsc_queue<LaneData, CHI_ALLOC_T> queue_;
   QueueId id_;
   i32 worker_id_ = -1;
+  i32 numa_node_ = -1;
 
 public:
   /**====================================
@@ -0,0 +1,83 @@
+#ifndef CHIMAERA_INCLUDE_CHIMAERA_WORK_ORCHESTRATOR_COLOCK_STATS_H_
+#define CHIMAERA_INCLUDE_CHIMAERA_WORK_ORCHESTRATOR_COLOCK_STATS_H_
+
+#include <list>
+#include <string>
+
+#include "chimaera/chimaera_types.h"
+
+namespace chi {
+
+/**
+ * Contention statistics for a single coroutine lock.
+ * Statistics are only collected when the lock is given a name.
+ * */
+class CoLockSite {
+public:
+  std::string name_;
+  hipc::atomic<hshm::min_u64> acquires_;
+  size_t contended_;
+  size_t total_wait_ns_;
+  size_t max_wait_ns_;
+  TaskId max_wait_holder_;
+  hshm::Mutex lock_;
+
+public:
+  /** Constructor. An empty name disables profiling. */
+  explicit CoLockSite(const std::string &name = "");
+
+  /** Copy constructor. Registers a fresh site with the same name. */
+  CoLockSite(const CoLockSite &other);
+
+  /** Destructor */
+  ~CoLockSite();
+
+  /** Name the site, enabling statistics. For locks built in arrays. */
+  void SetName(const std::string &name);
+
+  /** Whether statistics are being collected */
+  HSHM_INLINE bool IsEnabled() const { return !name_.empty(); }
+
+  /** Record an uncontended acquisition */
+  HSHM_INLINE void RecordAcquire() {
+    if (IsEnabled()) {
+      acquires_ += 1;
+    }
+  }
+
+  /** Record an acquisition that waited for \a holder to release the lock */
+  void RecordWait(size_t wait_ns, const TaskId &holder);
+
+  /** Copy the current statistics */
+  void GetStats(CoLockStats &stats);
+
+private:
+  /** Zero all counters */
+  void Reset();
+};
+
+/** Tracks every named coroutine lock in the runtime */
+class CoLockProfiler {
+public:
+  std::list<CoLockSite *> sites_;
+  hshm::Mutex lock_;
+
+public:
+  /** Default constructor */
+  CoLockProfiler() { lock_.Init(); }
+
+  /** Begin tracking a lock site */
+  void Register(CoLockSite *site);
+
+  /** Stop tracking a lock site */
+  void Unregister(CoLockSite *site);
+
+  /** Copy the statistics of all tracked lock sites */
+  void GetStats(chi::ipc::vector<CoLockStats> &stats);
+};
+
+} // namespace chi
+
+#define CHI_COLOCK_PROFILER hshm::Singleton<chi::CoLockProfiler>::GetInstance()
+
+#endif // CHIMAERA_INCLUDE_CHIMAERA_WORK_ORCHESTRATOR_COLOCK_STATS_H_
@@ -8,6 +8,7 @@
 #include <map>
 
 #include "chimaera/module_registry/task.h"
+#include "chimaera/work_orchestrator/colock_stats.h"
 
 namespace chi {
 
@@ -26,9 +27,14 @@ public:
   chi::ext_ring_buffer<TaskId> order_;
   std::unordered_map<TaskId, COMUTEX_QUEUE_T> blocked_map_;
   hshm::Mutex mux_;
+  CoLockSite site_;
 
 public:
-  CoMutex();
+  /** Constructor. Naming the lock enables contention statistics. */
+  explicit CoMutex(const std::string &name = "");
+
+  /** Name a lock after construction, e.g., one of an array */
+  void SetName(const std::string &name) { site_.SetName(name); }
 
   bool TryLock();
 
@@ -6,6 +6,7 @@
 #define CHIMAERA_INCLUDE_CHIMAERA_WORK_ORCHESTRATOR_CORWLOCK_DEFN_H_
 
 #include "chimaera/module_registry/task.h"
+#include "chimaera/work_orchestrator/colock_stats.h"
 
 namespace chi {
 
@@ -26,10 +27,14 @@ public:
   COMUTEX_QUEUE_T reader_set_;
   bool is_read_;
   hshm::Mutex mux_;
+  CoLockSite site_;
 
 public:
-  /** Default constructor */
-  CoRwLock();
+  /** Constructor. Naming the lock enables contention statistics. */
+  explicit CoRwLock(const std::string &name = "");
+
+  /** Name a lock after construction, e.g., one of an array */
+  void SetName(const std::string &name) { site_.SetName(name); }
 
   bool TryReadLock();
 
@@ -40,6 +45,10 @@ public:
   void WriteLock();
 
   void WriteUnlock();
+
+private:
+  /** Yield until the lock is handed to \a task */
+  void YieldWaiting(Task *task, const TaskId &holder);
 };
 
 class ScopedCoRwReadLock {
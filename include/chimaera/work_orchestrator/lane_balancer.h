@@ -0,0 +1,165 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef CHI_INCLUDE_CHI_WORK_ORCHESTRATOR_LANE_BALANCER_H_
+#define CHI_INCLUDE_CHI_WORK_ORCHESTRATOR_LANE_BALANCER_H_
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "chimaera/chimaera_types.h"
+
+namespace chi {
+
+/** The predicted work of a lane, as seen by the lane balancer */
+struct LaneLoadInfo {
+  size_t load_;        /**< Predicted work of the lane */
+  WorkerId worker_id_; /**< The worker currently polling the lane */
+  bool low_latency_;   /**< Whether the lane must stay on dedicated workers */
+};
+
+/** A lane (index into the LaneLoadInfo vector) to move to a worker */
+struct LaneMigration {
+  size_t lane_;
+  WorkerId worker_id_;
+};
+
+/**
+ * Greedily reassigns lanes to workers to balance their predicted work.
+ * Low-latency lanes are balanced across dedicated workers and all other
+ * lanes across overlapped workers. Does not touch the runtime, so it can
+ * be driven by synthetic loads.
+ * */
+class LaneBalancer {
+public:
+  float threshold_;       /**< Required ratio between max and min load */
+  size_t max_migrations_; /**< Max lanes moved per class per round */
+
+public:
+  /** Constructor */
+  explicit LaneBalancer(float threshold = 1.1, size_t max_migrations = 8)
+      : threshold_(threshold), max_migrations_(max_migrations) {}
+
+  /** Compute the migrations for a round of balancing */
+  std::vector<LaneMigration> Balance(const std::vector<LaneLoadInfo> &lanes,
+                                     const std::vector<WorkerId> &dworkers,
+                                     const std::vector<WorkerId> &oworkers) {
+    std::vector<LaneMigration> migrations;
+    BalanceClass(lanes, true, dworkers, migrations);
+    BalanceClass(lanes, false, oworkers, migrations);
+    return migrations;
+  }
+
+private:
+  /** Balance the lanes of one latency class across its workers */
+  void BalanceClass(const std::vector<LaneLoadInfo> &lanes, bool low_latency,
+                    const std::vector<WorkerId> &workers,
+                    std::vector<LaneMigration> &migrations) {
+    if (workers.empty()) {
+      return;
+    }
+    std::unordered_map<WorkerId, size_t> loads;
+    std::unordered_map<WorkerId, std::vector<size_t>> owned;
+    for (WorkerId worker_id : workers) {
+      loads[worker_id] = 0;
+      owned[worker_id];
+    }
+    // Lanes polled by a worker of the wrong class are moved first
+    std::vector<size_t> strays;
+    for (size_t i = 0; i < lanes.size(); ++i) {
+      const LaneLoadInfo &lane = lanes[i];
+      if (lane.low_latency_ != low_latency) {
+        continue;
+      }
+      auto it = loads.find(lane.worker_id_);
+      if (it == loads.end()) {
+        strays.emplace_back(i);
+        continue;
+      }
+      it->second += lane.load_;
+      owned[lane.worker_id_].emplace_back(i);
+    }
+    for (size_t lane_idx : strays) {
+      WorkerId min_worker = GetMinWorker(workers, loads);
+      loads[min_worker] += lanes[lane_idx].load_;
+      owned[min_worker].emplace_back(lane_idx);
+      migrations.emplace_back(LaneMigration{lane_idx, min_worker});
+    }
+    // Move lanes from the most to the least loaded worker
+    for (size_t round = 0; round < max_migrations_; ++round) {
+      WorkerId max_worker = GetMaxWorker(workers, loads);
+      WorkerId min_worker = GetMinWorker(workers, loads);
+      size_t max_load = loads[max_worker];
+      size_t min_load = loads[min_worker];
+      if (max_worker == min_worker || max_load <= min_load * threshold_) {
+        break;
+      }
+      // The largest lane that does not overshoot the gap
+      std::vector<size_t> &max_lanes = owned[max_worker];
+      size_t gap = max_load - min_load;
+      auto best = max_lanes.end();
+      for (auto it = max_lanes.begin(); it != max_lanes.end(); ++it) {
+        size_t load = lanes[*it].load_;
+        if (load == 0 || load >= gap) {
+          continue;
+        }
+        if (best == max_lanes.end() || lanes[*best].load_ < load) {
+          best = it;
+        }
+      }
+      if (best == max_lanes.end()) {
+        break;
+      }
+      size_t lane_idx = *best;
+      max_lanes.erase(best);
+      owned[min_worker].emplace_back(lane_idx);
+      loads[max_worker] -= lanes[lane_idx].load_;
+      loads[min_worker] += lanes[lane_idx].load_;
+      SetMigration(migrations, lane_idx, min_worker);
+    }
+  }
+
+  /** Get the least loaded worker */
+  static WorkerId GetMinWorker(const std::vector<WorkerId> &workers,
+                               std::unordered_map<WorkerId, size_t> &loads) {
+    return *std::min_element(workers.begin(), workers.end(),
+                             [&loads](WorkerId a, WorkerId b) {
+                               return loads[a] < loads[b];
+                             });
+  }
+
+  /** Get the most loaded worker */
+  static WorkerId GetMaxWorker(const std::vector<WorkerId> &workers,
+                               std::unordered_map<WorkerId, size_t> &loads) {
+    return *std::max_element(workers.begin(), workers.end(),
+                             [&loads](WorkerId a, WorkerId b) {
+                               return loads[a] < loads[b];
+                             });
+  }
+
+  /** Record a migration, replacing an earlier one of the same lane */
+  static void SetMigration(std::vector<LaneMigration> &migrations,
+                           size_t lane_idx, WorkerId worker_id) {
+    for (LaneMigration &migration : migrations) {
+      if (migration.lane_ == lane_idx) {
+        migration.worker_id_ = worker_id;
+        return;
+      }
+    }
+    migrations.emplace_back(LaneMigration{lane_idx, worker_id});
+  }
+};
+
+}  // namespace chi
+
+#endif  // CHI_INCLUDE_CHI_WORK_ORCHESTRATOR_LANE_BALANCER_H_
@@ -13,6 +13,8 @@
 #ifndef CHI_INCLUDE_CHI_WORK_ORCHESTRATOR_SCHEDULER_H_
 #define CHI_INCLUDE_CHI_WORK_ORCHESTRATOR_SCHEDULER_H_
 
+#include <atomic>
+
 #include "chimaera/module_registry/task.h"
 
 namespace chi {
@@ -24,6 +26,9 @@ struct SchedulerMethod : public chi::TaskMethod {
 
 /** The task type used for scheduling */
 struct ScheduleTask : public Task, TaskFlags<TF_LOCAL> {
+  std::atomic<bool> stop_{false};       /**< Stop at the next period */
+  std::atomic<size_t> *runs_ = nullptr; /**< Counts the runs of the policy */
+
   /** SHM default constructor */
   HSHM_INLINE explicit ScheduleTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
@@ -32,7 +37,7 @@ struct ScheduleTask : public Task, TaskFlags<TF_LOCAL> {
   /** Emplace constructor */
   HSHM_INLINE explicit ScheduleTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
-      const DomainQuery &dom_query, PoolId &pool_id, size_t period_ms)
+      const PoolId &pool_id, const DomainQuery &dom_query, size_t period_ms)
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
@@ -43,6 +48,25 @@ struct ScheduleTask : public Task, TaskFlags<TF_LOCAL> {
     SetPeriodMs(period_ms);
     dom_query_ = dom_query;
   }
+
+  /** Ask the policy to stop scheduling at its next period boundary */
+  void Stop() { stop_.store(true); }
+
+  /**
+   * Begin a period of the policy's Schedule method. If a stop was
+   * requested, completes the task instead, so a run that is already in
+   * progress is never cut short.
+   * */
+  bool BeginRun() {
+    if (stop_.load()) {
+      SetTriggerComplete();
+      return false;
+    }
+    if (runs_) {
+      runs_->fetch_add(1);
+    }
+    return true;
+  }
 };
 
 }  // namespace chi
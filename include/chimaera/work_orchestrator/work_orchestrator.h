@@ -62,6 +62,13 @@ public:
   /** Unblock a task */
   void SignalUnblock(Task *task, RunContext &rctx);
 
+  /**
+   * Block a task until every worker finished its current iteration, and
+   * with \a drain_ingress, routed the tasks queued in its ingress lanes.
+   * Only one task may wait on the workers at a time.
+   * */
+  void WaitForWorkers(Task *task, bool drain_ingress = false);
+
   /** Create thread pool */
   void ServerInit(ServerConfig *config);
 
@@ -41,6 +41,8 @@ struct IngressEntry {
   ingress::Lane *lane_;
   ingress::LaneGroup *group_;
   ingress::MultiQueue *queue_;
+  size_t popped_ = 0;       /**< Tasks this worker popped from the lane */
+  size_t barrier_tail_ = 0; /**< popped_ when the barrier can be passed */
 
   /** Default constructor */
   HSHM_INLINE
@@ -62,6 +64,8 @@ struct IngressEntry {
     lane_ = other.lane_;
     group_ = other.group_;
     queue_ = other.queue_;
+    popped_ = other.popped_;
+    barrier_tail_ = other.barrier_tail_;
   }
 
   /** Copy assignment */
@@ -73,6 +77,8 @@ struct IngressEntry {
       lane_ = other.lane_;
       group_ = other.group_;
       queue_ = other.queue_;
+      popped_ = other.popped_;
+      barrier_tail_ = other.barrier_tail_;
     }
     return *this;
   }
@@ -85,6 +91,8 @@ struct IngressEntry {
     lane_ = other.lane_;
     group_ = other.group_;
     queue_ = other.queue_;
+    popped_ = other.popped_;
+    barrier_tail_ = other.barrier_tail_;
   }
 
   /** Move assignment */
@@ -96,6 +104,8 @@ struct IngressEntry {
       lane_ = other.lane_;
       group_ = other.group_;
       queue_ = other.queue_;
+      popped_ = other.popped_;
+      barrier_tail_ = other.barrier_tail_;
     }
     return *this;
   }
@@ -200,7 +210,6 @@ public:
 
 class PrivateTaskMultiQueue {
 public:
-  CLS_CONST int FLUSH = 1;
   CLS_CONST int FAIL = 2;
   CLS_CONST int REMAP = 3;
   CLS_CONST int NUM_QUEUES = 4;
@@ -224,8 +233,6 @@ public:
 
   PrivateTaskQueue &GetFail() { return queues_[FAIL]; }
 
-  PrivateTaskQueue &GetFlush() { return queues_[FLUSH]; }
-
   bool push(const TaskPointer &entry);
 
   template <typename TaskT> bool push(const FullPtr<TaskT> &task) {
@@ -250,6 +257,17 @@ private:
   bool PushRemoteTask(RunContext &rctx, const FullPtr<Task> &task);
 };
 
+/**
+ * A point each worker passes between two of its iterations, where it is
+ * not routing a task. The waiter is blocked until every worker passed.
+ * With drain_ingress_, a worker only passes once it has routed every task
+ * its ingress lanes held when it first saw the barrier.
+ * */
+struct WorkerBarrier {
+  Task *waiter_;       /**< The task blocked on the barrier */
+  bool drain_ingress_; /**< Whether to route the ingress lanes first */
+};
+
 class Worker {
 public:
   CLS_CONST WorkerId kNullWorkerId = (WorkerId)-1; /**< Null worker id */
@@ -258,7 +276,7 @@ public:
   hshm::Thread thread_;       /**< The worker thread handle */
   std::atomic<int> pid_;      /**< The worker process id */
   int affinity_;              /**< The worker CPU affinity */
-  u32 numa_node_;             // TODO(llogan): track NUMA affinity
+  int numa_node_;             /**< The NUMA node of affinity_ */
   std::vector<IngressEntry> work_proc_queue_; /**< The set of queues to poll */
   size_t sleep_us_; /**< Time the worker should sleep after a run */
   ibitfield flags_; /**< Worker metadata flags */
@@ -275,6 +293,8 @@ public:
   Task *cur_task_ = nullptr; /** Currently executing task */
   Lane *cur_lane_ = nullptr; /** Currently executing lane */
   size_t iter_count_ = 0;    /** Number of iterations the worker has done */
+  std::atomic<WorkerBarrier *> barrier_{nullptr}; /**< Barrier to pass */
+  bool barrier_armed_ = false; /**< Ingress tails recorded for barrier_ */
   size_t work_done_ = 0;     /** Amount of work in done (seconds) */
   bool do_sampling_ = false; /**< Whether or not to sample */
   size_t monitor_gap_;       /**< Distance between sampling phases */
@@ -329,7 +349,10 @@ public:
   /** Worker entrypoint */
   static void WorkerEntryPoint(void *arg);
 
-  /** Flush the worker's tasks */
+  /** Let the task blocked on barrier_ know this worker passed it */
+  void PassBarrier();
+
+  /** Begin a round of flushing the worker's tasks */
   void BeginFlush(WorkOrchestrator *orch);
 
   /** Check if work has been done */
@@ -356,8 +379,8 @@ public:
   void IngestLane(IngressEntry &lane_info);
 
   /** Poll the set of tasks in the private queue */
-  template <bool FROM_FLUSH>
-  HSHM_INLINE void PollTempQueue(PrivateTaskQueue &queue, bool flushing);
+  HSHM_INLINE
+  void PollTempQueue(PrivateTaskQueue &queue, bool flushing);
 
   /** Poll the set of tasks in the private queue */
   HSHM_INLINE
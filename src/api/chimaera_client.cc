@@ -1,5 +1,15 @@
 #include "chimaera/api/chimaera_client.h"
 
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <memory>
+#include <mutex>
+
 #include "chimaera_admin/chimaera_admin_client.h"
 
 namespace chi {
@@ -48,8 +58,15 @@ void Client::ClientInit(const char *server_config_path,
   std::set_terminate(ExceptionTerminator);
   LoadServerConfig(server_config_path);
   LoadClientConfig(client_config_path);
+  task_cache_depth_ = client_config_->task_cache_depth_;
+  buffer_wait_timeout_ms_ = client_config_->buffer_wait_timeout_ms_;
+  admission_reject_ = client_config_->admission_reject_;
+  lane_policy_ = client_config_->lane_policy_;
   LoadSharedMemory(server);
   CHI_QM->ClientInit(main_alloc_, header_->queue_manager_, header_->node_id_);
+  if (!server) {
+    InitLanes();
+  }
   CreateClientOnHostForGpu();
 }
 
@@ -59,17 +76,17 @@ void Client::LoadSharedMemory(bool server) {
   config::QueueManagerInfo &qm = server_config_->queue_manager_;
   auto mem_mngr = HSHM_MEMORY_MANAGER;
   if (!server) {
-    mem_mngr->AttachBackend(hipc::MemoryBackendType::kPosixShmMmap,
-                            qm.shm_name_);
-    mem_mngr->AttachBackend(hipc::MemoryBackendType::kPosixShmMmap,
-                            qm.data_shm_name_);
-    mem_mngr->AttachBackend(hipc::MemoryBackendType::kPosixShmMmap,
-                            qm.rdata_shm_name_);
+    AttachShmBackend(0, qm.shm_name_, qm.shm_hugepages_);
+    AttachShmBackend(1, qm.data_shm_name_, qm.data_shm_hugepages_);
+    AttachShmBackend(2, qm.rdata_shm_name_, qm.rdata_shm_hugepages_);
   }
   main_alloc_ = mem_mngr->GetAllocator<CHI_MAIN_ALLOC_T>(main_alloc_id_);
   data_alloc_ = mem_mngr->GetAllocator<CHI_DATA_ALLOC_T>(data_alloc_id_);
   rdata_alloc_ = mem_mngr->GetAllocator<CHI_RDATA_ALLOC_T>(rdata_alloc_id_);
   mem_mngr->SetDefaultAllocator(main_alloc_);
+  if (!server) {
+    AdviseHugepages();
+  }
   header_ = main_alloc_->GetCustomHeader<ChiShm>();
   unique_ = &header_->unique_;
   node_id_ = header_->node_id_;
@@ -104,6 +121,235 @@ void Client::LoadSharedMemoryGpu() {
   }
 }
 
+/** Longest sleep between retries, in case a slot frees without a wake */
+static constexpr size_t kMaxAdmitWaitMs = 10;
+
+/** Count a task against the in-flight limits of its pool */
+bool Client::Admit(Task *task, bool reject) {
+  AdmissionTable &table = header_->admission_;
+  int pool_slot = table.Find(task->pool_, 0, false);
+  if (pool_slot < 0) {
+    return true;
+  }
+  AdmissionSlot &pool = table.Get(pool_slot);
+  int client_slot = -1;
+  if (pool.max_per_client_) {
+    client_slot = table.Find(task->pool_, HSHM_SYSTEM_INFO->pid_, true);
+    if (client_slot >= 0) {
+      table.Get(client_slot).max_inflight_ = pool.max_per_client_;
+    }
+  }
+  auto *seq = reinterpret_cast<u32 *>(&table.release_seq_);
+  bool waiting = false;
+  while (true) {
+    u32 cur_seq = table.release_seq_.load();
+    if (client_slot < 0 || table.Get(client_slot).TryAcquire()) {
+      if (pool.TryAcquire()) {
+        break;
+      }
+      if (client_slot >= 0) {
+        table.Get(client_slot).Release();
+      }
+    }
+    if (reject) {
+      table.rejected_ += 1;
+      return false;
+    }
+    if (!waiting) {
+      // Register as a waiter before retrying, so a concurrent release
+      // either makes the retry succeed or bumps the futex word
+      table.waiters_ += 1;
+      waiting = true;
+      continue;
+    }
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = kMaxAdmitWaitMs * 1000000;
+    syscall(SYS_futex, seq, FUTEX_WAIT, cur_seq, &ts, nullptr, 0);
+  }
+  if (waiting) {
+    table.waiters_ -= 1;
+  }
+  task->rctx_.admit_slot_ = pool_slot;
+  task->rctx_.client_slot_ = client_slot;
+  return true;
+}
+
+/** Wake the tasks waiting in Admit */
+void Client::WakeAdmissionWaiters() {
+  AdmissionTable &table = header_->admission_;
+  table.release_seq_ += 1;
+  auto *seq = reinterpret_cast<u32 *>(&table.release_seq_);
+  syscall(SYS_futex, seq, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/** Send a rejected task, blocking until it is admitted */
+void Client::ResubmitRejected(Task *task) {
+  task->UnsetRejected();
+  task->UnsetComplete();
+  Admit(task, false);
+  FullPtr<Task> full(task);
+  chi::ingress::MultiQueue *queue = GetQueue(chi::PROCESS_QUEUE_ID);
+  queue->Emplace(chi::TaskPrioOpt::kLowLatency, SelectLane(task), full.shm_);
+}
+
+/** Tasks put in one ingress lane, on its own cache line */
+struct alignas(64) LaneCount {
+  std::atomic<size_t> count_ = 0;
+};
+
+/** The number of low-latency ingress lanes */
+static u32 num_lanes = 0;
+/** Tasks this process put in each ingress lane */
+static std::unique_ptr<LaneCount[]> lane_counts;
+/** The ingress lanes polled by workers on each NUMA node */
+static std::vector<std::vector<LaneId>> numa_lanes;
+/** The NUMA node of each CPU */
+static std::vector<int> cpu_numa_nodes;
+/** The lane of the next thread to schedule a task, for kSticky */
+static std::atomic<u32> next_sticky_lane = 0;
+/** Maps numa_lanes the first time kNuma is used */
+static std::once_flag numa_lanes_once;
+
+/** Map the ingress lanes to the NUMA nodes of their workers' CPUs */
+static void InitNumaLanes(ingress::LaneGroup *lane_group) {
+  cpu_numa_nodes.resize(HSHM_SYSTEM_INFO->ncpu_);
+  for (int cpu = 0; cpu < HSHM_SYSTEM_INFO->ncpu_; ++cpu) {
+    cpu_numa_nodes[cpu] = ConfigurationManager::GetNumaNode(cpu);
+  }
+  for (LaneId lane_id = 0; lane_id < num_lanes; ++lane_id) {
+    int node = lane_group->GetLane(lane_id).numa_node_;
+    if (node < 0) {
+      continue;
+    }
+    if ((size_t)node >= numa_lanes.size()) {
+      numa_lanes.resize(node + 1);
+    }
+    numa_lanes[node].emplace_back(lane_id);
+  }
+}
+
+/** Count the ingress lanes, and map them to NUMA nodes for kNuma */
+void Client::InitLanes() {
+  ingress::MultiQueue *queue = GetQueue(PROCESS_QUEUE_ID);
+  ingress::LaneGroup &lane_group = queue->GetGroup(TaskPrioOpt::kLowLatency);
+  num_lanes = lane_group.num_lanes_;
+  lane_counts = std::make_unique<LaneCount[]>(num_lanes);
+  // Spread the threads of different processes apart
+  next_sticky_lane = HSHM_SYSTEM_INFO->pid_;
+  if (lane_policy_ == LanePolicy::kNuma) {
+    std::call_once(numa_lanes_once, InitNumaLanes, &lane_group);
+  }
+}
+
+/** Pick the ingress lane of a task according to lane_policy_ */
+u32 Client::SelectLane(Task *task) {
+  u32 lane = hshm::hash<DomainQuery>{}(task->dom_query_);
+  switch (lane_policy_) {
+    case LanePolicy::kHash: {
+      break;
+    }
+    case LanePolicy::kSticky: {
+      static thread_local u32 sticky_lane = next_sticky_lane.fetch_add(1);
+      lane = sticky_lane;
+      break;
+    }
+    case LanePolicy::kNuma: {
+      // The policy may be switched on after InitLanes
+      std::call_once(numa_lanes_once, InitNumaLanes,
+                     &GetQueue(PROCESS_QUEUE_ID)->GetGroup(
+                         TaskPrioOpt::kLowLatency));
+      // The thread may move between calls, so look up its CPU each time
+      int cpu = sched_getcpu();
+      if (cpu < 0 || (size_t)cpu >= cpu_numa_nodes.size()) {
+        break;
+      }
+      size_t node = cpu_numa_nodes[cpu];
+      if (node < numa_lanes.size() && !numa_lanes[node].empty()) {
+        lane = numa_lanes[node][lane % numa_lanes[node].size()];
+      }
+      break;
+    }
+    case LanePolicy::kKey: {
+      // Set by ScheduleTask, so a resubmitted task keeps its lane
+      lane = hshm::hash<PoolId>{}(task->pool_) * 31 + task->rctx_.lane_key_;
+      break;
+    }
+  }
+  if (num_lanes) {
+    lane %= num_lanes;
+    lane_counts[lane].count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return lane;
+}
+
+/** Get the number of tasks this process put in each ingress lane */
+std::vector<size_t> Client::GetLaneStats() {
+  std::vector<size_t> stats(num_lanes);
+  for (u32 lane_id = 0; lane_id < num_lanes; ++lane_id) {
+    stats[lane_id] = lane_counts[lane_id].count_.load();
+  }
+  return stats;
+}
+
+/** Longest sleep between retries, in case space is freed without FreeBuffer */
+static constexpr size_t kMaxBufferWaitMs = 10;
+
+/** Wait on FreeBuffer until a buffer can be allocated */
+FullPtr<char>
+Client::WaitForBuffer(const hipc::CtxAllocator<CHI_DATA_ALLOC_T> &alloc,
+                      size_t size, size_t alignment) {
+  auto start = std::chrono::steady_clock::now();
+  auto *seq = reinterpret_cast<u32 *>(&header_->buffer_free_seq_);
+  FullPtr<char> p(FullPtr<char>::GetNull());
+  bool warned = false;
+  // Register as a waiter before retrying, so a concurrent free either
+  // makes the retry succeed or bumps the futex word
+  header_->buffer_waiters_ += 1;
+  while (true) {
+    u32 cur_seq = header_->buffer_free_seq_.load();
+    p = TryAllocateDataPtr(alloc, size, alignment);
+    if (!p.shm_.IsNull()) {
+      break;
+    }
+    size_t waited_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    if (buffer_wait_timeout_ms_ && waited_ms >= buffer_wait_timeout_ms_) {
+      header_->buffer_timeouts_ += 1;
+      HELOG(kError,
+            "(node {}) Could not allocate {} bytes within {}ms: "
+            "data shm is exhausted",
+            node_id_, size, waited_ms);
+      break;
+    }
+    if (!warned && waited_ms >= 1000) {
+      HILOG(kWarning,
+            "(node {}) Waiting {}ms to allocate {} bytes: "
+            "data shm is exhausted",
+            node_id_, waited_ms, size);
+      warned = true;
+    }
+    size_t wait_ms = kMaxBufferWaitMs;
+    if (buffer_wait_timeout_ms_) {
+      wait_ms = std::min(wait_ms, buffer_wait_timeout_ms_ - waited_ms);
+    }
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = wait_ms * 1000000;
+    syscall(SYS_futex, seq, FUTEX_WAIT, cur_seq, &ts, nullptr, 0);
+  }
+  header_->buffer_waiters_ -= 1;
+  return p;
+}
+
+/** Wake the allocations waiting in WaitForBuffer */
+void Client::WakeBufferWaiters() {
+  header_->buffer_free_seq_ += 1;
+  auto *seq = reinterpret_cast<u32 *>(&header_->buffer_free_seq_);
+  syscall(SYS_futex, seq, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
 HSHM_DEFINE_GLOBAL_CROSS_PTR_VAR_CC(Client, chiClient);
 HSHM_DEFINE_GLOBAL_CROSS_PTR_VAR_CC(QueueManager, chiQueueManager);
 HSHM_DEFINE_GLOBAL_CROSS_PTR_VAR_CC(chi::Admin::Client,
@@ -114,22 +114,22 @@ void Runtime::InitSharedMemory() {
     qm.shm_size_ = hipc::MemoryManager::GetDefaultBackendSize();
   }
   // Create general allocator
-  mem_mngr->CreateBackend<hipc::PosixShmMmap>(hipc::MemoryBackendId::Get(0),
-                                              qm.shm_size_, qm.shm_name_);
+  CreateShmBackend(0, qm.shm_size_, qm.shm_name_, qm.shm_hugepages_);
   main_alloc_ = mem_mngr->CreateAllocator<CHI_MAIN_ALLOC_T>(
       hipc::MemoryBackendId::Get(0), main_alloc_id_, sizeof(ChiShm));
   header_ = main_alloc_->GetCustomHeader<ChiShm>();
   mem_mngr->SetDefaultAllocator(main_alloc_);
   // Create separate data allocator
-  mem_mngr->CreateBackend<hipc::PosixShmMmap>(
-      hipc::MemoryBackendId::Get(1), qm.data_shm_size_, qm.data_shm_name_);
+  CreateShmBackend(1, qm.data_shm_size_, qm.data_shm_name_,
+                   qm.data_shm_hugepages_);
   data_alloc_ = mem_mngr->CreateAllocator<CHI_DATA_ALLOC_T>(
       hipc::MemoryBackendId::Get(1), data_alloc_id_, 0);
   // Create separate runtime data allocator
-  mem_mngr->CreateBackend<hipc::PosixShmMmap>(
-      hipc::MemoryBackendId::Get(2), qm.rdata_shm_size_, qm.rdata_shm_name_);
+  CreateShmBackend(2, qm.rdata_shm_size_, qm.rdata_shm_name_,
+                   qm.rdata_shm_hugepages_);
   rdata_alloc_ = mem_mngr->CreateAllocator<CHI_RDATA_ALLOC_T>(
       hipc::MemoryBackendId::Get(2), rdata_alloc_id_, 0);
+  AdviseHugepages();
 }
 
 /** Initialize shared-memory between daemon and client */
@@ -138,6 +138,11 @@ void Runtime::InitSharedMemoryGpu() {
   auto mem_mngr = HSHM_MEMORY_MANAGER;
   header_->node_id_ = CHI_RPC->node_id_;
   header_->unique_ = 0;
+  header_->buffer_free_seq_ = 0;
+  header_->buffer_waiters_ = 0;
+  header_->buffer_exhausted_ = 0;
+  header_->buffer_timeouts_ = 0;
+  header_->admission_.Init();
   header_->num_nodes_ = server_config_->rpc_.host_names_.size();
 
   // Create per-gpu allocator
@@ -181,6 +186,7 @@ void Runtime::Finalize() {}
 void Runtime::RunDaemon() {
   thallium_.RunDaemon();
   HILOG(kInfo, "(node {}) Daemon is exiting", CHI_CLIENT->node_id_);
+  UnlinkHugetlb();
   exit(0);
 }
 
@@ -13,6 +13,7 @@
 #include "chimaera/config/config_client.h"
 
 #include <hermes_shm/util/config_parse.h>
+#include <hermes_shm/util/logging.h>
 
 #include <filesystem>
 
@@ -23,7 +24,32 @@ namespace stdfs = std::filesystem;
 namespace chi::config {
 
 /** parse the YAML node */
-void ClientConfig::ParseYAML(YAML::Node &yaml_conf) {}
+void ClientConfig::ParseYAML(YAML::Node &yaml_conf) {
+  if (yaml_conf["task_cache_depth"]) {
+    task_cache_depth_ = yaml_conf["task_cache_depth"].as<size_t>();
+  }
+  if (yaml_conf["buffer_wait_timeout_ms"]) {
+    buffer_wait_timeout_ms_ = yaml_conf["buffer_wait_timeout_ms"].as<size_t>();
+  }
+  if (yaml_conf["admission_mode"]) {
+    admission_reject_ = yaml_conf["admission_mode"].as<std::string>() == "reject";
+  }
+  if (yaml_conf["lane_policy"]) {
+    std::string policy = yaml_conf["lane_policy"].as<std::string>();
+    if (policy == "hash") {
+      lane_policy_ = LanePolicy::kHash;
+    } else if (policy == "sticky") {
+      lane_policy_ = LanePolicy::kSticky;
+    } else if (policy == "numa") {
+      lane_policy_ = LanePolicy::kNuma;
+    } else if (policy == "key") {
+      lane_policy_ = LanePolicy::kKey;
+    } else {
+      HELOG(kWarning, "Unknown lane_policy {}, using hash", policy);
+      lane_policy_ = LanePolicy::kHash;
+    }
+  }
+}
 
 /** Load the default configuration */
 void ClientConfig::LoadDefault() {
@@ -83,6 +83,21 @@ void ServerConfig::ParseQueueManager(YAML::Node yaml_conf) {
     queue_manager_.gpu_data_shm_size_ = hshm::ConfigParse::ParseSize(
         yaml_conf["gpu_data_shm_size"].as<std::string>());
   }
+  if (yaml_conf["shm_hugepages"]) {
+    queue_manager_.shm_hugepages_ = yaml_conf["shm_hugepages"].as<bool>();
+  }
+  if (yaml_conf["data_shm_hugepages"]) {
+    queue_manager_.data_shm_hugepages_ =
+        yaml_conf["data_shm_hugepages"].as<bool>();
+  }
+  if (yaml_conf["rdata_shm_hugepages"]) {
+    queue_manager_.rdata_shm_hugepages_ =
+        yaml_conf["rdata_shm_hugepages"].as<bool>();
+  }
+  if (yaml_conf["hugetlbfs_path"]) {
+    queue_manager_.hugetlbfs_path_ = hshm::ConfigParse::ExpandPath(
+        yaml_conf["hugetlbfs_path"].as<std::string>());
+  }
 }
 
 /** parse RPC information from YAML config */
@@ -117,6 +132,22 @@ void ServerConfig::ParseRpcInfo(YAML::Node yaml_conf) {
   }
 }
 
+/** parse the in-flight limits of pools from YAML config */
+void ServerConfig::ParseAdmission(YAML::Node yaml_conf) {
+  admission_.clear();
+  for (YAML::Node pool : yaml_conf) {
+    AdmissionInfo info;
+    if (pool["max_inflight"]) {
+      info.max_inflight_ = pool["max_inflight"].as<u32>();
+    }
+    if (pool["max_inflight_per_client"]) {
+      info.max_inflight_per_client_ =
+          pool["max_inflight_per_client"].as<u32>();
+    }
+    admission_[pool["pool"].as<std::string>()] = info;
+  }
+}
+
 /** parse the YAML node */
 void ServerConfig::ParseYAML(YAML::Node &yaml_conf) {
   if (yaml_conf["work_orchestrator"]) {
@@ -131,6 +162,13 @@ void ServerConfig::ParseYAML(YAML::Node &yaml_conf) {
   if (yaml_conf["module_registry"]) {
     ParseVector<std::string>(yaml_conf["module_registry"], modules_);
   }
+  if (yaml_conf["module_manifest"]) {
+    module_manifest_ = hshm::ConfigParse::ExpandPath(
+        yaml_conf["module_manifest"].as<std::string>());
+  }
+  if (yaml_conf["admission"]) {
+    ParseAdmission(yaml_conf["admission"]);
+  }
 }
 
 /** Load the default configuration */
@@ -10,8 +10,15 @@
  * have access to the file, you may request a copy from help@hdfgroup.org.   *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <execinfo.h>
 #include <malloc.h>
+#include <signal.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
 
 // Dynamically checked to see which are the real APIs and which are intercepted
 bool malloc_intercepted = true;
@@ -25,6 +32,533 @@ using hshm::ipc::Pointer;
 
 namespace chi {
 HSHM_DEFINE_GLOBAL_VAR_CC(chi::MallocApi, chiMallocApi);
+
+/**
+ * Prepended to each allocation routed to shm. Every pointer in the shm
+ * data segment that reaches free() was made by ShmMalloc.
+ * */
+struct ShmMallocHeader {
+  size_t size_;    /**< Bytes allocated, including the header */
+  uint32_t class_; /**< Size class, or kUncached */
+  uint32_t pad_;
+};
+static constexpr uint32_t kUncached = UINT32_MAX;
+/** Max bytes of free shm allocations kept by each thread */
+static constexpr size_t kMaxThreadCacheBytes = 64ull << 20;
+/** Each thread caches at most this fraction of the data segment */
+static constexpr size_t kThreadCacheShare = 64;
+
+/**
+ * Allocation statistics, enabled with CHI_MALLOC_STATS=1.
+ * Everything is preallocated, since it is updated inside malloc.
+ * */
+static constexpr int kHeap = 0;
+static constexpr int kShm = 1;
+/** Allocation sizes are binned by their log2 */
+static constexpr int kNumSizeBins = 48;
+/** Threads past this share the last slot */
+static constexpr int kMaxStatThreads = 256;
+/** The largest outstanding allocations are tracked with their stacks */
+static constexpr int kNumTracked = 32;
+static constexpr size_t kMinTrackedSize = 64 << 10;
+static constexpr int kStackDepth = 16;
+
+/** Counters of one thread, indexed by kHeap or kShm */
+struct MallocThreadStats {
+  std::atomic<long> tid_;
+  std::atomic<size_t> count_[2];
+  std::atomic<size_t> bytes_[2];
+  std::atomic<size_t> free_count_[2];
+  std::atomic<size_t> free_bytes_[2];
+  std::atomic<size_t> bins_[2][kNumSizeBins];
+  /** Bytes of shm held in the thread's ShmThreadCache */
+  std::atomic<size_t> cached_bytes_;
+};
+
+/** An outstanding allocation and where it was made */
+struct TrackedAlloc {
+  void* ptr_;
+  size_t size_;
+  int kind_;
+  int depth_;
+  void* stack_[kStackDepth];
+};
+
+struct MallocStats {
+  MallocThreadStats threads_[kMaxStatThreads];
+  std::atomic<int> num_threads_;
+  /**
+   * Shm allocations that returned null. AllocateBuffer waits for space,
+   * so these are waits which passed the client's buffer_wait_timeout_ms.
+   * */
+  std::atomic<size_t> shm_timeouts_;
+  TrackedAlloc tracked_[kNumTracked];
+  /** Allocations no larger than this are not worth tracking */
+  std::atomic<size_t> tracked_min_;
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+};
+static MallocStats malloc_stats;
+static thread_local MallocThreadStats* thread_stats = nullptr;
+/** Set while recording, so allocations made by backtrace are not counted */
+static thread_local bool in_stats = false;
+
+static MallocThreadStats* GetThreadStats() {
+  if (thread_stats == nullptr) {
+    int id = malloc_stats.num_threads_.fetch_add(1);
+    id = id < kMaxStatThreads ? id : kMaxStatThreads - 1;
+    thread_stats = &malloc_stats.threads_[id];
+    thread_stats->tid_ = syscall(SYS_gettid);
+  }
+  return thread_stats;
+}
+
+static int GetSizeBin(size_t size) {
+  int bin = size ? 63 - __builtin_clzll(size) : 0;
+  return bin < kNumSizeBins ? bin : kNumSizeBins - 1;
+}
+
+static void LockTracked() {
+  while (malloc_stats.lock_.test_and_set(std::memory_order_acquire)) {
+  }
+}
+
+static void UnlockTracked() {
+  malloc_stats.lock_.clear(std::memory_order_release);
+}
+
+/** Replace the smallest tracked allocation, if \a size is larger */
+static void TrackAlloc(void* ptr, size_t size, int kind) {
+  TrackedAlloc alloc;
+  alloc.ptr_ = ptr;
+  alloc.size_ = size;
+  alloc.kind_ = kind;
+  alloc.depth_ = backtrace(alloc.stack_, kStackDepth);
+  LockTracked();
+  TrackedAlloc* min = &malloc_stats.tracked_[0];
+  for (TrackedAlloc& entry : malloc_stats.tracked_) {
+    if (entry.size_ < min->size_) {
+      min = &entry;
+    }
+  }
+  if (size > min->size_) {
+    *min = alloc;
+  }
+  size_t tracked_min = SIZE_MAX;
+  for (TrackedAlloc& entry : malloc_stats.tracked_) {
+    tracked_min = entry.size_ < tracked_min ? entry.size_ : tracked_min;
+  }
+  malloc_stats.tracked_min_ = tracked_min;
+  UnlockTracked();
+}
+
+/** Stop tracking a freed allocation */
+static void UntrackAlloc(void* ptr) {
+  LockTracked();
+  for (TrackedAlloc& entry : malloc_stats.tracked_) {
+    if (entry.ptr_ == ptr) {
+      entry.ptr_ = nullptr;
+      entry.size_ = 0;
+      malloc_stats.tracked_min_ = 0;
+      break;
+    }
+  }
+  UnlockTracked();
+}
+
+/**
+ * Record an allocation of \a size bytes. \a usable is the size actually
+ * reserved, which is also what RecordFree is given.
+ * */
+static void RecordAlloc(void* ptr, size_t size, size_t usable, int kind) {
+  if (in_stats) {
+    return;
+  }
+  if (ptr == nullptr) {
+    if (kind == kShm) {
+      malloc_stats.shm_timeouts_ += 1;
+    }
+    return;
+  }
+  in_stats = true;
+  MallocThreadStats* stats = GetThreadStats();
+  stats->count_[kind].fetch_add(1, std::memory_order_relaxed);
+  stats->bytes_[kind].fetch_add(usable, std::memory_order_relaxed);
+  stats->bins_[kind][GetSizeBin(size)].fetch_add(1, std::memory_order_relaxed);
+  if (usable >= kMinTrackedSize &&
+      usable > malloc_stats.tracked_min_.load(std::memory_order_relaxed)) {
+    TrackAlloc(ptr, usable, kind);
+  }
+  in_stats = false;
+}
+
+static void RecordFree(void* ptr, size_t size, int kind) {
+  if (in_stats || ptr == nullptr) {
+    return;
+  }
+  in_stats = true;
+  MallocThreadStats* stats = GetThreadStats();
+  stats->free_count_[kind].fetch_add(1, std::memory_order_relaxed);
+  stats->free_bytes_[kind].fetch_add(size, std::memory_order_relaxed);
+  if (size >= kMinTrackedSize) {
+    UntrackAlloc(ptr);
+  }
+  in_stats = false;
+}
+
+/**
+ * Formats a line of the report into a fixed buffer and write()s it.
+ * Only async-signal-safe calls are made, so the report can be printed
+ * from the SIGUSR2 handler.
+ * */
+class StatsLine {
+ public:
+  explicit StatsLine(int fd) : fd_(fd), len_(0) {}
+
+  ~StatsLine() {
+    if (len_ > 0) {
+      ssize_t ret = write(fd_, buf_, len_);
+      (void)ret;
+    }
+  }
+
+  /** Append a string, padded with spaces to \a width */
+  StatsLine& Str(const char* str, size_t width = 0) {
+    size_t count = 0;
+    for (; *str; ++str, ++count) {
+      Put(*str);
+    }
+    for (; count < width; ++count) {
+      Put(' ');
+    }
+    return *this;
+  }
+
+  /** Append a number in decimal */
+  StatsLine& Num(size_t num) { return Digits(num, 10); }
+
+  /** Append a pointer in hex */
+  StatsLine& Ptr(const void* ptr) {
+    Str("0x");
+    return Digits(reinterpret_cast<uintptr_t>(ptr), 16);
+  }
+
+ private:
+  void Put(char c) {
+    if (len_ < sizeof(buf_)) {
+      buf_[len_++] = c;
+    }
+  }
+
+  StatsLine& Digits(size_t num, size_t base) {
+    char digits[32];
+    int count = 0;
+    do {
+      digits[count++] = "0123456789abcdef"[num % base];
+      num /= base;
+    } while (num);
+    while (count) {
+      Put(digits[--count]);
+    }
+    return *this;
+  }
+
+  int fd_;
+  size_t len_;
+  char buf_[256];
+};
+
+/**
+ * Print the statistics to \a fd. The tracked table is read without
+ * the lock, since the interrupted thread may hold it.
+ * */
+static void DumpMallocStats(int fd) {
+  static const char* kKinds[2] = {"heap", "shm"};
+  MallocThreadStats total = {};
+  int num_threads = malloc_stats.num_threads_.load();
+  num_threads = num_threads < kMaxStatThreads ? num_threads : kMaxStatThreads;
+  StatsLine(fd)
+      .Str("chimaera_malloc: pid ")
+      .Num(getpid())
+      .Str(", shm capacity ")
+      .Num(CHI_MALLOC->shm_end_ - CHI_MALLOC->shm_begin_)
+      .Str(", threshold ")
+      .Num(CHI_MALLOC->threshold_)
+      .Str(", shm timeouts ")
+      .Num(malloc_stats.shm_timeouts_.load())
+      .Str("\n");
+  for (int i = 0; i < num_threads; ++i) {
+    MallocThreadStats& stats = malloc_stats.threads_[i];
+    StatsLine(fd)
+        .Str("  thread ")
+        .Num(stats.tid_.load())
+        .Str(": cached shm ")
+        .Num(stats.cached_bytes_.load())
+        .Str("\n");
+    total.cached_bytes_ += stats.cached_bytes_.load();
+    for (int kind = kHeap; kind <= kShm; ++kind) {
+      StatsLine(fd)
+          .Str("    ")
+          .Str(kKinds[kind], 4)
+          .Str(" allocs ")
+          .Num(stats.count_[kind].load())
+          .Str(" (")
+          .Num(stats.bytes_[kind].load())
+          .Str(" B), frees ")
+          .Num(stats.free_count_[kind].load())
+          .Str(" (")
+          .Num(stats.free_bytes_[kind].load())
+          .Str(" B)\n");
+      total.count_[kind] += stats.count_[kind].load();
+      total.bytes_[kind] += stats.bytes_[kind].load();
+      total.free_count_[kind] += stats.free_count_[kind].load();
+      total.free_bytes_[kind] += stats.free_bytes_[kind].load();
+      for (int bin = 0; bin < kNumSizeBins; ++bin) {
+        total.bins_[kind][bin] += stats.bins_[kind][bin].load();
+      }
+    }
+  }
+  StatsLine(fd)
+      .Str("  total: cached shm ")
+      .Num(total.cached_bytes_.load())
+      .Str("\n");
+  for (int kind = kHeap; kind <= kShm; ++kind) {
+    size_t bytes = total.bytes_[kind].load();
+    size_t free_bytes = total.free_bytes_[kind].load();
+    StatsLine(fd)
+        .Str("    ")
+        .Str(kKinds[kind], 4)
+        .Str(" allocs ")
+        .Num(total.count_[kind].load())
+        .Str(" (")
+        .Num(bytes)
+        .Str(" B), outstanding ")
+        .Num(bytes > free_bytes ? bytes - free_bytes : 0)
+        .Str(" B\n");
+    for (int bin = 0; bin < kNumSizeBins; ++bin) {
+      size_t count = total.bins_[kind][bin].load();
+      if (count) {
+        StatsLine(fd)
+            .Str("      [")
+            .Num((size_t)1 << bin)
+            .Str(", ")
+            .Num((size_t)2 << bin)
+            .Str("): ")
+            .Num(count)
+            .Str("\n");
+      }
+    }
+  }
+  StatsLine(fd).Str("  largest outstanding allocations:\n");
+  for (TrackedAlloc& entry : malloc_stats.tracked_) {
+    TrackedAlloc alloc = entry;
+    if (alloc.ptr_ == nullptr) {
+      continue;
+    }
+    StatsLine(fd)
+        .Str("    ")
+        .Ptr(alloc.ptr_)
+        .Str(": ")
+        .Num(alloc.size_)
+        .Str(" B ")
+        .Str(kKinds[alloc.kind_])
+        .Str("\n");
+    backtrace_symbols_fd(alloc.stack_, alloc.depth_, fd);
+  }
+}
+
+static void DumpMallocStatsAtExit() { DumpMallocStats(STDERR_FILENO); }
+
+}  // namespace chi
+
+/** Print the allocation statistics to \a fd, e.g., from a test */
+extern "C" void chi_malloc_dump_stats(int fd) { chi::DumpMallocStats(fd); }
+
+namespace chi {
+
+static void DumpMallocStatsOnSignal(int) { DumpMallocStats(STDERR_FILENO); }
+
+/** Install the dump handlers when the library is loaded */
+struct MallocStatsInit {
+  MallocStatsInit() {
+    if (!CHI_MALLOC->is_loaded_) {
+      new (CHI_MALLOC) MallocApi();
+    }
+    if (!CHI_MALLOC->stats_) {
+      return;
+    }
+    // The first backtrace loads libgcc, so do it outside of malloc
+    void* stack[1];
+    backtrace(stack, 1);
+    atexit(DumpMallocStatsAtExit);
+    signal(SIGUSR2, DumpMallocStatsOnSignal);
+  }
+};
+static MallocStatsInit malloc_stats_init;
+
+/**
+ * Free shm allocations of each size class, kept per thread so that
+ * allocating a large buffer again does not take the allocator lock.
+ * Free blocks are linked through their first bytes. The cache is
+ * returned to the allocator when its thread exits, when an allocation
+ * finds data shm exhausted, and while other allocations wait for space.
+ * */
+struct ShmThreadCache {
+  void* heads_[MallocApi::kNumClasses] = {};
+  size_t bytes_ = 0;
+  bool destroyed_ = false;
+
+  ~ShmThreadCache() {
+    destroyed_ = true;
+    Drain();
+  }
+
+  /** Return every cached allocation to the shm allocator */
+  void Drain() {
+    if (bytes_ == 0 || !CHI_CLIENT->IsInitialized()) {
+      return;
+    }
+    for (void*& head : heads_) {
+      while (head) {
+        void* next = *reinterpret_cast<void**>(head);
+        hipc::FullPtr<char> p((char*)head - sizeof(ShmMallocHeader));
+        CHI_CLIENT->FreeBuffer(HSHM_MCTX, p);
+        head = next;
+      }
+    }
+    bytes_ = 0;
+    UpdateStats();
+  }
+
+  /** The bytes a thread may cache, a share of the data segment */
+  static size_t GetCapacity() {
+    size_t share = (CHI_MALLOC->shm_end_ - CHI_MALLOC->shm_begin_) /
+                   kThreadCacheShare;
+    return share < kMaxThreadCacheBytes ? share : kMaxThreadCacheBytes;
+  }
+
+  /** Take a free allocation of a size class */
+  void* Pop(int cls) {
+    void* ptr = heads_[cls];
+    if (ptr) {
+      heads_[cls] = *reinterpret_cast<void**>(ptr);
+      bytes_ -= CHI_MALLOC->class_sizes_[cls];
+      UpdateStats();
+    }
+    return ptr;
+  }
+
+  /** Keep a free allocation, unless the cache is full */
+  bool Push(int cls, void* ptr) {
+    size_t size = CHI_MALLOC->class_sizes_[cls];
+    if (destroyed_ || bytes_ + size > GetCapacity()) {
+      return false;
+    }
+    *reinterpret_cast<void**>(ptr) = heads_[cls];
+    heads_[cls] = ptr;
+    bytes_ += size;
+    UpdateStats();
+    return true;
+  }
+
+  /** Publish the bytes held by the cache */
+  void UpdateStats() {
+    if (CHI_MALLOC->stats_) {
+      GetThreadStats()->cached_bytes_ = bytes_;
+    }
+  }
+};
+static thread_local ShmThreadCache shm_cache;
+
+/** Whether the shm bounds are unset, being set, or set */
+static constexpr int kShmBoundsUnset = 0;
+static constexpr int kShmBoundsSetting = 1;
+static constexpr int kShmBoundsSet = 2;
+static std::atomic<int> shm_bounds_state(kShmBoundsUnset);
+
+/**
+ * Record the bounds of the shm data allocator once the client is up.
+ * Called by malloc, realloc and free, so buffers from AllocateBuffer are
+ * recognized as shm even before the first large malloc.
+ * */
+static void InitShmBounds() {
+  if (shm_bounds_state.load(std::memory_order_acquire) == kShmBoundsSet) {
+    return;
+  }
+  if (!CHI_CLIENT->IsInitialized()) {
+    return;
+  }
+  int state = kShmBoundsUnset;
+  if (shm_bounds_state.compare_exchange_strong(state, kShmBoundsSetting,
+                                               std::memory_order_acq_rel)) {
+    auto* alloc = CHI_CLIENT->data_alloc_;
+    CHI_MALLOC->shm_begin_ = reinterpret_cast<uintptr_t>(alloc->buffer_);
+    CHI_MALLOC->shm_end_ = CHI_MALLOC->shm_begin_ + alloc->buffer_size_;
+    shm_bounds_state.store(kShmBoundsSet, std::memory_order_release);
+    return;
+  }
+  while (shm_bounds_state.load(std::memory_order_acquire) != kShmBoundsSet) {
+  }
+}
+
+/** Whether allocations are waiting for data shm to be freed */
+static bool IsShmLow() { return CHI_CLIENT->GetBufferStats().waiters_ > 0; }
+
+/**
+ * Allocate from the shm data allocator.
+ * If data shm is exhausted, the thread's cache is returned to the
+ * allocator before waiting, since nobody else can free it.
+ * */
+static void* ShmMalloc(size_t size) {
+  InitShmBounds();
+  size_t total_size = size + sizeof(ShmMallocHeader);
+  int cls = CHI_MALLOC->GetSizeClass(total_size);
+  if (cls >= 0) {
+    if (!shm_cache.destroyed_) {
+      void* ptr = shm_cache.Pop(cls);
+      if (ptr) {
+        return ptr;
+      }
+    }
+    total_size = CHI_MALLOC->class_sizes_[cls];
+  }
+  hipc::FullPtr<char> p = CHI_CLIENT->TryAllocateBuffer(HSHM_MCTX, total_size);
+  if (p.ptr_ == nullptr) {
+    shm_cache.Drain();
+    p = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, total_size);
+  }
+  if (p.ptr_ == nullptr) {
+    return nullptr;
+  }
+  auto* hdr = reinterpret_cast<ShmMallocHeader*>(p.ptr_);
+  hdr->size_ = total_size;
+  hdr->class_ = cls >= 0 ? cls : kUncached;
+  return hdr + 1;
+}
+
+/** Bytes usable in an allocation made by ShmMalloc */
+static size_t ShmUsableSize(void* ptr) {
+  auto* hdr = reinterpret_cast<ShmMallocHeader*>(ptr) - 1;
+  return hdr->size_ - sizeof(ShmMallocHeader);
+}
+
+/**
+ * Free an allocation made by ShmMalloc. While other allocations wait for
+ * data shm, the allocation and the thread's cache go back to the
+ * allocator instead of being cached.
+ * */
+static void ShmFree(void* ptr) {
+  auto* hdr = reinterpret_cast<ShmMallocHeader*>(ptr) - 1;
+  if (CHI_MALLOC->stats_) {
+    RecordFree(ptr, ShmUsableSize(ptr), kShm);
+  }
+  if (IsShmLow()) {
+    shm_cache.Drain();
+  } else if (hdr->class_ != kUncached && shm_cache.Push(hdr->class_, ptr)) {
+    return;
+  }
+  hipc::FullPtr<char> p((char*)hdr);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, p);
+}
 }  // namespace chi
 
 /** Allocate SIZE bytes of memory. */
@@ -32,10 +566,20 @@ void* malloc(size_t size) {
   if (!CHI_MALLOC->is_loaded_) {
     new (CHI_MALLOC) chi::MallocApi();
   }
-  if (size < hshm::Unit<size_t>::Megabytes(1) || !CHI_CLIENT->IsInitialized()) {
-    return CHI_MALLOC->malloc(size);
+  if (size < CHI_MALLOC->threshold_ || !CHI_CLIENT->IsInitialized()) {
+    void* ptr = CHI_MALLOC->malloc(size);
+    if (CHI_MALLOC->stats_) {
+      chi::RecordAlloc(ptr, size, ptr ? malloc_usable_size(ptr) : 0,
+                       chi::kHeap);
+    }
+    return ptr;
   } else {
-    return CHI_CLIENT->AllocateBuffer(HSHM_MCTX, size).ptr_;
+    void* ptr = chi::ShmMalloc(size);
+    if (CHI_MALLOC->stats_) {
+      chi::RecordAlloc(ptr, size, ptr ? chi::ShmUsableSize(ptr) : 0,
+                       chi::kShm);
+    }
+    return ptr;
   }
 }
 
@@ -57,23 +601,41 @@ void* realloc(void* ptr, size_t size) {
   if (ptr == nullptr) {
     return malloc(size);
   }
-  if (!CHI_CLIENT->IsInitialized() ||
-      !CHI_CLIENT->data_alloc_->ContainsPtr(ptr)) {
-    return CHI_MALLOC->realloc(ptr, size);
-  } else {
-    hipc::FullPtr<char> p((char*)ptr);
-    CHI_CLIENT->data_alloc_->ReallocateLocalPtr(HSHM_MCTX, p, size);
-    return p.ptr_;
+  chi::InitShmBounds();
+  if (!CHI_MALLOC->IsShmPtr(ptr)) {
+    if (!CHI_MALLOC->stats_) {
+      return CHI_MALLOC->realloc(ptr, size);
+    }
+    size_t old_usable = malloc_usable_size(ptr);
+    void* new_ptr = CHI_MALLOC->realloc(ptr, size);
+    if (new_ptr) {
+      chi::RecordFree(ptr, old_usable, chi::kHeap);
+      chi::RecordAlloc(new_ptr, size, malloc_usable_size(new_ptr), chi::kHeap);
+    }
+    return new_ptr;
+  }
+  // Size classes leave slack, so growing often fits in place
+  size_t usable = chi::ShmUsableSize(ptr);
+  if (size <= usable) {
+    return ptr;
+  }
+  void* new_ptr = malloc(size);
+  if (new_ptr) {
+    memcpy(new_ptr, ptr, usable);
+    chi::ShmFree(ptr);
   }
+  return new_ptr;
 }
 
 /** Free a block allocated by `malloc', `realloc' or `calloc'. */
 void free(void* ptr) {
-  if (!CHI_CLIENT->IsInitialized() ||
-      !CHI_CLIENT->data_alloc_->ContainsPtr(ptr)) {
+  chi::InitShmBounds();
+  if (!CHI_MALLOC->IsShmPtr(ptr)) {
+    if (CHI_MALLOC->stats_ && ptr) {
+      chi::RecordFree(ptr, malloc_usable_size(ptr), chi::kHeap);
+    }
     CHI_MALLOC->free(ptr);
   } else {
-    hipc::FullPtr<char> p((char*)ptr);
-    CHI_CLIENT->FreeBuffer(HSHM_MCTX, p);
+    chi::ShmFree(ptr);
   }
 }
@@ -14,6 +14,7 @@
 #define HSHM_SRC_MEMORY_MEMORY_INTERCEPT_H_
 
 #include <malloc.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "hermes_shm/util/real_api.h"
@@ -35,6 +36,11 @@ using hshm::RealApi;
 
 /** Pointers to the real posix API */
 class MallocApi : public RealApi {
+ public:
+  static constexpr size_t kDefaultThreshold = 1 << 20;
+  /** Each size class is 1.25x the last, starting at the threshold */
+  static constexpr int kNumClasses = 24;
+
  public:
   bool is_loaded_ = false;
   /** The real malloc API methods */
@@ -42,6 +48,15 @@ class MallocApi : public RealApi {
   calloc_t calloc = nullptr;
   realloc_t realloc = nullptr;
   free_t free = nullptr;
+  /** Allocations of at least this size go to the shm data allocator */
+  size_t threshold_ = kDefaultThreshold;
+  /** Bounds of the shm data allocator, set once the client is initialized */
+  uintptr_t shm_begin_ = 0;
+  uintptr_t shm_end_ = 0;
+  /** Sizes of the shm allocations cached by each thread */
+  size_t class_sizes_[kNumClasses];
+  /** Record allocation statistics, dumped at exit and on SIGUSR2 */
+  bool stats_ = false;
 
  public:
   MallocApi() : RealApi("malloc", "malloc_intercepted", true) {
@@ -53,8 +68,66 @@ class MallocApi : public RealApi {
     REQUIRE_API(realloc)
     free = (free_t)dlsym(real_lib_, "free");
     REQUIRE_API(free)
+    threshold_ = ParseSize(getenv("CHI_MALLOC_THRESHOLD"), kDefaultThreshold);
+    const char* stats = getenv("CHI_MALLOC_STATS");
+    stats_ = stats != nullptr && atoi(stats) != 0;
+    size_t class_size = threshold_;
+    for (int i = 0; i < kNumClasses; ++i) {
+      class_sizes_[i] = (class_size + 4095) / 4096 * 4096;
+      class_size += class_size / 4;
+    }
     is_loaded_ = true;
   }
+
+  /** Whether a pointer was allocated from the shm data allocator */
+  bool IsShmPtr(const void* ptr) const {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    return shm_begin_ <= addr && addr < shm_end_;
+  }
+
+  /** The smallest size class fitting \a size, or -1 if too large */
+  int GetSizeClass(size_t size) const {
+    int lo = 0, hi = kNumClasses;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (class_sizes_[mid] < size) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo < kNumClasses ? lo : -1;
+  }
+
+ private:
+  /**
+   * Parse a size such as 4m or 512k.
+   * Runs inside malloc, so it must not allocate.
+   * */
+  static size_t ParseSize(const char* str, size_t def) {
+    if (str == nullptr || *str == 0) {
+      return def;
+    }
+    char* end;
+    size_t size = strtoull(str, &end, 10);
+    switch (*end) {
+      case 'k':
+      case 'K':
+        size <<= 10;
+        break;
+      case 'm':
+      case 'M':
+        size <<= 20;
+        break;
+      case 'g':
+      case 'G':
+        size <<= 30;
+        break;
+      default:
+        break;
+    }
+    return size ? size : def;
+  }
 };
 
 // Singleton macros
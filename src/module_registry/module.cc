@@ -35,4 +35,24 @@ void Module::CreateLaneGroup(LaneGroupId group_id, u32 count,
 #endif
 }
 
+/** Wake the flush waiting on this container, if any */
+void Module::SignalFlushWaiter() {
+#ifdef CHIMAERA_RUNTIME
+  Task *waiter = flush_waiter_.exchange(nullptr);
+  if (waiter) {
+    CHI_WORK_ORCHESTRATOR->SignalUnblock(waiter, waiter->rctx_);
+  }
+#endif
+}
+
+/** Wake the upgrade draining this container, if any */
+void Module::SignalDrainWaiter() {
+#ifdef CHIMAERA_RUNTIME
+  Task *waiter = drain_waiter_.exchange(nullptr);
+  if (waiter) {
+    CHI_WORK_ORCHESTRATOR->SignalUnblock(waiter, waiter->rctx_);
+  }
+#endif
+}
+
 }  // namespace chi
\ No newline at end of file
@@ -18,6 +18,7 @@ Lane::Lane(LaneId lane_id, TaskPrio prio, LaneGroupId group_id,
     : lane_id_(lane_id), prio_(prio), group_id_(group_id),
       worker_id_(worker_id) {
   plug_count_ = 0;
+  migrate_to_ = kNoMigration;
   count_ = (hshm::min_u64)0;
   auto *runtime = CHI_RUNTIME;
   active_tasks_.resize(runtime->server_config_->queue_manager_.lane_depth_);
@@ -29,6 +30,7 @@ Lane::Lane(const Lane &lane) {
   worker_id_ = lane.worker_id_;
   load_ = lane.load_;
   plug_count_ = lane.plug_count_.load();
+  migrate_to_ = kNoMigration;
   prio_ = lane.prio_;
   auto *runtime = CHI_RUNTIME;
   active_tasks_.resize(runtime->server_config_->queue_manager_.lane_depth_);
@@ -42,19 +44,25 @@ template <bool NO_COUNT> hshm::qtok_t Lane::push(const FullPtr<Task> &task) {
     worker.active_.GetFail().push(task);
     return hshm::qtok_t();
   }
+  size_t dup = 1;
   if constexpr (!NO_COUNT) {
-    size_t dup = count_.fetch_add(1);
-    if (dup == 0) {
+    dup = count_.fetch_add(1);
+  }
+  hshm::qtok_t ret = active_tasks_.push(task);
+  if (dup == 0) {
+    // The lane was idle, so a pending migration can happen here
+    if (IsMigrating()) {
+      worker.MigrateLane(this, migrate_to_.load());
+    } else {
       HLOG(kDebug, kWorkerDebug,
            "Requesting lane {} with count {} with task {}", this, dup,
            task.ptr_);
       worker.RequestLane(this);
-    } else {
-      HLOG(kDebug, kWorkerDebug, "Skipping lane {} with count {} with task {}",
-           this, dup, task.ptr_);
     }
+  } else {
+    HLOG(kDebug, kWorkerDebug, "Skipping lane {} with count {} with task {}",
+         this, dup, task.ptr_);
   }
-  hshm::qtok_t ret = active_tasks_.push(task);
   return ret;
 }
 
@@ -31,6 +31,7 @@ bool ModuleRegistry::CreatePool(
 
   // Create partitioned state
   pools_[pool_id].lib_name_ = lib_name;
+  pools_[pool_id].pool_name_ = pool_name;
   std::unordered_map<ContainerId, Container *> &states =
       pools_[pool_id].containers_;
   for (const SubDomainId &container_id : containers) {
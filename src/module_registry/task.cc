@@ -14,6 +14,8 @@ namespace chi {
 
 void Task::WaitHost(chi::IntFlag flags) {
 #if defined(CHIMAERA_RUNTIME)
+  // Tasks of the runtime skip admission control, so none are rejected
+  flags &= ~TASK_KEEP_REJECTED;
   Task *parent_task = CHI_CUR_TASK;
   if (this != parent_task) {
     parent_task->Wait(this, flags);
@@ -21,7 +23,13 @@ void Task::WaitHost(chi::IntFlag flags) {
     SpinWaitCo(flags);
   }
 #else
-  SpinWait(flags);
+  if (IsRejected()) {
+    if (flags & TASK_KEEP_REJECTED) {
+      return;
+    }
+    CHI_CLIENT->ResubmitRejected(this);
+  }
+  SpinWait(flags & ~TASK_KEEP_REJECTED);
 #endif
 }
 
@@ -9,6 +9,14 @@ int main() {
     for (const auto &stat : stats) {
       std::cout << "\033[33m" << stat << "\033[0m" << std::endl;
     }
+    std::vector<chi::CoLockStats> locks =
+        CHI_ADMIN->PollLockStats(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0));
+    for (const auto &lock : locks) {
+      std::cout << "\033[36m" << lock << "\033[0m" << std::endl;
+    }
+    chi::BufferStats buffers = CHI_ADMIN->PollBufferStats(
+        HSHM_MCTX, chi::DomainQuery::GetLocalHash(0));
+    std::cout << "\033[35m" << buffers << "\033[0m" << std::endl;
     sleep(1);
   }
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "chimaera/work_orchestrator/colock_stats.h"
+
+namespace chi {
+
+CoLockSite::CoLockSite(const std::string &name) : name_(name) {
+  lock_.Init();
+  Reset();
+  if (IsEnabled()) {
+    CHI_COLOCK_PROFILER->Register(this);
+  }
+}
+
+CoLockSite::CoLockSite(const CoLockSite &other) : name_(other.name_) {
+  lock_.Init();
+  Reset();
+  if (IsEnabled()) {
+    CHI_COLOCK_PROFILER->Register(this);
+  }
+}
+
+CoLockSite::~CoLockSite() {
+  if (IsEnabled()) {
+    CHI_COLOCK_PROFILER->Unregister(this);
+  }
+}
+
+void CoLockSite::SetName(const std::string &name) {
+  if (IsEnabled()) {
+    CHI_COLOCK_PROFILER->Unregister(this);
+  }
+  name_ = name;
+  Reset();
+  if (IsEnabled()) {
+    CHI_COLOCK_PROFILER->Register(this);
+  }
+}
+
+void CoLockSite::Reset() {
+  acquires_ = 0;
+  contended_ = 0;
+  total_wait_ns_ = 0;
+  max_wait_ns_ = 0;
+  max_wait_holder_.SetNull();
+}
+
+void CoLockSite::RecordWait(size_t wait_ns, const TaskId &holder) {
+  acquires_ += 1;
+  hshm::ScopedMutex scoped(lock_, 0);
+  contended_ += 1;
+  total_wait_ns_ += wait_ns;
+  if (wait_ns > max_wait_ns_) {
+    max_wait_ns_ = wait_ns;
+    max_wait_holder_ = holder;
+  }
+}
+
+void CoLockSite::GetStats(CoLockStats &stats) {
+  hshm::ScopedMutex scoped(lock_, 0);
+  stats.name_ = chi::ipc::string(name_);
+  stats.acquires_ = acquires_.load();
+  stats.contended_ = contended_;
+  stats.total_wait_ns_ = total_wait_ns_;
+  stats.max_wait_ns_ = max_wait_ns_;
+  stats.max_wait_holder_ = max_wait_holder_;
+}
+
+void CoLockProfiler::Register(CoLockSite *site) {
+  hshm::ScopedMutex scoped(lock_, 0);
+  sites_.emplace_back(site);
+}
+
+void CoLockProfiler::Unregister(CoLockSite *site) {
+  hshm::ScopedMutex scoped(lock_, 0);
+  sites_.remove(site);
+}
+
+void CoLockProfiler::GetStats(chi::ipc::vector<CoLockStats> &stats) {
+  hshm::ScopedMutex scoped(lock_, 0);
+  stats.resize(sites_.size());
+  size_t i = 0;
+  for (CoLockSite *site : sites_) {
+    site->GetStats(stats[i++]);
+  }
+}
+
+} // namespace chi
@@ -3,8 +3,9 @@
 
 namespace chi {
 
-CoMutex::CoMutex()
-    : order_(CHI_RUNTIME->server_config_->queue_manager_.comux_depth_) {
+CoMutex::CoMutex(const std::string &name)
+    : order_(CHI_RUNTIME->server_config_->queue_manager_.comux_depth_),
+      site_(name) {
   root_.SetNull();
   rep_ = 0;
   mux_.Init();
@@ -17,6 +18,7 @@ bool CoMutex::TryLock() {
   if (root_.IsNull() || root_ == task_root) {
     root_ = task_root;
     ++rep_;
+    site_.RecordAcquire();
     return true;
   }
   return false;
@@ -29,8 +31,10 @@ void CoMutex::Lock() {
   if (rep_ == 0 || root_ == task_root) {
     root_ = task_root;
     ++rep_;
+    site_.RecordAcquire();
     return;
   }
+  TaskId holder = root_;
   task->SetBlocked(1);
   if (blocked_map_.find(task_root) == blocked_map_.end()) {
     blocked_map_[task_root] = COMUTEX_QUEUE_T();
@@ -41,7 +45,15 @@ void CoMutex::Lock() {
   COMUTEX_QUEUE_T &blocked = blocked_map_[task_root];
   blocked.emplace_back((CoMutexEntry){task});
   scoped.Unlock();
+  if (!site_.IsEnabled()) {
+    task->Yield();
+    return;
+  }
+  hshm::Timer wait;
+  wait.Resume();
   task->Yield();
+  wait.Pause();
+  site_.RecordWait(wait.GetNsec(), holder);
 }
 
 void CoMutex::Unlock() {
@@ -4,8 +4,9 @@
 
 namespace chi {
 
-CoRwLock::CoRwLock()
-    : order_(CHI_RUNTIME->server_config_->queue_manager_.comux_depth_) {
+CoRwLock::CoRwLock(const std::string &name)
+    : order_(CHI_RUNTIME->server_config_->queue_manager_.comux_depth_),
+      site_(name) {
   root_.SetNull();
   rep_ = 0;
   mux_.Init();
@@ -17,6 +18,7 @@ bool CoRwLock::TryReadLock() {
   if (rep_ == 0 || is_read_) {
     is_read_ = true;
     ++rep_;
+    site_.RecordAcquire();
     return true;
   }
   return false;
@@ -27,6 +29,7 @@ void CoRwLock::ReadLock() {
   if (rep_ == 0 || is_read_) {
     is_read_ = true;
     ++rep_;
+    site_.RecordAcquire();
     return;
   }
   Task *task = CHI_CUR_TASK;
@@ -34,10 +37,11 @@ void CoRwLock::ReadLock() {
   if (!is_read_ && root_ == task_root) {
     HELOG(kFatal, "Recursively acquiring read lock during write!");
   }
+  TaskId holder = root_;
   task->SetBlocked(1);
   reader_set_.emplace_back((CoRwLockEntry){task});
   scoped.Unlock();
-  task->Yield();
+  YieldWaiting(task, holder);
 }
 
 void CoRwLock::ReadUnlock() {
@@ -69,11 +73,13 @@ void CoRwLock::WriteLock() {
     if (rep_ == 0 || root_ == task_root) {
       root_ = task_root;
       ++rep_;
+      site_.RecordAcquire();
       return;
     }
   } else if (is_read_ && root_ == task_root) {
     HELOG(kFatal, "Recursively acquiring write lock during read!");
   }
+  TaskId holder = root_;
   task->SetBlocked(1);
   if (writer_map_.find(task_root) == writer_map_.end()) {
     writer_map_[task_root] = COMUTEX_QUEUE_T();
@@ -82,7 +88,19 @@ void CoRwLock::WriteLock() {
   COMUTEX_QUEUE_T &blocked = writer_map_[task_root];
   blocked.emplace_back((CoRwLockEntry){task});
   scoped.Unlock();
+  YieldWaiting(task, holder);
+}
+
+void CoRwLock::YieldWaiting(Task *task, const TaskId &holder) {
+  if (!site_.IsEnabled()) {
+    task->Yield();
+    return;
+  }
+  hshm::Timer wait;
+  wait.Resume();
   task->Yield();
+  wait.Pause();
+  site_.RecordWait(wait.GetNsec(), holder);
 }
 
 void CoRwLock::WriteUnlock() {
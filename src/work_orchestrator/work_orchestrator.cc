@@ -107,6 +107,7 @@ void WorkOrchestrator::AssignQueueMap(
       for (LaneId lane_id = lane_group.num_scheduled_; lane_id < num_lanes;
            ++lane_id) {
         WorkerId worker_id;
+        int numa_node;
         if (lane_group.IsLowLatency()) {
           u32 worker_off = count_lowlat % dworkers_.size();
           count_lowlat += 1;
@@ -114,6 +115,7 @@ void WorkOrchestrator::AssignQueueMap(
           worker.work_proc_queue_.emplace_back(
               IngressEntry(lane_group.prio_, lane_id, &queue));
           worker_id = worker.id_;
+          numa_node = worker.numa_node_;
         } else {
           u32 worker_off = count_highlat % oworkers_.size();
           count_highlat += 1;
@@ -121,9 +123,11 @@ void WorkOrchestrator::AssignQueueMap(
           worker.work_proc_queue_.emplace_back(
               IngressEntry(lane_group.prio_, lane_id, &queue));
           worker_id = worker.id_;
+          numa_node = worker.numa_node_;
         }
         ingress::Lane &lane = lane_group.GetLane(lane_id);
         lane.worker_id_ = worker_id;
+        lane.numa_node_ = numa_node;
       }
       lane_group.num_scheduled_ = num_lanes;
     }
@@ -265,6 +269,16 @@ void WorkOrchestrator::SignalUnblock(Task *task, RunContext &rctx) {
   }
 }
 
+/** Block a task until every worker passed a barrier */
+void WorkOrchestrator::WaitForWorkers(Task *task, bool drain_ingress) {
+  WorkerBarrier barrier{task, drain_ingress};
+  task->SetBlocked(workers_.size());
+  for (std::unique_ptr<Worker> &worker : workers_) {
+    worker->barrier_.store(&barrier, std::memory_order_release);
+  }
+  task->Yield();
+}
+
 #ifdef CHIMAERA_ENABLE_PYTHON
 void WorkOrchestrator::RegisterPath(const std::string &path) {
   CHI_PYTHON->RegisterPath(path);
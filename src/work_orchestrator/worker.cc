@@ -36,7 +36,6 @@ void PrivateTaskMultiQueue::Init(Worker *worker, size_t id, size_t pqdepth,
   worker_ = worker;
   id_ = id;
   HILOG(kInfo, "Initializing private task multi queue with depth {}", qdepth);
-  queues_[FLUSH].resize(qdepth);
   queues_[FAIL].resize(qdepth);
   queues_[REMAP].resize(qdepth);
   active_lanes_.resize(CHI_LANE_SIZE);
@@ -106,13 +105,6 @@ bool PrivateTaskMultiQueue::PushRoutedTask(RunContext &rctx,
 bool PrivateTaskMultiQueue::PushLocalTask(const DomainQuery &res_query,
                                           RunContext &rctx,
                                           const FullPtr<Task> &task) {
-  // If the task is a flushing task. Place in the flush queue.
-  if (task->IsFlush()) {
-    HLOG(kDebug, kWorkerDebug, "[TASK_CHECK] (node {}) Failing task {}",
-         CHI_CLIENT->node_id_, (void *)task.ptr_);
-    chi::Worker &flusher = CHI_WORK_ORCHESTRATOR->GetWorker(0);
-    return !flusher.active_.GetFlush().push(task).IsNull();
-  }
   // Determine the lane the task should map to within container
   ContainerId container_id = res_query.sel_.id_;
   Container *exec = CHI_MOD_REGISTRY->GetContainer(task->pool_, container_id);
@@ -127,6 +119,10 @@ bool PrivateTaskMultiQueue::PushLocalTask(const DomainQuery &res_query,
           CHI_CLIENT->node_id_, task->task_node_, task->pool_, container_id);
     return !GetFail().push(task).IsNull();
   }
+  if (!exec->TryBeginInFlight(task.ptr_)) {
+    // The container is draining for an upgrade. Retry once it is replaced.
+    return !GetFail().push(task).IsNull();
+  }
   // Find the lane
   chi::Lane *chi_lane = exec->MapTaskToLane(task.ptr_);
   // if (rctx.load_.CalculateLoad()) {
@@ -159,12 +155,17 @@ bool PrivateTaskMultiQueue::PushRemoteTask(RunContext &rctx,
   // Don't schedule long-running remote task if flushing and useless
   if (rctx.flush_->flushing_ && task->IsLongRunning()) {
     int prior_count = rctx.flush_->count_;
-    rctx.exec_->Monitor(MonitorMode::kFlushWork, task->method_, task.ptr_,
-                        rctx);
+    rctx.exec_->DispatchMonitor(MonitorMode::kFlushWork, task->method_,
+                                task.ptr_, rctx);
     if (prior_count == rctx.flush_->count_) {
       return !GetFail().push(task).IsNull();
     }
   }
+  // Count the task on the static container until it returns, so an
+  // upgrade does not unload the module's code while it is remote
+  if (!task->IsLongRunning()) {
+    rctx.exec_->BeginInFlight(task.ptr_);
+  }
   // Push client submit base
   CHI_REMOTE_QUEUE->AsyncClientPushSubmitBase(
       HSHM_MCTX, nullptr, task->task_node_ + 1,
@@ -182,6 +183,7 @@ Worker::Worker(WorkerId id, int cpu_id, const hshm::ThreadGroup &xstream) {
   sleep_us_ = 0;
   pid_ = 0;
   affinity_ = cpu_id;
+  numa_node_ = ConfigurationManager::GetNumaNode(cpu_id);
   for (int i = 0; i < 16; ++i) {
     AllocateStack();
   }
@@ -214,12 +216,12 @@ void Worker::WorkerEntryPoint(void *arg) {
 }
 
 /**
- * Begin flushing all worker tasks
- * NOTE: The first worker holds all FlushTasks and will signal other workers
- * in the first iteration.
+ * Begin a round of flushing all worker tasks during shutdown.
+ * NOTE: The first worker starts each round, but only once every worker
+ * has finished the previous one.
  * */
 void Worker::BeginFlush(WorkOrchestrator *orch) {
-  if (id_ == 0) {
+  if (id_ == 0 && !AnyFlushing(orch)) {
     if (flush_.flush_iter_ == 0) {
       HILOG(kInfo, "(node {}) Beginning to flush", CHI_CLIENT->node_id_);
     }
@@ -230,34 +232,32 @@ void Worker::BeginFlush(WorkOrchestrator *orch) {
   }
 }
 
-/** Check if work has been done */
+/**
+ * Check if work has been done.
+ * The first worker polls for the end of the round on each iteration
+ * rather than spinning on the other workers.
+ * */
 void Worker::EndFlush(WorkOrchestrator *orch) {
   flush_.tmp_flushing_ = false;
-  // On the root worker, detect if any work was done
-  if (id_ == 0) {
-    // Barrier for all workers to complete
-    while (AnyFlushing(orch)) {
-      HSHM_THREAD_MODEL->Yield();
+  if (id_ != 0 || AnyFlushing(orch)) {
+    return;
+  }
+  // Verify amount of flush work done
+  if (AnyFlushWorkDone(orch)) {
+    ++flush_.flush_iter_;
+  } else {
+    // Unset flushing
+    for (std::unique_ptr<Worker> &worker : orch->workers_) {
+      worker->flush_.flushing_ = false;
+      worker->flush_.tmp_flushing_ = false;
     }
-    // Verify amount of flush work done
-    if (AnyFlushWorkDone(orch)) {
-      ++flush_.flush_iter_;
-    } else {
-      // Unset flushing
-      for (std::unique_ptr<Worker> &worker : orch->workers_) {
-        worker->flush_.flushing_ = false;
-        worker->flush_.tmp_flushing_ = false;
-      }
-      // Reap all FlushTasks and end recurion
-      PollTempQueue<true>(active_.GetFlush(), false);
-      HILOG(kInfo, "(node={}) Ending Flush", CHI_CLIENT->node_id_);
-      // All work is done, so begin shutdown
-      if (orch->IsBeginningShutdown()) {
-        orch->FinalizeRuntime();
-      }
-      // Reset flush iterator
-      flush_.flush_iter_ = 0;
+    HILOG(kInfo, "(node={}) Ending Flush", CHI_CLIENT->node_id_);
+    // All work is done, so begin shutdown
+    if (orch->IsBeginningShutdown()) {
+      orch->FinalizeRuntime();
     }
+    // Reset flush iterator
+    flush_.flush_iter_ = 0;
   }
 }
 
@@ -299,8 +299,7 @@ void Worker::Loop() {
   while (orch->IsAlive()) {
     try {
       load_nsec_ = 0;
-      bool flushing = flush_.flushing_ || active_.GetFlush().size() ||
-                      orch->IsBeginningShutdown();
+      bool flushing = flush_.flushing_ || orch->IsBeginningShutdown();
       if (flushing) {
         BeginFlush(orch);
       }
@@ -310,6 +309,7 @@ void Worker::Loop() {
       }
       cur_time_.Refresh();
       iter_count_ += 1;
+      PassBarrier();
       if (load_nsec_ == 0) {
         // HSHM_THREAD_MODEL->SleepForUs(200);
       }
@@ -326,16 +326,43 @@ void Worker::Loop() {
   }
 }
 
+/** Let the task blocked on barrier_ know this worker passed it */
+void Worker::PassBarrier() {
+  WorkerBarrier *barrier = barrier_.load(std::memory_order_acquire);
+  if (!barrier) {
+    return;
+  }
+  if (barrier->drain_ingress_) {
+    if (!barrier_armed_) {
+      // Record the tail of each ingress lane as of now
+      for (IngressEntry &work_entry : work_proc_queue_) {
+        work_entry.barrier_tail_ =
+            work_entry.popped_ + work_entry.lane_->GetSize();
+      }
+      barrier_armed_ = true;
+    }
+    for (IngressEntry &work_entry : work_proc_queue_) {
+      if (work_entry.popped_ < work_entry.barrier_tail_) {
+        return;
+      }
+    }
+    barrier_armed_ = false;
+  }
+  barrier_.store(nullptr);
+  Task *waiter = barrier->waiter_;
+  CHI_WORK_ORCHESTRATOR->SignalUnblock(waiter, waiter->rctx_);
+}
+
 /** Run a single iteration over all queues */
 void Worker::Run(bool flushing) {
   // Process tasks in the pending queues
   for (size_t i = 0; i < 8192; ++i) {
     IngestProcLanes(flushing);
     PollPrivateLaneMultiQueue(active_.active_lanes_.GetLowLatency(), flushing);
-    PollTempQueue<false>(active_.GetFail(), flushing);
+    PollTempQueue(active_.GetFail(), flushing);
   }
   PollPrivateLaneMultiQueue(active_.active_lanes_.GetHighLatency(), flushing);
-  PollTempQueue<false>(active_.GetFail(), flushing);
+  PollTempQueue(active_.GetFail(), flushing);
 }
 
 /** Ingest all process lanes */
@@ -358,13 +385,13 @@ void Worker::IngestLane(IngressEntry &lane_info) {
     }
     FullPtr<Task> task(entry);
     active_.push(task);
+    ++lane_info.popped_;
   }
 }
 
 /** Poll the set of tasks in the private queue */
-template <bool FROM_FLUSH>
-HSHM_INLINE void Worker::PollTempQueue(PrivateTaskQueue &priv_queue,
-                                       bool flushing) {
+HSHM_INLINE
+void Worker::PollTempQueue(PrivateTaskQueue &priv_queue, bool flushing) {
   size_t size = priv_queue.size();
   for (size_t i = 0; i < size; ++i) {
     FullPtr<Task> task;
@@ -374,11 +401,6 @@ HSHM_INLINE void Worker::PollTempQueue(PrivateTaskQueue &priv_queue,
     if (task.IsNull()) {
       continue;
     }
-    if constexpr (FROM_FLUSH) {
-      if (task->IsFlush()) {
-        task->UnsetFlush();
-      }
-    }
     active_.push(task);
   }
 }
@@ -408,6 +430,11 @@ size_t Worker::PollPrivateLaneMultiQueue(PrivateLaneQueue &lanes,
       if (lanes.pop(chi_lane).IsNull() || chi_lane == nullptr) {
         break;
       }
+      // Hand the lane off if the scheduler moved it
+      if (chi_lane->IsMigrating()) {
+        MigrateLane(chi_lane, chi_lane->migrate_to_.load());
+        continue;
+      }
       cur_lane_ = chi_lane;
       if (cur_lane_ == nullptr) {
         HELOG(kFatal, "Lane is null, should never happen");
@@ -468,10 +495,22 @@ bool Worker::RunTask(FullPtr<Task> &task, bool flushing) {
   if (!task->IsTriggerComplete() && !task->IsBlocked()) {
     // Make this task current
     cur_task_ = task.ptr_;
+    // Long-running tasks of a container being upgraded pause between runs,
+    // and move to the new container once the state has been moved there
+    if (task->IsLongRunning() && !task->IsStarted() && rctx.exec_ &&
+        rctx.exec_->retiring_.load()) {
+      Container *next_version =
+          rctx.exec_->next_version_.load(std::memory_order_acquire);
+      if (!next_version) {
+        return true;
+      }
+      next_version->MigrateInFlight(rctx.exec_, task.ptr_);
+      rctx.exec_ = next_version;
+    }
     // Check if the task is dynamically-scheduled
     if (task->dom_query_.IsDynamic()) {
-      rctx.exec_->Monitor(MonitorMode::kSchedule, task->method_, task.ptr_,
-                          rctx);
+      rctx.exec_->DispatchMonitor(MonitorMode::kSchedule, task->method_,
+                                  task.ptr_, rctx);
       if (!task->IsRouted()) {
         active_.GetFail().push(task);
         return false;
@@ -553,7 +592,7 @@ void Worker::CoroutineEntry(bctx::transfer_t t) {
   }
   rctx.jmp_ = t;
   try {
-    exec->Run(task->method_, task, rctx);
+    exec->DispatchRun(task->method_, task, rctx);
   } catch (hshm::Error &e) {
     HELOG(kError, "(node {}) Worker {} caught an error: {}",
           CHI_CLIENT->node_id_, rctx.worker_id_, e.what());
@@ -579,7 +618,7 @@ void Worker::MonitorCoroutineEntry(bctx::transfer_t t) {
   }
   rctx.jmp_ = t;
   try {
-    exec->Monitor(MonitorMode::kFlushWork, task->method_, task, rctx);
+    exec->DispatchMonitor(MonitorMode::kFlushWork, task->method_, task, rctx);
   } catch (hshm::Error &e) {
     HELOG(kError, "(node {}) Worker {} caught an error: {}",
           CHI_CLIENT->node_id_, rctx.worker_id_, e.what());
@@ -599,6 +638,14 @@ HSHM_INLINE
 void Worker::EndTask(Container *exec, FullPtr<Task> task, RunContext &rctx) {
   // Ensure flusher knows something is happening.
   flush_.count_ += 1;
+  // The container no longer needs to wait for this task
+  if (task->IsInFlight()) {
+    rctx.exec_->EndInFlight(task.ptr_);
+  }
+  // Let the client admit another task of this pool
+  if (task->rctx_.admit_slot_ >= 0) {
+    CHI_CLIENT->ReleaseAdmission(task.ptr_);
+  }
   // Unblock the task pending on this one's completion
   if (task->ShouldSignalUnblock()) {
     Task *pending_to = rctx.pending_to_;
@@ -635,9 +682,21 @@ void Worker::EndTask(Container *exec, FullPtr<Task> task, RunContext &rctx) {
  * Helpers
  * =============================================================== */
 
-/** Migrate a lane from this worker to another */
+/**
+ * Migrate a lane from this worker to another.
+ * Must be called by the worker polling the lane. Pushes made by other
+ * workers are redirected to the new owner once worker_id_ changes.
+ * */
 void Worker::MigrateLane(Lane *lane, u32 new_worker) {
-  // Blocked + ingressed ops need to be located and removed from queues
+  lane->migrate_to_ = Lane::kNoMigration;
+  if (new_worker == id_) {
+    RequestLane(lane);
+    return;
+  }
+  lane->worker_id_ = new_worker;
+  HLOG(kDebug, kWorkerDebug, "Migrating lane {} from worker {} to {}", lane,
+       id_, new_worker);
+  CHI_WORK_ORCHESTRATOR->GetWorker(new_worker).RequestLane(lane);
 }
 
 /** Get the characteristics of a task */
@@ -694,6 +753,7 @@ bool Worker::IsLowLatency() { return flags_.Any(WORKER_LOW_LATENCY); }
 /** Set the CPU affinity of this worker */
 void Worker::SetCpuAffinity(int cpu_id) {
   affinity_ = cpu_id;
+  numa_node_ = ConfigurationManager::GetNumaNode(cpu_id);
   HSHM_THREAD_MODEL->SetAffinity(thread_, cpu_id);
 }
 
@@ -130,5 +130,40 @@ void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
     }
   }
 }
+/** Method dispatch table (indexed by method) */
+static const chi::MethodTable &GetMethodTable() {
+  static constexpr chi::RunMethod_t kRun[Method::kCount] = {
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Create(
+        reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Destroy(
+        reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::MonitorMethod_t kMonitor[Method::kCount] = {
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCreate(
+        mode, reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroy(
+        mode, reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::DelMethod_t kDel[Method::kCount] = {
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CreateTask>(
+        mctx, reinterpret_cast<CreateTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyTask>(
+        mctx, reinterpret_cast<DestroyTask *>(task));
+    },
+  };
+  static constexpr chi::MethodTable kTable = {kRun, kMonitor, kDel, Method::kCount};
+  return kTable;
+}
 
 #endif  // CHI_MOD_NAME_LIB_EXEC_H_
\ No newline at end of file
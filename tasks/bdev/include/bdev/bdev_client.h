@@ -19,6 +19,9 @@ namespace chi::bdev {
 
 /** Create bdev requests */
 class Client : public ModuleClient {
+public:
+  u32 tenant_ = 0; /**< The tenant charged for I/O by this client */
+
 public:
   /** Default constructor */
   Client() = default;
@@ -31,15 +34,22 @@ public:
   void Create(const hipc::MemContext &mctx, const DomainQuery &dom_query,
               const DomainQuery &affinity, const chi::string &pool_name,
               const chi::string &path, size_t max_size,
-              const CreateContext &ctx = CreateContext()) {
+              const CreateContext &ctx = CreateContext(),
+              const QosLimits &pool_qos = QosLimits(),
+              const QosLimits &tenant_qos = QosLimits()) {
     FullPtr<CreateTask> task =
-        AsyncCreate(mctx, dom_query, affinity, pool_name, ctx, path, max_size);
+        AsyncCreate(mctx, dom_query, affinity, pool_name, ctx, path, max_size,
+                    pool_qos, tenant_qos);
     task->Wait();
     Init(task->ctx_.id_);
     CHI_CLIENT->DelTask(mctx, task);
   }
   CHI_TASK_METHODS(Create);
 
+  /** Set the tenant charged for I/O by this client */
+  HSHM_INLINE_CROSS_FUN
+  void SetTenant(u32 tenant) { tenant_ = tenant; }
+
   /** Destroy pool + queue */
   HSHM_INLINE_CROSS_FUN
   void Destroy(const hipc::MemContext &mctx, const DomainQuery &dom_query) {
@@ -68,38 +78,89 @@ public:
   }
   CHI_TASK_METHODS(Free);
 
+  /** Free a batch of sections of the block device */
+  HSHM_INLINE_CROSS_FUN
+  void FreeBatch(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+                 const std::vector<Block> &blocks) {
+    FullPtr<FreeBatchTask> task = AsyncFreeBatch(mctx, dom_query, blocks);
+    task.ptr_->Wait();
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(FreeBatch);
+
   /** Write to the block device */
   HSHM_INLINE_CROSS_FUN
-  void Write(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+  bool Write(const hipc::MemContext &mctx, const DomainQuery &dom_query,
              const hipc::Pointer &data, Block block) {
-    Write(mctx, dom_query, data, block.off_, block.size_);
+    return Write(mctx, dom_query, data, block.off_, block.size_);
   }
   HSHM_INLINE_CROSS_FUN
-  void Write(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+  bool Write(const hipc::MemContext &mctx, const DomainQuery &dom_query,
              const hipc::Pointer &data, size_t off, size_t size) {
-    FullPtr<WriteTask> task = AsyncWrite(mctx, dom_query, data, off, size);
+    FullPtr<WriteTask> task =
+        AsyncWrite(mctx, dom_query, data, off, size, tenant_);
     task.ptr_->Wait();
+    bool success = task->success_;
     CHI_CLIENT->DelTask(mctx, task);
+    return success;
   }
   CHI_TASK_METHODS(Write);
 
   /** Read from the block device */
   HSHM_INLINE_CROSS_FUN
-  void Read(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+  bool Read(const hipc::MemContext &mctx, const DomainQuery &dom_query,
             const hipc::Pointer &data, Block &block) {
+    return Read(mctx, dom_query, data, block.off_, block.size_);
+  }
+  HSHM_INLINE_CROSS_FUN
+  bool Read(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+            const hipc::Pointer &data, size_t off, size_t size) {
     FullPtr<ReadTask> task =
-        AsyncRead(mctx, dom_query, data, block.off_, block.size_);
+        AsyncRead(mctx, dom_query, data, off, size, tenant_);
+    task.ptr_->Wait();
+    bool success = task->success_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return success;
+  }
+  CHI_TASK_METHODS(Read);
+
+  /** Write a set of segments to the block device */
+  HSHM_INLINE_CROSS_FUN
+  bool WriteV(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+              const std::vector<IoSegment> &segs) {
+    FullPtr<WriteVTask> task = AsyncWriteV(mctx, dom_query, segs, tenant_);
     task.ptr_->Wait();
+    bool success = task->success_;
     CHI_CLIENT->DelTask(mctx, task);
+    return success;
   }
+  CHI_TASK_METHODS(WriteV);
+
+  /** Read a set of segments from the block device */
   HSHM_INLINE_CROSS_FUN
-  void Read(const hipc::MemContext &mctx, const DomainQuery &dom_query,
-            const hipc::Pointer &data, size_t off, size_t size) {
-    FullPtr<ReadTask> task = AsyncRead(mctx, dom_query, data, off, size);
+  bool ReadV(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+             const std::vector<IoSegment> &segs) {
+    FullPtr<ReadVTask> task = AsyncReadV(mctx, dom_query, segs, tenant_);
     task.ptr_->Wait();
+    bool success = task->success_;
     CHI_CLIENT->DelTask(mctx, task);
+    return success;
   }
-  CHI_TASK_METHODS(Read);
+  CHI_TASK_METHODS(ReadV);
+
+  /**
+   * Change the bandwidth and IOPS limits of a tenant.
+   * The tenant may also be QosLimits::kPool for the limits of the whole
+   * pool, or QosLimits::kDefaultTenant for tenants without their own.
+   * */
+  HSHM_INLINE_CROSS_FUN
+  void SetQos(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+              u32 tenant, const QosLimits &limits) {
+    FullPtr<SetQosTask> task = AsyncSetQos(mctx, dom_query, tenant, limits);
+    task.ptr_->Wait();
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(SetQos);
 
   /** Periodically poll block device stats */
   HSHM_INLINE_CROSS_FUN
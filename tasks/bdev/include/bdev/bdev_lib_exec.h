@@ -32,6 +32,22 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       PollStats(reinterpret_cast<PollStatsTask *>(task), rctx);
       break;
     }
+    case Method::kWriteV: {
+      WriteV(reinterpret_cast<WriteVTask *>(task), rctx);
+      break;
+    }
+    case Method::kReadV: {
+      ReadV(reinterpret_cast<ReadVTask *>(task), rctx);
+      break;
+    }
+    case Method::kFreeBatch: {
+      FreeBatch(reinterpret_cast<FreeBatchTask *>(task), rctx);
+      break;
+    }
+    case Method::kSetQos: {
+      SetQos(reinterpret_cast<SetQosTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Execute a task */
@@ -65,6 +81,22 @@ void Monitor(MonitorModeId mode, MethodId method, Task *task, RunContext &rctx)
       MonitorPollStats(mode, reinterpret_cast<PollStatsTask *>(task), rctx);
       break;
     }
+    case Method::kWriteV: {
+      MonitorWriteV(mode, reinterpret_cast<WriteVTask *>(task), rctx);
+      break;
+    }
+    case Method::kReadV: {
+      MonitorReadV(mode, reinterpret_cast<ReadVTask *>(task), rctx);
+      break;
+    }
+    case Method::kFreeBatch: {
+      MonitorFreeBatch(mode, reinterpret_cast<FreeBatchTask *>(task), rctx);
+      break;
+    }
+    case Method::kSetQos: {
+      MonitorSetQos(mode, reinterpret_cast<SetQosTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Delete a task */
@@ -98,6 +130,22 @@ void Del(const hipc::MemContext &mctx, u32 method, Task *task) override {
       CHI_CLIENT->DelTask<PollStatsTask>(mctx, reinterpret_cast<PollStatsTask *>(task));
       break;
     }
+    case Method::kWriteV: {
+      CHI_CLIENT->DelTask<WriteVTask>(mctx, reinterpret_cast<WriteVTask *>(task));
+      break;
+    }
+    case Method::kReadV: {
+      CHI_CLIENT->DelTask<ReadVTask>(mctx, reinterpret_cast<ReadVTask *>(task));
+      break;
+    }
+    case Method::kFreeBatch: {
+      CHI_CLIENT->DelTask<FreeBatchTask>(mctx, reinterpret_cast<FreeBatchTask *>(task));
+      break;
+    }
+    case Method::kSetQos: {
+      CHI_CLIENT->DelTask<SetQosTask>(mctx, reinterpret_cast<SetQosTask *>(task));
+      break;
+    }
   }
 }
 /** Duplicate a task */
@@ -145,6 +193,30 @@ void CopyStart(u32 method, const Task *orig_task, Task *dup_task, bool deep) ove
         reinterpret_cast<PollStatsTask*>(dup_task), deep);
       break;
     }
+    case Method::kWriteV: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const WriteVTask*>(orig_task), 
+        reinterpret_cast<WriteVTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kReadV: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const ReadVTask*>(orig_task), 
+        reinterpret_cast<ReadVTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kFreeBatch: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const FreeBatchTask*>(orig_task), 
+        reinterpret_cast<FreeBatchTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kSetQos: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const SetQosTask*>(orig_task), 
+        reinterpret_cast<SetQosTask*>(dup_task), deep);
+      break;
+    }
   }
 }
 /** Duplicate a task */
@@ -178,6 +250,22 @@ void NewCopyStart(u32 method, const Task *orig_task, FullPtr<Task> &dup_task, bo
       chi::CALL_NEW_COPY_START(reinterpret_cast<const PollStatsTask*>(orig_task), dup_task, deep);
       break;
     }
+    case Method::kWriteV: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const WriteVTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kReadV: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const ReadVTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kFreeBatch: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const FreeBatchTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kSetQos: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const SetQosTask*>(orig_task), dup_task, deep);
+      break;
+    }
   }
 }
 /** Serialize a task when initially pushing into remote */
@@ -213,6 +301,22 @@ void SaveStart(
       ar << *reinterpret_cast<PollStatsTask*>(task);
       break;
     }
+    case Method::kWriteV: {
+      ar << *reinterpret_cast<WriteVTask*>(task);
+      break;
+    }
+    case Method::kReadV: {
+      ar << *reinterpret_cast<ReadVTask*>(task);
+      break;
+    }
+    case Method::kFreeBatch: {
+      ar << *reinterpret_cast<FreeBatchTask*>(task);
+      break;
+    }
+    case Method::kSetQos: {
+      ar << *reinterpret_cast<SetQosTask*>(task);
+      break;
+    }
   }
 }
 /** Deserialize a task when popping from remote queue */
@@ -261,6 +365,30 @@ TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<PollStatsTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kWriteV: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<WriteVTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<WriteVTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kReadV: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<ReadVTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<ReadVTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kFreeBatch: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<FreeBatchTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<FreeBatchTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kSetQos: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<SetQosTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<SetQosTask*>(task_ptr.ptr_);
+      break;
+    }
   }
   return task_ptr;
 }
@@ -295,6 +423,22 @@ void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Task *task) override {
       ar << *reinterpret_cast<PollStatsTask*>(task);
       break;
     }
+    case Method::kWriteV: {
+      ar << *reinterpret_cast<WriteVTask*>(task);
+      break;
+    }
+    case Method::kReadV: {
+      ar << *reinterpret_cast<ReadVTask*>(task);
+      break;
+    }
+    case Method::kFreeBatch: {
+      ar << *reinterpret_cast<FreeBatchTask*>(task);
+      break;
+    }
+    case Method::kSetQos: {
+      ar << *reinterpret_cast<SetQosTask*>(task);
+      break;
+    }
   }
 }
 /** Deserialize a task when popping from remote queue */
@@ -328,7 +472,190 @@ void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
       ar >> *reinterpret_cast<PollStatsTask*>(task);
       break;
     }
+    case Method::kWriteV: {
+      ar >> *reinterpret_cast<WriteVTask*>(task);
+      break;
+    }
+    case Method::kReadV: {
+      ar >> *reinterpret_cast<ReadVTask*>(task);
+      break;
+    }
+    case Method::kFreeBatch: {
+      ar >> *reinterpret_cast<FreeBatchTask*>(task);
+      break;
+    }
+    case Method::kSetQos: {
+      ar >> *reinterpret_cast<SetQosTask*>(task);
+      break;
+    }
   }
 }
+/** Method dispatch table (indexed by method) */
+static const chi::MethodTable &GetMethodTable() {
+  static constexpr chi::RunMethod_t kRun[Method::kCount] = {
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Create(
+        reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Destroy(
+        reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Allocate(
+        reinterpret_cast<AllocateTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Free(
+        reinterpret_cast<FreeTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Write(
+        reinterpret_cast<WriteTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Read(
+        reinterpret_cast<ReadTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->PollStats(
+        reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->WriteV(
+        reinterpret_cast<WriteVTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->ReadV(
+        reinterpret_cast<ReadVTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->FreeBatch(
+        reinterpret_cast<FreeBatchTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->SetQos(
+        reinterpret_cast<SetQosTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::MonitorMethod_t kMonitor[Method::kCount] = {
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCreate(
+        mode, reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroy(
+        mode, reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorAllocate(
+        mode, reinterpret_cast<AllocateTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorFree(
+        mode, reinterpret_cast<FreeTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorWrite(
+        mode, reinterpret_cast<WriteTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorRead(
+        mode, reinterpret_cast<ReadTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorPollStats(
+        mode, reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorWriteV(
+        mode, reinterpret_cast<WriteVTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorReadV(
+        mode, reinterpret_cast<ReadVTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorFreeBatch(
+        mode, reinterpret_cast<FreeBatchTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorSetQos(
+        mode, reinterpret_cast<SetQosTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::DelMethod_t kDel[Method::kCount] = {
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CreateTask>(
+        mctx, reinterpret_cast<CreateTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyTask>(
+        mctx, reinterpret_cast<DestroyTask *>(task));
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<AllocateTask>(
+        mctx, reinterpret_cast<AllocateTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<FreeTask>(
+        mctx, reinterpret_cast<FreeTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<WriteTask>(
+        mctx, reinterpret_cast<WriteTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<ReadTask>(
+        mctx, reinterpret_cast<ReadTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<PollStatsTask>(
+        mctx, reinterpret_cast<PollStatsTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<WriteVTask>(
+        mctx, reinterpret_cast<WriteVTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<ReadVTask>(
+        mctx, reinterpret_cast<ReadVTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<FreeBatchTask>(
+        mctx, reinterpret_cast<FreeBatchTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<SetQosTask>(
+        mctx, reinterpret_cast<SetQosTask *>(task));
+    },
+  };
+  static constexpr chi::MethodTable kTable = {kRun, kMonitor, kDel, Method::kCount};
+  return kTable;
+}
 
 #endif  // CHI_BDEV_LIB_EXEC_H_
\ No newline at end of file
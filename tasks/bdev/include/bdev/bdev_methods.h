@@ -8,7 +8,11 @@ struct Method : public chi::TaskMethod {
   TASK_METHOD_T kWrite = 12;
   TASK_METHOD_T kRead = 13;
   TASK_METHOD_T kPollStats = 14;
-  TASK_METHOD_T kCount = 15;
+  TASK_METHOD_T kWriteV = 15;
+  TASK_METHOD_T kReadV = 16;
+  TASK_METHOD_T kFreeBatch = 17;
+  TASK_METHOD_T kSetQos = 18;
+  TASK_METHOD_T kCount = 19;
 };
 
 #endif  // CHI_BDEV_METHODS_H_
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include "chimaera/chimaera_namespace.h"
 #include "chimaera/io/block_allocator.h"
+#include "chimaera/io/token_bucket.h"
 
 namespace chi::bdev {
 
@@ -20,6 +21,8 @@ struct CreateTaskParams {
   CLS_CONST char *lib_name_ = "chimaera_bdev";
   IN chi::string path_;
   IN size_t size_;
+  IN QosLimits pool_qos_;   /**< Limits on the I/O of the whole pool */
+  IN QosLimits tenant_qos_; /**< Limits on the I/O of each tenant */
 
   HSHM_INLINE_CROSS_FUN
   CreateTaskParams() = default;
@@ -29,14 +32,16 @@ struct CreateTaskParams {
 
   HSHM_INLINE_CROSS_FUN
   CreateTaskParams(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
-                   const chi::string &path, size_t size)
-      : path_(path) {
+                   const chi::string &path, size_t size,
+                   const QosLimits &pool_qos = QosLimits(),
+                   const QosLimits &tenant_qos = QosLimits())
+      : path_(path), pool_qos_(pool_qos), tenant_qos_(tenant_qos) {
     size_ = size;
   }
 
   template <typename Ar>
   void serialize(Ar &ar) {
-    ar(path_, size_);
+    ar(path_, size_, pool_qos_, tenant_qos_);
   }
 };
 typedef chi::Admin::CreatePoolBaseTask<CreateTaskParams> CreateTask;
@@ -139,6 +144,51 @@ struct FreeTask : public Task, TaskFlags<TF_SRL_SYM> {
   HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {}
 };
 
+/** A task to free a batch of blocks in one round trip */
+struct FreeBatchTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN chi::ipc::vector<Block> blocks_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit FreeBatchTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), blocks_(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit FreeBatchTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                         const TaskNode &task_node, const PoolId &pool_id,
+                         const DomainQuery &dom_query,
+                         const std::vector<Block> &blocks)
+      : Task(alloc), blocks_(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kFreeBatch;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    blocks_ = blocks;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const FreeBatchTask &other, bool deep) {
+    blocks_ = other.blocks_;
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar(blocks_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {}
+};
+
 /**
  * A custom task in bdev
  * */
@@ -146,6 +196,7 @@ struct WriteTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN hipc::Pointer data_;
   IN size_t size_;
   IN size_t off_;
+  IN u32 tenant_; /**< The tenant charged for the I/O */
   OUT bool success_;
 
   /** SHM default constructor */
@@ -157,7 +208,7 @@ struct WriteTask : public Task, TaskFlags<TF_SRL_SYM> {
   HSHM_INLINE_CROSS_FUN explicit WriteTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
       const PoolId &pool_id, const DomainQuery &dom_query,
-      const hipc::Pointer &data, size_t off, size_t size)
+      const hipc::Pointer &data, size_t off, size_t size, u32 tenant = 0)
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
@@ -171,6 +222,7 @@ struct WriteTask : public Task, TaskFlags<TF_SRL_SYM> {
     data_ = data;
     size_ = size;
     off_ = off;
+    tenant_ = tenant;
   }
 
   /** Destructor */
@@ -189,6 +241,7 @@ struct WriteTask : public Task, TaskFlags<TF_SRL_SYM> {
     data_ = other.data_;
     size_ = other.size_;
     off_ = other.off_;
+    tenant_ = other.tenant_;
     if (!deep) {
       UnsetDataOwner();
     }
@@ -198,13 +251,13 @@ struct WriteTask : public Task, TaskFlags<TF_SRL_SYM> {
   template <typename Ar>
   HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
     ar.bulk(DT_WRITE, data_, size_);
-    ar(off_);
+    ar(off_, tenant_);
   }
 
   /** (De)serialize message return */
   template <typename Ar>
   HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
-    // ar(success_);
+    ar(success_);
   }
 };
 
@@ -215,6 +268,7 @@ struct ReadTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN hipc::Pointer data_;
   IN size_t size_;
   IN size_t off_;
+  IN u32 tenant_; /**< The tenant charged for the I/O */
   OUT bool success_;
 
   /** SHM default constructor */
@@ -227,7 +281,7 @@ struct ReadTask : public Task, TaskFlags<TF_SRL_SYM> {
   explicit ReadTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
                     const TaskNode &task_node, const PoolId &pool_id,
                     const DomainQuery &dom_query, const hipc::Pointer &data,
-                    size_t off, size_t size)
+                    size_t off, size_t size, u32 tenant = 0)
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
@@ -241,6 +295,7 @@ struct ReadTask : public Task, TaskFlags<TF_SRL_SYM> {
     data_ = data;
     size_ = size;
     off_ = off;
+    tenant_ = tenant;
   }
 
   /** Destructor */
@@ -259,6 +314,7 @@ struct ReadTask : public Task, TaskFlags<TF_SRL_SYM> {
     data_ = other.data_;
     size_ = other.size_;
     off_ = other.off_;
+    tenant_ = other.tenant_;
     if (!deep) {
       UnsetDataOwner();
     }
@@ -268,7 +324,7 @@ struct ReadTask : public Task, TaskFlags<TF_SRL_SYM> {
   template <typename Ar>
   HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
     ar.bulk(DT_EXPOSE, data_, size_);
-    ar(off_);
+    ar(off_, tenant_);
   }
 
   /** (De)serialize message return */
@@ -279,6 +335,232 @@ struct ReadTask : public Task, TaskFlags<TF_SRL_SYM> {
   }
 };
 
+/** A segment of a vectored bdev I/O */
+struct IoSegment {
+  hipc::Pointer data_; /**< The buffer of the segment */
+  size_t size_;        /**< The size of the segment */
+  size_t off_;         /**< The offset of the segment in the bdev */
+};
+
+/**
+ * Write a set of segments to the block device in a single task
+ * */
+struct WriteVTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN chi::ipc::vector<IoSegment> segs_;
+  IN u32 tenant_; /**< The tenant charged for the I/O */
+  OUT bool success_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN explicit WriteVTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), segs_(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN explicit WriteVTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
+      const PoolId &pool_id, const DomainQuery &dom_query,
+      const std::vector<IoSegment> &segs, u32 tenant = 0)
+      : Task(alloc), segs_(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kWriteV;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    segs_ = segs;
+    tenant_ = tenant;
+  }
+
+  /** Destructor */
+  ~WriteVTask() {
+    if (IsDataOwner()) {
+      for (size_t i = 0; i < segs_.size(); ++i) {
+        if (!segs_[i].data_.IsNull()) {
+          CHI_CLIENT->FreeBuffer(HSHM_MCTX, segs_[i].data_);
+        }
+      }
+    }
+  }
+
+  /** Total size of the segments */
+  HSHM_INLINE_CROSS_FUN
+  size_t GetSize() const {
+    size_t size = 0;
+    for (size_t i = 0; i < segs_.size(); ++i) {
+      size += segs_[i].size_;
+    }
+    return size;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const WriteVTask &other, bool deep) {
+    segs_ = other.segs_;
+    tenant_ = other.tenant_;
+    if (!deep) {
+      UnsetDataOwner();
+    }
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    size_t count = segs_.size();
+    ar(count, tenant_);
+    segs_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      IoSegment &seg = segs_[i];
+      ar.bulk(DT_WRITE, seg.data_, seg.size_);
+      ar(seg.off_);
+    }
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(success_);
+  }
+};
+
+/**
+ * Read a set of segments from the block device in a single task
+ * */
+struct ReadVTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN chi::ipc::vector<IoSegment> segs_;
+  IN u32 tenant_; /**< The tenant charged for the I/O */
+  OUT bool success_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit ReadVTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), segs_(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit ReadVTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                     const TaskNode &task_node, const PoolId &pool_id,
+                     const DomainQuery &dom_query,
+                     const std::vector<IoSegment> &segs, u32 tenant = 0)
+      : Task(alloc), segs_(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kReadV;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    segs_ = segs;
+    tenant_ = tenant;
+  }
+
+  /** Destructor */
+  ~ReadVTask() {
+    if (IsDataOwner()) {
+      for (size_t i = 0; i < segs_.size(); ++i) {
+        if (!segs_[i].data_.IsNull()) {
+          CHI_CLIENT->FreeBuffer(HSHM_MCTX, segs_[i].data_);
+        }
+      }
+    }
+  }
+
+  /** Total size of the segments */
+  HSHM_INLINE_CROSS_FUN
+  size_t GetSize() const {
+    size_t size = 0;
+    for (size_t i = 0; i < segs_.size(); ++i) {
+      size += segs_[i].size_;
+    }
+    return size;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const ReadVTask &other, bool deep) {
+    segs_ = other.segs_;
+    tenant_ = other.tenant_;
+    if (!deep) {
+      UnsetDataOwner();
+    }
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    size_t count = segs_.size();
+    ar(count, tenant_);
+    segs_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      IoSegment &seg = segs_[i];
+      ar.bulk(DT_EXPOSE, seg.data_, seg.size_);
+      ar(seg.off_);
+    }
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  void SerializeEnd(Ar &ar) {
+    for (size_t i = 0; i < segs_.size(); ++i) {
+      IoSegment &seg = segs_[i];
+      ar.bulk(DT_WRITE, seg.data_, seg.size_);
+    }
+    ar(success_);
+  }
+};
+
+/** A task to change the bandwidth and IOPS limits of a bdev */
+struct SetQosTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN u32 tenant_; /**< A tenant, QosLimits::kPool or kDefaultTenant */
+  IN QosLimits limits_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit SetQosTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit SetQosTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                      const TaskNode &task_node, const PoolId &pool_id,
+                      const DomainQuery &dom_query, u32 tenant,
+                      const QosLimits &limits)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kSetQos;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    tenant_ = tenant;
+    limits_ = limits;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const SetQosTask &other, bool deep) {
+    tenant_ = other.tenant_;
+    limits_ = other.limits_;
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar(tenant_, limits_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {}
+};
+
 /**
  * A custom task in bdev
  * */
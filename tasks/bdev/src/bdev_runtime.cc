@@ -10,10 +10,24 @@
  * have access to the file, you may request a copy from help@hdfgroup.org.   *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <algorithm>
+#include <linux/fs.h>
+#include <linux/mempolicy.h>
+#include <limits.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "bdev/bdev_client.h"
 #include "chimaera/api/chimaera_runtime.h"
+#include "chimaera/io/crc32c.h"
 #include "chimaera/monitor/monitor.h"
 #include "chimaera_admin/chimaera_admin_client.h"
 
@@ -29,24 +43,96 @@ struct IoPerf {
   LeastSquares lat_; // nsec
 };
 
+/** A private buffer aligned for O_DIRECT */
+class AlignedBuffer {
+public:
+  char *data_;
+
+public:
+  AlignedBuffer(size_t size, size_t alignment) {
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    if (posix_memalign((void **)&data_, alignment, size) != 0) {
+      data_ = nullptr;
+    }
+  }
+
+  ~AlignedBuffer() { free(data_); }
+
+  char *data() { return data_; }
+};
+
+/**
+ * Holds the checksum lock stripes touched by an I/O. Stripes are taken in
+ * ascending order, so I/Os spanning several stripes cannot deadlock.
+ * */
+class ScopedCrcLock {
+public:
+  CoRwLock *locks_;
+  std::vector<u32> stripes_;
+  bool write_;
+
+public:
+  ScopedCrcLock(CoRwLock *locks, std::vector<u32> &&stripes, bool write)
+      : locks_(locks), stripes_(std::move(stripes)), write_(write) {
+    std::sort(stripes_.begin(), stripes_.end());
+    stripes_.erase(std::unique(stripes_.begin(), stripes_.end()),
+                   stripes_.end());
+    for (u32 stripe : stripes_) {
+      if (write_) {
+        locks_[stripe].WriteLock();
+      } else {
+        locks_[stripe].ReadLock();
+      }
+    }
+  }
+
+  ~ScopedCrcLock() {
+    for (auto it = stripes_.rbegin(); it != stripes_.rend(); ++it) {
+      if (write_) {
+        locks_[*it].WriteUnlock();
+      } else {
+        locks_[*it].ReadUnlock();
+      }
+    }
+  }
+};
+
 class Server : public Module {
 public:
+  Client client_; /**< Submits the per-device pieces of striped I/O */
   BlockAllocator alloc_;
   BlockUrl url_;
-  int fd_;
+  std::vector<int> fds_; /**< One file per striped device */
+  size_t stripe_size_;   /**< Stripe unit across fds_, 0 if not striped */
+  size_t align_; /**< Alignment of buffers, offsets, and sizes for O_DIRECT */
 #ifdef CHIMAERA_ENABLE_CUDA
   CUfileError_t cf_status_;
   CUfileDescr_t cf_descr_;
   CUfileHandle_t cf_handle_;
 #endif
   char *ram_;
+  size_t ram_size_;
+  size_t dev_size_;
+  std::vector<std::atomic<u64>>
+      crcs_;         /**< CRC32C of each chunk, kCrcValid if written */
+  size_t crc_chunk_; /**< Bytes covered by each checksum */
+  std::atomic<size_t> checksum_errors_;
+  QosPolicy qos_;
   RollingAverage monitor_[Method::kCount];
   CLS_CONST int kRead = 0;
   CLS_CONST int kWrite = 1;
   IoPerf io_perf_[2];
   size_t lat_cutoff_;
   CLS_CONST LaneGroupId kMdGroup = 0;
-  CLS_CONST LaneGroupId kDataGroup = 1;
+  CLS_CONST LaneGroupId kDataGroup = 1; /**< First of one group per device */
+  CLS_CONST u32 kNumDataLanes = 32;
+  CLS_CONST size_t kHugePageSize = MEGABYTES(2);
+  CLS_CONST size_t kStreamCutoff = KILOBYTES(256);
+  CLS_CONST int kMaxNumaNodes = 1024;
+  CLS_CONST size_t kCrcChunkSize = KILOBYTES(4);
+  CLS_CONST u64 kCrcValid = 1ull << 32;
+  CLS_CONST u32 kNumCrcLocks = 64;
+  CoRwLock crc_locks_[kNumCrcLocks]; /**< Chunk I/O + checksum, by stripe */
 
 public:
   Server() = default;
@@ -56,15 +142,29 @@ public:
     CreateTaskParams params = task->GetParams();
     std::string url = params.path_.str();
     size_t dev_size = params.size_;
+    qos_.SetLimits(QosLimits::kPool, params.pool_qos_);
+    qos_.SetLimits(QosLimits::kDefaultTenant, params.tenant_qos_);
     url_.Parse(url);
+    for (std::string &path : url_.paths_) {
+      path = hshm::Formatter::format("{}.{}", path, container_id_);
+    }
     url_.path_ = hshm::Formatter::format("{}.{}", url_.path_, container_id_);
-    alloc_.Init(1, dev_size);
+    align_ = 1;
+    stripe_size_ = 0;
+    client_.Init(pool_id_);
     CreateLaneGroup(kMdGroup, 1, QUEUE_LOW_LATENCY);
-    CreateLaneGroup(kDataGroup, 32, QUEUE_HIGH_LATENCY);
+    // Each device gets its own group of data lanes
+    u32 num_devs = GetNumDevices();
+    for (u32 dev = 0; dev < num_devs; ++dev) {
+      CreateLaneGroup(kDataGroup + dev,
+                      std::max<u32>(kNumDataLanes / num_devs, 1),
+                      QUEUE_HIGH_LATENCY);
+    }
 
     // Create monitoring functions
     for (int i = 0; i < Method::kCount; ++i) {
-      if (i == Method::kRead || i == Method::kWrite)
+      if (i == Method::kRead || i == Method::kWrite || i == Method::kReadV ||
+          i == Method::kWriteV)
         continue;
       monitor_[i].Shape(hshm::Formatter::format("{}-method-{}", name_, i));
     }
@@ -83,6 +183,18 @@ public:
 
     // Allocate data
     InitialStats(dev_size);
+    alloc_.Init(1, dev_size, align_);
+    dev_size_ = dev_size;
+    checksum_errors_ = 0;
+    if (url_.checksum_) {
+      crc_chunk_ = std::max(kCrcChunkSize, align_);
+      crcs_ = std::vector<std::atomic<u64>>((dev_size + crc_chunk_ - 1) /
+                                            crc_chunk_);
+      for (u32 i = 0; i < kNumCrcLocks; ++i) {
+        crc_locks_[i].SetName(
+            hshm::Formatter::format("bdev.{}.crc_lock.{}", name_, i));
+      }
+    }
 
     HILOG(
         kInfo,
@@ -93,21 +205,215 @@ public:
         io_perf_[kWrite].lat_.consts_[1]);
   }
 
-  /** Open a memory segment */
+  /**
+   * Open a memory segment.
+   * The segment is mapped anonymously, optionally with hugepages
+   * (MAP_HUGETLB or THP), bound to a NUMA node, and pre-faulted so that
+   * the first burst of writes does not take a page fault per page.
+   * */
   void OpenMemory(size_t dev_size) {
-    // Allocate memory for ram disk
-    ram_ = (char *)malloc(dev_size);
-    if (ram_ == nullptr) {
-      HELOG(kError, "Failed to allocate memory for bdev");
+    // Pages must be advised and bound before they are faulted in
+    bool late_populate = url_.thp_ || url_.numa_node_ >= 0;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (url_.populate_ && !late_populate) {
+      flags |= MAP_POPULATE;
+    }
+    void *ram = MAP_FAILED;
+    if (url_.hugetlb_) {
+      ram_size_ =
+          (dev_size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+      ram = mmap(nullptr, ram_size_, PROT_READ | PROT_WRITE,
+                 flags | MAP_HUGETLB, -1, 0);
+      if (ram == MAP_FAILED) {
+        HELOG(kWarning, "Could not map {} bytes of hugepages ({}), using "
+              "regular pages", ram_size_, strerror(errno));
+      }
+    }
+    if (ram == MAP_FAILED) {
+      ram_size_ = dev_size;
+      ram = mmap(nullptr, ram_size_, PROT_READ | PROT_WRITE, flags, -1, 0);
+      if (ram == MAP_FAILED) {
+        HELOG(kError, "Failed to allocate memory for bdev: {}",
+              strerror(errno));
+        ram_ = nullptr;
+        ram_size_ = 0;
+        return;
+      }
+      if (url_.thp_ && madvise(ram, ram_size_, MADV_HUGEPAGE) != 0) {
+        HELOG(kWarning, "Transparent hugepages unavailable: {}",
+              strerror(errno));
+      }
+    }
+    ram_ = (char *)ram;
+    if (url_.numa_node_ >= 0) {
+      BindMemory(url_.numa_node_);
+    }
+    if (url_.populate_ && late_populate) {
+      PrefaultMemory();
+    }
+  }
+
+  /** Bind the memory segment to a NUMA node */
+  void BindMemory(int node) {
+    constexpr int kBitsPerLong = 8 * sizeof(unsigned long);
+    unsigned long nodemask[kMaxNumaNodes / kBitsPerLong] = {0};
+    if (node >= kMaxNumaNodes) {
+      HELOG(kWarning, "NUMA node {} is out of range", node);
       return;
     }
+    nodemask[node / kBitsPerLong] |= 1UL << (node % kBitsPerLong);
+    if (syscall(SYS_mbind, ram_, ram_size_, MPOL_BIND, nodemask,
+                kMaxNumaNodes + 1, 0) != 0) {
+      HELOG(kWarning, "Could not bind bdev memory to NUMA node {}: {}", node,
+            strerror(errno));
+    }
   }
 
-  /** Open a POSIX file */
+  /** Fault in every page of the memory segment */
+  void PrefaultMemory() {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(ram_, ram_size_, MADV_POPULATE_WRITE) == 0) {
+      return;
+    }
+#endif
+    size_t page_size = getpagesize();
+    for (size_t off = 0; off < ram_size_; off += page_size) {
+      ram_[off] = 0;
+    }
+  }
+
+  /**
+   * Copy to or from the memory segment.
+   * Large transfers use non-temporal stores, which keep a burst from
+   * evicting the working set of the cache.
+   * */
+  static void StreamCopy(char *dst, const char *src, size_t size) {
+#if defined(__SSE2__)
+    if (size < kStreamCutoff) {
+      memcpy(dst, src, size);
+      return;
+    }
+    // Streaming stores require an aligned destination
+    size_t head = (16 - (size_t)dst % 16) % 16;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+    size_t body = size - size % 64;
+    for (size_t i = 0; i < body; i += 64) {
+      __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+      __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 16));
+      __m128i c = _mm_loadu_si128((const __m128i *)(src + i + 32));
+      __m128i d = _mm_loadu_si128((const __m128i *)(src + i + 48));
+      _mm_stream_si128((__m128i *)(dst + i), a);
+      _mm_stream_si128((__m128i *)(dst + i + 16), b);
+      _mm_stream_si128((__m128i *)(dst + i + 32), c);
+      _mm_stream_si128((__m128i *)(dst + i + 48), d);
+    }
+    _mm_sfence();
+    memcpy(dst + body, src + body, size - body);
+#else
+    memcpy(dst, src, size);
+#endif
+  }
+
+  /** Write or read a buffer at an offset in the memory segment */
+  template <bool IS_WRITE>
+  bool MemoryIo(char *data, size_t size, size_t off) {
+    if (ram_ == nullptr || off + size > ram_size_) {
+      HELOG(kWarning, "Out of bounds bdev memory access (off={}, size={}, "
+            "cap={})", off, size, ram_size_);
+      return false;
+    }
+    if constexpr (IS_WRITE) {
+      StreamCopy(ram_ + off, data, size);
+    } else {
+      StreamCopy(data, ram_ + off, size);
+    }
+    return true;
+  }
+
+  /** The number of devices the bdev is striped across */
+  u32 GetNumDevices() {
+    if (url_.scheme_ != BlockUrl::kFs) {
+      return 1;
+    }
+    return url_.paths_.size();
+  }
+
+  /**
+   * Open a POSIX file per device.
+   * When striped, the stripe unit is rounded up to the alignment of
+   * the devices and each file holds every n-th stripe.
+   * */
   void OpenPosix(size_t dev_size) {
-    // Open file for read & write, no override
-    fd_ = open64(url_.path_.c_str(), O_RDWR | O_CREAT, 0666);
-    ftruncate64(fd_, dev_size);
+    fds_.clear();
+    for (const std::string &path : url_.paths_) {
+      // Open file for read & write, no override
+      int fd = -1;
+      if (url_.direct_) {
+        fd = open64(path.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0666);
+        if (fd < 0) {
+          HELOG(kWarning,
+                "Could not open {} with O_DIRECT ({}), using buffered", path,
+                strerror(errno));
+        } else {
+          align_ = std::max(align_, GetLogicalBlockSize(fd));
+        }
+      }
+      if (fd < 0) {
+        fd = open64(path.c_str(), O_RDWR | O_CREAT, 0666);
+      }
+      if (fd < 0) {
+        HELOG(kFatal, "Could not open {}: {}", path, strerror(errno));
+      }
+      fds_.emplace_back(fd);
+    }
+    size_t file_size = dev_size;
+    if (fds_.size() > 1) {
+      stripe_size_ = url_.stripe_size_ ? url_.stripe_size_ : MEGABYTES(1);
+      stripe_size_ = (stripe_size_ + align_ - 1) / align_ * align_;
+      size_t num_stripes = (dev_size + stripe_size_ - 1) / stripe_size_;
+      file_size =
+          (num_stripes + fds_.size() - 1) / fds_.size() * stripe_size_;
+    }
+    for (int fd : fds_) {
+      ftruncate64(fd, file_size);
+    }
+  }
+
+  /** Get the alignment O_DIRECT requires of buffers, offsets and sizes */
+  size_t GetLogicalBlockSize(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      return KILOBYTES(4);
+    }
+    if (S_ISBLK(st.st_mode)) {
+      int sector_size;
+      if (ioctl(fd, BLKSSZGET, &sector_size) == 0) {
+        return sector_size;
+      }
+    }
+    // The filesystem block size always satisfies O_DIRECT for files
+    return st.st_blksize;
+  }
+
+  /**
+   * Map the start of a range of the bdev to its device.
+   * Returns the device, and the offset and length of the part of the
+   * range which lies in the same stripe.
+   * */
+  u32 MapStripe(size_t off, size_t size, size_t &dev_off, size_t &dev_size) {
+    if (stripe_size_ == 0) {
+      dev_off = off;
+      dev_size = size;
+      return 0;
+    }
+    size_t stripe = off / stripe_size_;
+    size_t stripe_off = off % stripe_size_;
+    dev_off = (stripe / fds_.size()) * stripe_size_ + stripe_off;
+    dev_size = std::min(size, stripe_size_ - stripe_off);
+    return stripe % fds_.size();
   }
 
   /** Open a CUDA file */
@@ -118,7 +424,7 @@ public:
       return;
     }
     memset((void *)&cf_descr_, 0, sizeof(CUfileDescr_t));
-    cf_descr_.handle.fd = fd_;
+    cf_descr_.handle.fd = fds_[0];
     cf_descr_.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
     cf_status_ = cuFileHandleRegister(&cf_handle_, &cf_descr_);
     if (cf_status_.err != CU_FILE_SUCCESS) {
@@ -138,12 +444,13 @@ public:
       hshm::Timer time;
       lat_cutoff_ = KILOBYTES(16);
       size_t bw_cutoff = MEGABYTES(16);
-      std::vector<char> data(bw_cutoff);
+      AlignedBuffer data(bw_cutoff, align_);
+      int fd = fds_[0];  // Calibrate against the first device
 
       // Write 16KB to the beginning with pwrite
       time.Resume();
-      ret = pwrite64(fd_, data.data(), lat_cutoff_, 0);
-      fsync(fd_);
+      ret = pwrite64(fd, data.data(), lat_cutoff_, 0);
+      fsync(fd);
       time.Pause();
       io_perf_[kWrite].lat_.consts_[0] = 0;
       io_perf_[kWrite].lat_.consts_[1] = (float)time.GetNsec();
@@ -151,8 +458,8 @@ public:
 
       // Write 64MB to the beginning with pwrite
       time.Resume();
-      ret = pwrite64(fd_, data.data(), bw_cutoff, 0);
-      fsync(fd_);
+      ret = pwrite64(fd, data.data(), bw_cutoff, 0);
+      fsync(fd);
       time.Pause();
       io_perf_[kWrite].bw_.consts_[0] = (float)(bw_cutoff / time.GetNsec());
       io_perf_[kWrite].bw_.consts_[1] = 0;
@@ -160,8 +467,8 @@ public:
 
       // Read 16KB from the beginning with pread
       time.Resume();
-      ret = pread64(fd_, data.data(), lat_cutoff_, 0);
-      fsync(fd_);
+      ret = pread64(fd, data.data(), lat_cutoff_, 0);
+      fsync(fd);
       time.Pause();
       io_perf_[kRead].lat_.consts_[0] = 0;
       io_perf_[kRead].lat_.consts_[1] = (float)time.GetNsec();
@@ -169,8 +476,8 @@ public:
 
       // Read 64MB from the beginning with pread
       time.Resume();
-      ret = pread64(fd_, data.data(), bw_cutoff, 0);
-      fsync(fd_);
+      ret = pread64(fd, data.data(), bw_cutoff, 0);
+      fsync(fd);
       time.Pause();
       io_perf_[kRead].bw_.consts_[0] = (float)(bw_cutoff / time.GetNsec());
       io_perf_[kRead].bw_.consts_[1] = 0;
@@ -179,24 +486,43 @@ public:
     }
     case BlockUrl::kRam: {
       OpenMemory(dev_size);
+      if (ram_ == nullptr) {
+        break;
+      }
 
       // Tuning parameters
       hshm::Timer time;
-      size_t bw_cutoff = MEGABYTES(16);
+      size_t bw_cutoff = std::min<size_t>(MEGABYTES(16), ram_size_);
+      lat_cutoff_ = std::min<size_t>(KILOBYTES(16), bw_cutoff);
       std::vector<char> data(bw_cutoff);
 
-      // Write 1MB to the beginning with pw
-      // rite
+      // Write 16KB to the beginning
+      time.Resume();
+      MemoryIo<true>(data.data(), lat_cutoff_, 0);
+      time.Pause();
+      io_perf_[kWrite].lat_.consts_[0] = 0;
+      io_perf_[kWrite].lat_.consts_[1] = (float)time.GetNsec();
+      time.Reset();
+
+      // Write 16MB to the beginning
       time.Resume();
-      memcpy(ram_, data.data(), bw_cutoff);
+      MemoryIo<true>(data.data(), bw_cutoff, 0);
       time.Pause();
       io_perf_[kWrite].bw_.consts_[0] = (float)(bw_cutoff / time.GetNsec());
       io_perf_[kWrite].bw_.consts_[1] = 0;
       time.Reset();
 
-      // Read 1MB from the beginning with pread
+      // Read 16KB from the beginning
+      time.Resume();
+      MemoryIo<false>(data.data(), lat_cutoff_, 0);
+      time.Pause();
+      io_perf_[kRead].lat_.consts_[0] = 0;
+      io_perf_[kRead].lat_.consts_[1] = (float)time.GetNsec();
+      time.Reset();
+
+      // Read 16MB from the beginning
       time.Resume();
-      memcpy(data.data(), ram_, bw_cutoff);
+      MemoryIo<false>(data.data(), bw_cutoff, 0);
       time.Pause();
       io_perf_[kRead].bw_.consts_[0] = (float)(bw_cutoff / time.GetNsec());
       io_perf_[kRead].bw_.consts_[1] = 0;
@@ -213,13 +539,44 @@ public:
     AverageMonitor(Method::kCreate, mode, rctx);
   }
 
-  /** Route a task to a bdev lane */
+  /** Get the bdev offset an I/O task starts at */
+  size_t GetTaskOffset(const Task *task) {
+    switch (task->method_) {
+    case Method::kRead: {
+      return reinterpret_cast<const ReadTask *>(task)->off_;
+    }
+    case Method::kWrite: {
+      return reinterpret_cast<const WriteTask *>(task)->off_;
+    }
+    case Method::kReadV: {
+      auto &segs = reinterpret_cast<const ReadVTask *>(task)->segs_;
+      return segs.size() ? segs[0].off_ : 0;
+    }
+    case Method::kWriteV: {
+      auto &segs = reinterpret_cast<const WriteVTask *>(task)->segs_;
+      return segs.size() ? segs[0].off_ : 0;
+    }
+    default: {
+      return 0;
+    }
+    }
+  }
+
+  /**
+   * Route a task to a bdev lane.
+   * I/O goes to a lane of the device holding its first byte. An I/O which
+   * spans several devices is split there into a subtask per device.
+   * */
   Lane *MapTaskToLane(const Task *task) override {
     switch (task->method_) {
     case Method::kRead:
-    case Method::kWrite: {
+    case Method::kWrite:
+    case Method::kReadV:
+    case Method::kWriteV: {
+      size_t dev_off, dev_size;
+      u32 dev = MapStripe(GetTaskOffset(task), 0, dev_off, dev_size);
       return GetLeastLoadedLane(
-          kDataGroup, task->prio_,
+          kDataGroup + dev, task->prio_,
           [](Load &lhs, Load &rhs) { return lhs.cpu_load_ < rhs.cpu_load_; });
     }
     default: {
@@ -229,7 +586,12 @@ public:
   }
 
   /** Destroy bdev */
-  void Destroy(DestroyTask *task, RunContext &rctx) {}
+  void Destroy(DestroyTask *task, RunContext &rctx) {
+    if (url_.scheme_ == BlockUrl::kRam && ram_) {
+      munmap(ram_, ram_size_);
+      ram_ = nullptr;
+    }
+  }
   void MonitorDestroy(MonitorModeId mode, DestroyTask *task, RunContext &rctx) {
     AverageMonitor(Method::kDestroy, mode, rctx);
   }
@@ -247,11 +609,88 @@ public:
   void Free(FreeTask *task, RunContext &rctx) { alloc_.Free(0, task->block_); }
   void MonitorFree(MonitorModeId mode, FreeTask *task, RunContext &rctx) {}
 
+  /** Free a batch of sections of the block device */
+  void FreeBatch(FreeBatchTask *task, RunContext &rctx) {
+    alloc_.FreeBatch(0, task->blocks_);
+  }
+  void MonitorFreeBatch(MonitorModeId mode, FreeBatchTask *task,
+                        RunContext &rctx) {
+    AverageMonitor(Method::kFreeBatch, mode, rctx);
+  }
+
+  /** Whether an I/O can be submitted to the file as-is */
+  bool IsDirectAligned(const char *data, size_t size, size_t off) {
+    return (size_t)data % align_ == 0 && size % align_ == 0 &&
+           off % align_ == 0;
+  }
+
+  /**
+   * Write or read a buffer at an offset of the bdev with POSIX,
+   * splitting it at stripe boundaries.
+   * */
+  template <bool IS_WRITE>
+  bool PosixIo(char *data, size_t size, size_t off) {
+    while (size > 0) {
+      size_t dev_off, dev_size;
+      u32 dev = MapStripe(off, size, dev_off, dev_size);
+      if (!DevicePosixIo<IS_WRITE>(fds_[dev], data, dev_size, dev_off)) {
+        return false;
+      }
+      data += dev_size;
+      off += dev_size;
+      size -= dev_size;
+    }
+    return true;
+  }
+
+  /**
+   * Write or read a buffer at an offset of a single device with POSIX.
+   * With O_DIRECT, a misaligned I/O is bounced through an aligned buffer
+   * spanning the logical blocks it touches. Partial blocks are read first
+   * so a write preserves the bytes around it. A short read near the end
+   * of the file is zero-filled rather than written back as garbage.
+   * */
+  template <bool IS_WRITE>
+  bool DevicePosixIo(int fd, char *data, size_t size, size_t off) {
+    if (IsDirectAligned(data, size, off)) {
+      ssize_t ret;
+      if constexpr (IS_WRITE) {
+        ret = pwrite64(fd, data, size, off);
+      } else {
+        ret = pread64(fd, data, size, off);
+      }
+      return ret == size;
+    }
+    size_t io_off = off - off % align_;
+    size_t io_size = alloc_.AlignUp(off + size) - io_off;
+    AlignedBuffer bounce(io_size, align_);
+    if (bounce.data() == nullptr) {
+      return false;
+    }
+    if constexpr (IS_WRITE) {
+      if (io_off != off || io_size != size) {
+        ssize_t ret = pread64(fd, bounce.data(), io_size, io_off);
+        if (ret < 0) {
+          return false;
+        }
+        // Bytes past the end of the file read back as zeros
+        memset(bounce.data() + ret, 0, io_size - ret);
+      }
+      memcpy(bounce.data() + (off - io_off), data, size);
+      return pwrite64(fd, bounce.data(), io_size, io_off) == io_size;
+    } else {
+      if (pread64(fd, bounce.data(), io_size, io_off) != io_size) {
+        return false;
+      }
+      memcpy(data, bounce.data() + (off - io_off), size);
+      return true;
+    }
+  }
+
   /** Write to a block device with POSIX */
   void WritePosix(WriteTask *task, RunContext &rctx) {
     char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
-    ssize_t ret = pwrite64(fd_, data, task->size_, task->off_);
-    if (ret == task->size_) {
+    if (PosixIo<true>(data, task->size_, task->off_)) {
       task->success_ = true;
     } else {
       HELOG(kWarning, "Failed to write to bdev (off={}, size={}): {}",
@@ -263,14 +702,14 @@ public:
   /** Write to a block device with memory */
   void WriteMemory(WriteTask *task, RunContext &rctx) {
     char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
-    memcpy(ram_ + task->off_, data, task->size_);
-    task->success_ = true;
+    task->success_ = MemoryIo<true>(data, task->size_, task->off_);
   }
 
   /** Write data with GPU memory */
   void WriteGpu(WriteTask *task, RunContext &rctx) {
 #if defined(CHIMAERA_ENABLE_CUDA)
-    if (cf_status_.err == CU_FILE_SUCCESS) {
+    // cuFile is only registered for the first device
+    if (cf_status_.err == CU_FILE_SUCCESS && stripe_size_ == 0) {
       WriteCufile(task, rctx);
     } else {
       WriteCudaCopy(task, rctx);
@@ -296,8 +735,7 @@ public:
       task->success_ = false;
       return;
     }
-    ssize_t ret = pwrite64(fd_, cpu_data.data(), task->size_, task->off_);
-    if (ret == task->size_) {
+    if (PosixIo<true>(cpu_data.data(), task->size_, task->off_)) {
       task->success_ = true;
     } else {
       HELOG(kWarning, "Failed to write to bdev (off={}, size={}): {}",
@@ -320,8 +758,7 @@ public:
       task->success_ = false;
       return;
     }
-    ssize_t ret = pwrite64(fd_, cpu_data.data(), task->size_, task->off_);
-    if (ret == task->size_) {
+    if (PosixIo<true>(cpu_data.data(), task->size_, task->off_)) {
       task->success_ = true;
     } else {
       HELOG(kWarning, "Failed to write to bdev (off={}, size={}): {}",
@@ -364,7 +801,23 @@ public:
 
   /** Write to the block device */
   void Write(WriteTask *task, RunContext &rctx) {
+    std::vector<std::vector<IoSegment>> dev_segs;
+    if (SplitByDevice({IoSegment{task->data_, task->size_, task->off_}},
+                      dev_segs)) {
+      task->success_ = RunDevicePieces<WriteVTask>(
+          task, dev_segs,
+          [this, task](const DomainQuery &dom_query,
+                       const std::vector<IoSegment> &segs) {
+            return client_.AsyncWriteV(HSHM_MCTX, dom_query, segs,
+                                       task->tenant_);
+          });
+      return;
+    }
+    Throttle(task, task->tenant_, task->size_);
     char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+    std::vector<u32> stripes;
+    GetCrcStripes(task->size_, task->off_, stripes);
+    ScopedCrcLock crc_lock(crc_locks_, std::move(stripes), true);
     switch (url_.scheme_) {
     case BlockUrl::kFs: {
       if (CHI_CLIENT->IsGpuDataPointer(task->data_)) {
@@ -376,11 +829,17 @@ public:
     }
     case BlockUrl::kRam: {
       WriteMemory(task, rctx);
+      break;
     }
     case BlockUrl::kSpdk: {
       break;
     }
     }
+    if (url_.checksum_ && task->success_) {
+      bool gpu = CHI_CLIENT->IsGpuDataPointer(task->data_);
+      task->success_ =
+          UpdateChecksums(gpu ? nullptr : data, task->size_, task->off_);
+    }
   }
   void MonitorWrite(MonitorModeId mode, WriteTask *task, RunContext &rctx) {
     IoMonitor(mode, task->size_, io_perf_[kWrite], rctx);
@@ -389,8 +848,7 @@ public:
   /** Read from a block device with POSIX */
   void ReadPosix(ReadTask *task, RunContext &rctx) {
     char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
-    ssize_t ret = pread64(fd_, data, task->size_, task->off_);
-    if (ret == task->size_) {
+    if (PosixIo<false>(data, task->size_, task->off_)) {
       task->success_ = true;
     } else {
       HELOG(kWarning, "Failed to read from bdev (off={}, size={}): {}",
@@ -402,14 +860,14 @@ public:
   /** Read from a block device with memory */
   void ReadMemory(ReadTask *task, RunContext &rctx) {
     char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
-    memcpy(data, ram_ + task->off_, task->size_);
-    task->success_ = true;
+    task->success_ = MemoryIo<false>(data, task->size_, task->off_);
   }
 
   /** Read from a GPU memory */
   void ReadGpu(ReadTask *task, RunContext &rctx) {
 #if defined(CHIMAERA_ENABLE_CUDA)
-    if (cf_status_.err == CU_FILE_SUCCESS) {
+    // cuFile is only registered for the first device
+    if (cf_status_.err == CU_FILE_SUCCESS && stripe_size_ == 0) {
       ReadCufile(task, rctx);
     } else {
       ReadCudaCopy(task, rctx);
@@ -466,8 +924,7 @@ public:
       task->success_ = false;
       return;
     }
-    ssize_t ret = pread64(fd_, cpu_data.data(), task->size_, task->off_);
-    if (ret == task->size_) {
+    if (PosixIo<false>(cpu_data.data(), task->size_, task->off_)) {
       task->success_ = true;
     } else {
       HELOG(kWarning, "Failed to read from bdev (off={}, size={}): {}",
@@ -490,8 +947,7 @@ public:
       task->success_ = false;
       return;
     }
-    ssize_t ret = pread64(fd_, cpu_data.data(), task->size_, task->off_);
-    if (ret == task->size_) {
+    if (PosixIo<false>(cpu_data.data(), task->size_, task->off_)) {
       task->success_ = true;
     } else {
       HELOG(kWarning, "Failed to read from bdev (off={}, size={}): {}",
@@ -503,7 +959,23 @@ public:
 
   /** Read from the block device */
   void Read(ReadTask *task, RunContext &rctx) {
+    std::vector<std::vector<IoSegment>> dev_segs;
+    if (SplitByDevice({IoSegment{task->data_, task->size_, task->off_}},
+                      dev_segs)) {
+      task->success_ = RunDevicePieces<ReadVTask>(
+          task, dev_segs,
+          [this, task](const DomainQuery &dom_query,
+                       const std::vector<IoSegment> &segs) {
+            return client_.AsyncReadV(HSHM_MCTX, dom_query, segs,
+                                      task->tenant_);
+          });
+      return;
+    }
+    Throttle(task, task->tenant_, task->size_);
     char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+    std::vector<u32> stripes;
+    GetCrcStripes(task->size_, task->off_, stripes);
+    ScopedCrcLock crc_lock(crc_locks_, std::move(stripes), false);
     switch (url_.scheme_) {
     case BlockUrl::kFs: {
       if (CHI_CLIENT->IsGpuDataPointer(task->data_)) {
@@ -514,17 +986,377 @@ public:
       break;
     }
     case BlockUrl::kRam: {
+      ReadMemory(task, rctx);
       break;
     }
     case BlockUrl::kSpdk: {
       break;
     }
     }
+    if (url_.checksum_ && task->success_) {
+      bool gpu = CHI_CLIENT->IsGpuDataPointer(task->data_);
+      task->success_ =
+          VerifyChecksums(gpu ? nullptr : data, task->size_, task->off_);
+    }
   }
   void MonitorRead(MonitorModeId mode, ReadTask *task, RunContext &rctx) {
     IoMonitor(mode, task->size_, io_perf_[kRead], rctx);
   }
 
+  /**
+   * Perform vectored I/O with POSIX.
+   * Segments which are contiguous on the same device are submitted
+   * together as a single pwritev / preadv. With O_DIRECT, misaligned
+   * segments and segments crossing a stripe are submitted on their own.
+   * */
+  template <bool IS_WRITE>
+  bool VectorIoPosix(chi::ipc::vector<IoSegment> &segs) {
+    std::vector<struct iovec> iov;
+    iov.reserve(std::min<size_t>(segs.size(), IOV_MAX));
+    size_t i = 0;
+    while (i < segs.size()) {
+      u32 dev = 0;
+      size_t off = 0;
+      size_t size = 0;
+      iov.clear();
+      while (i < segs.size() && iov.size() < IOV_MAX) {
+        IoSegment &seg = segs[i];
+        char *data = HSHM_MEMORY_MANAGER->Convert<char>(seg.data_);
+        size_t dev_off, dev_size;
+        u32 seg_dev = MapStripe(seg.off_, seg.size_, dev_off, dev_size);
+        if (dev_size != seg.size_ ||
+            !IsDirectAligned(data, seg.size_, dev_off)) {
+          break;
+        }
+        if (iov.empty()) {
+          dev = seg_dev;
+          off = dev_off;
+        } else if (seg_dev != dev || dev_off != off + size) {
+          break;
+        }
+        iov.emplace_back((struct iovec){data, seg.size_});
+        size += seg.size_;
+        ++i;
+      }
+      if (iov.empty()) {
+        IoSegment &seg = segs[i++];
+        char *data = HSHM_MEMORY_MANAGER->Convert<char>(seg.data_);
+        if (!PosixIo<IS_WRITE>(data, seg.size_, seg.off_)) {
+          HELOG(kWarning, "Failed to {} bdev (off={}, size={}): {}",
+                IS_WRITE ? "write to" : "read from", seg.off_, seg.size_,
+                strerror(errno));
+          return false;
+        }
+        continue;
+      }
+      ssize_t ret;
+      if constexpr (IS_WRITE) {
+        ret = pwritev64(fds_[dev], iov.data(), iov.size(), off);
+      } else {
+        ret = preadv64(fds_[dev], iov.data(), iov.size(), off);
+      }
+      if (ret != size) {
+        HELOG(kWarning,
+              "Failed to {} bdev (dev={}, off={}, size={}, segs={}): {}",
+              IS_WRITE ? "write to" : "read from", dev, off, size, iov.size(),
+              strerror(errno));
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Copy the segments of a vectored I/O out of shared memory */
+  std::vector<IoSegment> CopySegments(chi::ipc::vector<IoSegment> &segs) {
+    std::vector<IoSegment> copy;
+    copy.reserve(segs.size());
+    for (size_t i = 0; i < segs.size(); ++i) {
+      copy.emplace_back(segs[i]);
+    }
+    return copy;
+  }
+
+  /**
+   * Group the pieces of a striped file I/O by the device holding them.
+   * Returns false if the I/O touches a single device, or lives in GPU
+   * memory, so it runs on the lane it was routed to.
+   * */
+  bool SplitByDevice(const std::vector<IoSegment> &segs,
+                     std::vector<std::vector<IoSegment>> &dev_segs) {
+    if (stripe_size_ == 0 || url_.scheme_ != BlockUrl::kFs) {
+      return false;
+    }
+    dev_segs.clear();
+    dev_segs.resize(fds_.size());
+    size_t num_devs = 0;
+    for (const IoSegment &seg : segs) {
+      if (CHI_CLIENT->IsGpuDataPointer(seg.data_)) {
+        return false;
+      }
+      size_t done = 0;
+      while (done < seg.size_) {
+        size_t dev_off, dev_size;
+        u32 dev =
+            MapStripe(seg.off_ + done, seg.size_ - done, dev_off, dev_size);
+        if (dev_segs[dev].empty()) {
+          ++num_devs;
+        }
+        dev_segs[dev].emplace_back(
+            IoSegment{seg.data_ + done, dev_size, seg.off_ + done});
+        done += dev_size;
+      }
+    }
+    return num_devs > 1;
+  }
+
+  /**
+   * Submit the pieces of each device as a vectored subtask, which is
+   * routed to that device's lanes, and wait for all of them.
+   * */
+  template <typename TaskT, typename AsyncF>
+  bool RunDevicePieces(Task *task,
+                       std::vector<std::vector<IoSegment>> &dev_segs,
+                       AsyncF &&async_io) {
+    DomainQuery dom_query =
+        DomainQuery::GetDirectId(SubDomain::kGlobalContainers, container_id_);
+    std::vector<FullPtr<TaskT>> subtasks;
+    for (std::vector<IoSegment> &segs : dev_segs) {
+      if (!segs.empty()) {
+        subtasks.emplace_back(async_io(dom_query, segs));
+      }
+    }
+    task->Wait(subtasks);
+    bool success = true;
+    for (FullPtr<TaskT> &subtask : subtasks) {
+      success &= subtask->success_;
+      CHI_CLIENT->DelTask(HSHM_MCTX, subtask);
+    }
+    return success;
+  }
+
+  /** Whether any segment of a vectored I/O lives in GPU memory */
+  bool HasGpuSegment(chi::ipc::vector<IoSegment> &segs) {
+    for (size_t i = 0; i < segs.size(); ++i) {
+      if (CHI_CLIENT->IsGpuDataPointer(segs[i].data_)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Write a set of segments to the block device */
+  void WriteV(WriteVTask *task, RunContext &rctx) {
+    std::vector<std::vector<IoSegment>> dev_segs;
+    if (SplitByDevice(CopySegments(task->segs_), dev_segs)) {
+      task->success_ = RunDevicePieces<WriteVTask>(
+          task, dev_segs,
+          [this, task](const DomainQuery &dom_query,
+                       const std::vector<IoSegment> &segs) {
+            return client_.AsyncWriteV(HSHM_MCTX, dom_query, segs,
+                                       task->tenant_);
+          });
+      return;
+    }
+    Throttle(task, task->tenant_, task->GetSize());
+    std::vector<u32> stripes;
+    for (size_t i = 0; i < task->segs_.size(); ++i) {
+      GetCrcStripes(task->segs_[i].size_, task->segs_[i].off_, stripes);
+    }
+    ScopedCrcLock crc_lock(crc_locks_, std::move(stripes), true);
+    switch (url_.scheme_) {
+    case BlockUrl::kFs: {
+      if (HasGpuSegment(task->segs_)) {
+        HELOG(kWarning, "Vectored GPU write not supported");
+        task->success_ = false;
+      } else {
+        task->success_ = VectorIoPosix<true>(task->segs_);
+      }
+      break;
+    }
+    case BlockUrl::kRam: {
+      task->success_ = true;
+      for (size_t i = 0; i < task->segs_.size() && task->success_; ++i) {
+        IoSegment &seg = task->segs_[i];
+        char *data = HSHM_MEMORY_MANAGER->Convert<char>(seg.data_);
+        task->success_ = MemoryIo<true>(data, seg.size_, seg.off_);
+      }
+      break;
+    }
+    case BlockUrl::kSpdk: {
+      break;
+    }
+    }
+    for (size_t i = 0; url_.checksum_ && task->success_ &&
+                       i < task->segs_.size(); ++i) {
+      IoSegment &seg = task->segs_[i];
+      char *data = HSHM_MEMORY_MANAGER->Convert<char>(seg.data_);
+      task->success_ = UpdateChecksums(data, seg.size_, seg.off_);
+    }
+  }
+  void MonitorWriteV(MonitorModeId mode, WriteVTask *task, RunContext &rctx) {
+    IoMonitor(mode, task->GetSize(), io_perf_[kWrite], rctx);
+  }
+
+  /** Read a set of segments from the block device */
+  void ReadV(ReadVTask *task, RunContext &rctx) {
+    std::vector<std::vector<IoSegment>> dev_segs;
+    if (SplitByDevice(CopySegments(task->segs_), dev_segs)) {
+      task->success_ = RunDevicePieces<ReadVTask>(
+          task, dev_segs,
+          [this, task](const DomainQuery &dom_query,
+                       const std::vector<IoSegment> &segs) {
+            return client_.AsyncReadV(HSHM_MCTX, dom_query, segs,
+                                      task->tenant_);
+          });
+      return;
+    }
+    Throttle(task, task->tenant_, task->GetSize());
+    std::vector<u32> stripes;
+    for (size_t i = 0; i < task->segs_.size(); ++i) {
+      GetCrcStripes(task->segs_[i].size_, task->segs_[i].off_, stripes);
+    }
+    ScopedCrcLock crc_lock(crc_locks_, std::move(stripes), false);
+    switch (url_.scheme_) {
+    case BlockUrl::kFs: {
+      if (HasGpuSegment(task->segs_)) {
+        HELOG(kWarning, "Vectored GPU read not supported");
+        task->success_ = false;
+      } else {
+        task->success_ = VectorIoPosix<false>(task->segs_);
+      }
+      break;
+    }
+    case BlockUrl::kRam: {
+      task->success_ = true;
+      for (size_t i = 0; i < task->segs_.size() && task->success_; ++i) {
+        IoSegment &seg = task->segs_[i];
+        char *data = HSHM_MEMORY_MANAGER->Convert<char>(seg.data_);
+        task->success_ = MemoryIo<false>(data, seg.size_, seg.off_);
+      }
+      break;
+    }
+    case BlockUrl::kSpdk: {
+      break;
+    }
+    }
+    for (size_t i = 0; url_.checksum_ && task->success_ &&
+                       i < task->segs_.size(); ++i) {
+      IoSegment &seg = task->segs_[i];
+      char *data = HSHM_MEMORY_MANAGER->Convert<char>(seg.data_);
+      task->success_ = VerifyChecksums(data, seg.size_, seg.off_);
+    }
+  }
+  void MonitorReadV(MonitorModeId mode, ReadVTask *task, RunContext &rctx) {
+    IoMonitor(mode, task->GetSize(), io_perf_[kRead], rctx);
+  }
+
+  /**
+   * Get the checksum lock stripes of the chunks an I/O touches.
+   * Nothing is locked when checksums are disabled.
+   * */
+  void GetCrcStripes(size_t size, size_t off, std::vector<u32> &stripes) {
+    if (!url_.checksum_ || size == 0) {
+      return;
+    }
+    size_t first = off / crc_chunk_;
+    size_t last = std::min((off + size - 1) / crc_chunk_,
+                           first + kNumCrcLocks - 1);
+    for (size_t chunk = first; chunk <= last; ++chunk) {
+      stripes.emplace_back(chunk % kNumCrcLocks);
+    }
+  }
+
+  /**
+   * Compute the CRC of a checksum chunk touched by an I/O.
+   * The I/O buffer is used if it covers the whole chunk. Otherwise the
+   * chunk is read back from the device into \a buf.
+   * */
+  bool GetChunkCrc(size_t chunk, const char *data, size_t size, size_t off,
+                   std::unique_ptr<AlignedBuffer> &buf, u32 &crc) {
+    size_t chunk_off = chunk * crc_chunk_;
+    size_t chunk_size = std::min(crc_chunk_, dev_size_ - chunk_off);
+    if (data && off <= chunk_off && chunk_off + chunk_size <= off + size) {
+      crc = Crc32c::Compute(data + (chunk_off - off), chunk_size);
+      return true;
+    }
+    if (url_.scheme_ == BlockUrl::kRam) {
+      crc = Crc32c::Compute(ram_ + chunk_off, chunk_size);
+      return true;
+    }
+    if (!buf) {
+      buf = std::make_unique<AlignedBuffer>(crc_chunk_, align_);
+    }
+    if (!PosixIo<false>(buf->data(), chunk_size, chunk_off)) {
+      HELOG(kWarning, "Failed to read back bdev chunk (off={}): {}",
+            chunk_off, strerror(errno));
+      return false;
+    }
+    crc = Crc32c::Compute(buf->data(), chunk_size);
+    return true;
+  }
+
+  /** Record the checksums of the chunks a successful write touched */
+  bool UpdateChecksums(const char *data, size_t size, size_t off) {
+    if (size == 0) {
+      return true;
+    }
+    std::unique_ptr<AlignedBuffer> buf;
+    size_t last = (off + size - 1) / crc_chunk_;
+    for (size_t chunk = off / crc_chunk_; chunk <= last; ++chunk) {
+      u32 crc;
+      if (!GetChunkCrc(chunk, data, size, off, buf, crc)) {
+        return false;
+      }
+      crcs_[chunk].store(kCrcValid | crc, std::memory_order_release);
+    }
+    return true;
+  }
+
+  /** Verify the checksums of the written chunks a read touched */
+  bool VerifyChecksums(const char *data, size_t size, size_t off) {
+    if (size == 0) {
+      return true;
+    }
+    std::unique_ptr<AlignedBuffer> buf;
+    size_t last = (off + size - 1) / crc_chunk_;
+    for (size_t chunk = off / crc_chunk_; chunk <= last; ++chunk) {
+      u64 expected = crcs_[chunk].load(std::memory_order_acquire);
+      if (!(expected & kCrcValid)) {
+        continue;
+      }
+      u32 crc;
+      if (!GetChunkCrc(chunk, data, size, off, buf, crc)) {
+        return false;
+      }
+      if (crc != (u32)expected) {
+        HELOG(kError,
+              "Checksum mismatch on bdev {} (off={}, expected={}, actual={})",
+              url_.path_, chunk * crc_chunk_, (u32)expected, crc);
+        checksum_errors_ += 1;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Yield until the pool and tenant token buckets admit an I/O.
+   * The worker keeps running other tasks while this one waits.
+   * */
+  void Throttle(Task *task, u32 tenant, size_t size) {
+    while (!qos_.TryAdmit(tenant, size)) {
+      task->Yield();
+    }
+  }
+
+  /** Change the bandwidth and IOPS limits of the bdev */
+  void SetQos(SetQosTask *task, RunContext &rctx) {
+    qos_.SetLimits(task->tenant_, task->limits_);
+  }
+  void MonitorSetQos(MonitorModeId mode, SetQosTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kSetQos, mode, rctx);
+  }
+
   /** Poll block device statistics */
   void PollStats(PollStatsTask *task, RunContext &rctx) {
     task->stats_.read_bw_ = io_perf_[kRead].bw_.consts_[0];
@@ -533,6 +1365,7 @@ public:
     task->stats_.write_latency_ = io_perf_[kWrite].lat_.consts_[1];
     task->stats_.free_ = alloc_.free_size_;
     task->stats_.max_cap_ = alloc_.max_heap_size_;
+    task->stats_.checksum_errors_ = checksum_errors_.load();
   }
   void MonitorPollStats(MonitorModeId mode, PollStatsTask *task,
                         RunContext &rctx) {
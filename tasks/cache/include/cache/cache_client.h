@@ -0,0 +1,104 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef CHI_cache_H_
+#define CHI_cache_H_
+
+#include "cache_tasks.h"
+
+namespace chi::cache {
+
+/** Create cache requests */
+class Client : public ModuleClient {
+public:
+  /** Default constructor */
+  Client() = default;
+
+  /** Destructor */
+  ~Client() = default;
+
+  /** Create a cache in front of the bdev pool \a bdev_id */
+  HSHM_INLINE_CROSS_FUN
+  void Create(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+              const DomainQuery &affinity, const chi::string &pool_name,
+              const PoolId &bdev_id, size_t capacity,
+              size_t block_size = KILOBYTES(64),
+              u32 mode = CacheMode::kWriteThrough,
+              const CreateContext &ctx = CreateContext()) {
+    FullPtr<CreateTask> task =
+        AsyncCreate(mctx, dom_query, affinity, pool_name, ctx, bdev_id,
+                    capacity, block_size, mode);
+    task->Wait();
+    Init(task->ctx_.id_);
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(Create);
+
+  /** Destroy pool + queue */
+  HSHM_INLINE_CROSS_FUN
+  void Destroy(const hipc::MemContext &mctx, const DomainQuery &dom_query) {
+    CHI_ADMIN->DestroyContainer(mctx, dom_query, pool_id_);
+  }
+
+  /** Write to the cached bdev */
+  HSHM_INLINE_CROSS_FUN
+  bool Write(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+             const hipc::Pointer &data, size_t off, size_t size) {
+    FullPtr<WriteTask> task = AsyncWrite(mctx, dom_query, data, off, size);
+    task.ptr_->Wait();
+    bool success = task->success_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return success;
+  }
+  CHI_TASK_METHODS(Write);
+
+  /** Read from the cached bdev */
+  HSHM_INLINE_CROSS_FUN
+  bool Read(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+            const hipc::Pointer &data, size_t off, size_t size) {
+    FullPtr<ReadTask> task = AsyncRead(mctx, dom_query, data, off, size);
+    task.ptr_->Wait();
+    bool success = task->success_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return success;
+  }
+  CHI_TASK_METHODS(Read);
+
+  /** Write all dirty cache blocks back to the bdev */
+  HSHM_INLINE_CROSS_FUN
+  size_t Flush(const hipc::MemContext &mctx, const DomainQuery &dom_query) {
+    FullPtr<FlushTask> task = AsyncFlush(mctx, dom_query);
+    task.ptr_->Wait();
+    size_t count = task->count_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return count;
+  }
+  CHI_TASK_METHODS(Flush);
+
+  /** Get the statistics of the cache */
+  HSHM_INLINE_CROSS_FUN
+  CacheStats PollStats(const hipc::MemContext &mctx,
+                       const DomainQuery &dom_query) {
+    FullPtr<PollStatsTask> task = AsyncPollStats(mctx, dom_query);
+    task.ptr_->Wait();
+    CacheStats stats = task->stats_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return stats;
+  }
+  CHI_TASK_METHODS(PollStats);
+
+  CHI_AUTOGEN_METHODS // keep at class bottom
+};
+
+} // namespace chi::cache
+
+#endif // CHI_cache_H_
@@ -0,0 +1,401 @@
+#ifndef CHI_CACHE_LIB_EXEC_H_
+#define CHI_CACHE_LIB_EXEC_H_
+
+/** Execute a task */
+void Run(u32 method, Task *task, RunContext &rctx) override {
+  switch (method) {
+    case Method::kCreate: {
+      Create(reinterpret_cast<CreateTask *>(task), rctx);
+      break;
+    }
+    case Method::kDestroy: {
+      Destroy(reinterpret_cast<DestroyTask *>(task), rctx);
+      break;
+    }
+    case Method::kWrite: {
+      Write(reinterpret_cast<WriteTask *>(task), rctx);
+      break;
+    }
+    case Method::kRead: {
+      Read(reinterpret_cast<ReadTask *>(task), rctx);
+      break;
+    }
+    case Method::kFlush: {
+      Flush(reinterpret_cast<FlushTask *>(task), rctx);
+      break;
+    }
+    case Method::kPollStats: {
+      PollStats(reinterpret_cast<PollStatsTask *>(task), rctx);
+      break;
+    }
+  }
+}
+/** Execute a task */
+void Monitor(MonitorModeId mode, MethodId method, Task *task, RunContext &rctx) override {
+  switch (method) {
+    case Method::kCreate: {
+      MonitorCreate(mode, reinterpret_cast<CreateTask *>(task), rctx);
+      break;
+    }
+    case Method::kDestroy: {
+      MonitorDestroy(mode, reinterpret_cast<DestroyTask *>(task), rctx);
+      break;
+    }
+    case Method::kWrite: {
+      MonitorWrite(mode, reinterpret_cast<WriteTask *>(task), rctx);
+      break;
+    }
+    case Method::kRead: {
+      MonitorRead(mode, reinterpret_cast<ReadTask *>(task), rctx);
+      break;
+    }
+    case Method::kFlush: {
+      MonitorFlush(mode, reinterpret_cast<FlushTask *>(task), rctx);
+      break;
+    }
+    case Method::kPollStats: {
+      MonitorPollStats(mode, reinterpret_cast<PollStatsTask *>(task), rctx);
+      break;
+    }
+  }
+}
+/** Delete a task */
+void Del(const hipc::MemContext &mctx, u32 method, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      CHI_CLIENT->DelTask<CreateTask>(mctx, reinterpret_cast<CreateTask *>(task));
+      break;
+    }
+    case Method::kDestroy: {
+      CHI_CLIENT->DelTask<DestroyTask>(mctx, reinterpret_cast<DestroyTask *>(task));
+      break;
+    }
+    case Method::kWrite: {
+      CHI_CLIENT->DelTask<WriteTask>(mctx, reinterpret_cast<WriteTask *>(task));
+      break;
+    }
+    case Method::kRead: {
+      CHI_CLIENT->DelTask<ReadTask>(mctx, reinterpret_cast<ReadTask *>(task));
+      break;
+    }
+    case Method::kFlush: {
+      CHI_CLIENT->DelTask<FlushTask>(mctx, reinterpret_cast<FlushTask *>(task));
+      break;
+    }
+    case Method::kPollStats: {
+      CHI_CLIENT->DelTask<PollStatsTask>(mctx, reinterpret_cast<PollStatsTask *>(task));
+      break;
+    }
+  }
+}
+/** Duplicate a task */
+void CopyStart(u32 method, const Task *orig_task, Task *dup_task, bool deep) override {
+  switch (method) {
+    case Method::kCreate: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const CreateTask*>(orig_task), 
+        reinterpret_cast<CreateTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kDestroy: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const DestroyTask*>(orig_task), 
+        reinterpret_cast<DestroyTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kWrite: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const WriteTask*>(orig_task), 
+        reinterpret_cast<WriteTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kRead: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const ReadTask*>(orig_task), 
+        reinterpret_cast<ReadTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kFlush: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const FlushTask*>(orig_task), 
+        reinterpret_cast<FlushTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kPollStats: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const PollStatsTask*>(orig_task), 
+        reinterpret_cast<PollStatsTask*>(dup_task), deep);
+      break;
+    }
+  }
+}
+/** Duplicate a task */
+void NewCopyStart(u32 method, const Task *orig_task, FullPtr<Task> &dup_task, bool deep) override {
+  switch (method) {
+    case Method::kCreate: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const CreateTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kDestroy: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const DestroyTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kWrite: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const WriteTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kRead: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const ReadTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kFlush: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const FlushTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kPollStats: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const PollStatsTask*>(orig_task), dup_task, deep);
+      break;
+    }
+  }
+}
+/** Serialize a task when initially pushing into remote */
+void SaveStart(
+    u32 method, BinaryOutputArchive<true> &ar,
+    Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar << *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar << *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kWrite: {
+      ar << *reinterpret_cast<WriteTask*>(task);
+      break;
+    }
+    case Method::kRead: {
+      ar << *reinterpret_cast<ReadTask*>(task);
+      break;
+    }
+    case Method::kFlush: {
+      ar << *reinterpret_cast<FlushTask*>(task);
+      break;
+    }
+    case Method::kPollStats: {
+      ar << *reinterpret_cast<PollStatsTask*>(task);
+      break;
+    }
+  }
+}
+/** Deserialize a task when popping from remote queue */
+TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> &ar) override {
+  TaskPointer task_ptr;
+  switch (method) {
+    case Method::kCreate: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<CreateTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<CreateTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kDestroy: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<DestroyTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<DestroyTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kWrite: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<WriteTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<WriteTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kRead: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<ReadTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<ReadTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kFlush: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<FlushTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<FlushTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kPollStats: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<PollStatsTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<PollStatsTask*>(task_ptr.ptr_);
+      break;
+    }
+  }
+  return task_ptr;
+}
+/** Serialize a task when returning from remote queue */
+void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar << *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar << *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kWrite: {
+      ar << *reinterpret_cast<WriteTask*>(task);
+      break;
+    }
+    case Method::kRead: {
+      ar << *reinterpret_cast<ReadTask*>(task);
+      break;
+    }
+    case Method::kFlush: {
+      ar << *reinterpret_cast<FlushTask*>(task);
+      break;
+    }
+    case Method::kPollStats: {
+      ar << *reinterpret_cast<PollStatsTask*>(task);
+      break;
+    }
+  }
+}
+/** Deserialize a task when popping from remote queue */
+void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar >> *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar >> *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kWrite: {
+      ar >> *reinterpret_cast<WriteTask*>(task);
+      break;
+    }
+    case Method::kRead: {
+      ar >> *reinterpret_cast<ReadTask*>(task);
+      break;
+    }
+    case Method::kFlush: {
+      ar >> *reinterpret_cast<FlushTask*>(task);
+      break;
+    }
+    case Method::kPollStats: {
+      ar >> *reinterpret_cast<PollStatsTask*>(task);
+      break;
+    }
+  }
+}
+/** Method dispatch table (indexed by method) */
+static const chi::MethodTable &GetMethodTable() {
+  static constexpr chi::RunMethod_t kRun[Method::kCount] = {
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Create(
+        reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Destroy(
+        reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Write(
+        reinterpret_cast<WriteTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Read(
+        reinterpret_cast<ReadTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Flush(
+        reinterpret_cast<FlushTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->PollStats(
+        reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::MonitorMethod_t kMonitor[Method::kCount] = {
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCreate(
+        mode, reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroy(
+        mode, reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorWrite(
+        mode, reinterpret_cast<WriteTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorRead(
+        mode, reinterpret_cast<ReadTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorFlush(
+        mode, reinterpret_cast<FlushTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorPollStats(
+        mode, reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::DelMethod_t kDel[Method::kCount] = {
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CreateTask>(
+        mctx, reinterpret_cast<CreateTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyTask>(
+        mctx, reinterpret_cast<DestroyTask *>(task));
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<WriteTask>(
+        mctx, reinterpret_cast<WriteTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<ReadTask>(
+        mctx, reinterpret_cast<ReadTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<FlushTask>(
+        mctx, reinterpret_cast<FlushTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<PollStatsTask>(
+        mctx, reinterpret_cast<PollStatsTask *>(task));
+    },
+  };
+  static constexpr chi::MethodTable kTable = {kRun, kMonitor, kDel, Method::kCount};
+  return kTable;
+}
+
+#endif  // CHI_CACHE_LIB_EXEC_H_
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef CHI_CACHE_METHODS_H_
+#define CHI_CACHE_METHODS_H_
+
+/** The set of methods in the cache task */
+struct Method : public chi::TaskMethod {
+  TASK_METHOD_T kWrite = 10;
+  TASK_METHOD_T kRead = 11;
+  TASK_METHOD_T kFlush = 12;
+  TASK_METHOD_T kPollStats = 13;
+  TASK_METHOD_T kCount = 14;
+};
+
+#endif  // CHI_CACHE_METHODS_H_
\ No newline at end of file
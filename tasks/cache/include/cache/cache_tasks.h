@@ -0,0 +1,298 @@
+//
+// Created by lukemartinlogan on 8/11/23.
+//
+
+#ifndef CHI_TASKS_TASK_TEMPL_INCLUDE_cache_cache_TASKS_H_
+#define CHI_TASKS_TASK_TEMPL_INCLUDE_cache_cache_TASKS_H_
+
+#include "chimaera/chimaera_namespace.h"
+
+namespace chi::cache {
+
+#include "cache_methods.h"
+CHI_NAMESPACE_INIT
+
+/** When the cache writes data to the backing bdev */
+struct CacheMode {
+  CLS_CONST u32 kWriteThrough = 0; /**< On every write */
+  CLS_CONST u32 kWriteBack = 1;    /**< On eviction or flush */
+};
+
+/** Cache statistics */
+struct CacheStats {
+  size_t hits_;       /**< Cache blocks found in the cache */
+  size_t misses_;     /**< Cache blocks read from the bdev */
+  size_t evictions_;  /**< Cache blocks evicted */
+  size_t writebacks_; /**< Dirty cache blocks written to the bdev */
+  size_t dirty_;      /**< Dirty cache blocks currently cached */
+
+  template <typename Ar>
+  void serialize(Ar &ar) {
+    ar(hits_, misses_, evictions_, writebacks_, dirty_);
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const CacheStats &stats) {
+    os << hshm::Formatter::format(
+        "Hits: {}, Misses: {}, Evictions: {}, Writebacks: {}, Dirty: {}",
+        stats.hits_, stats.misses_, stats.evictions_, stats.writebacks_,
+        stats.dirty_);
+    return os;
+  }
+};
+
+/**
+ * A task to create cache
+ * */
+struct CreateTaskParams {
+  CLS_CONST char *lib_name_ = "chimaera_cache";
+  IN PoolId bdev_id_;     /**< The bdev pool being cached */
+  IN size_t capacity_;    /**< Bytes of data cached per container */
+  IN size_t block_size_;  /**< Granularity of caching */
+  IN u32 mode_;           /**< A CacheMode */
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams() = default;
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc) {}
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                   const PoolId &bdev_id, size_t capacity,
+                   size_t block_size = KILOBYTES(64),
+                   u32 mode = CacheMode::kWriteThrough) {
+    bdev_id_ = bdev_id;
+    capacity_ = capacity;
+    block_size_ = block_size;
+    mode_ = mode;
+  }
+
+  template <typename Ar>
+  void serialize(Ar &ar) {
+    ar(bdev_id_, capacity_, block_size_, mode_);
+  }
+};
+typedef chi::Admin::CreatePoolBaseTask<CreateTaskParams> CreateTask;
+
+/** A task to destroy cache */
+typedef chi::Admin::DestroyContainerTask DestroyTask;
+
+/**
+ * Write to the cached bdev
+ * */
+struct WriteTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN hipc::Pointer data_;
+  IN size_t size_;
+  IN size_t off_;
+  OUT bool success_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN explicit WriteTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN explicit WriteTask(
+      const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
+      const PoolId &pool_id, const DomainQuery &dom_query,
+      const hipc::Pointer &data, size_t off, size_t size)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kWrite;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    data_ = data;
+    size_ = size;
+    off_ = off;
+  }
+
+  /** Destructor */
+  ~WriteTask() {
+    if (IsDataOwner() && !data_.IsNull()) {
+      CHI_CLIENT->FreeBuffer(HSHM_MCTX, data_);
+    }
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const WriteTask &other, bool deep) {
+    data_ = other.data_;
+    size_ = other.size_;
+    off_ = other.off_;
+    if (!deep) {
+      UnsetDataOwner();
+    }
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar.bulk(DT_WRITE, data_, size_);
+    ar(off_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(success_);
+  }
+};
+
+/**
+ * Read from the cached bdev
+ * */
+struct ReadTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN hipc::Pointer data_;
+  IN size_t size_;
+  IN size_t off_;
+  OUT bool success_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit ReadTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit ReadTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                    const TaskNode &task_node, const PoolId &pool_id,
+                    const DomainQuery &dom_query, const hipc::Pointer &data,
+                    size_t off, size_t size)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kRead;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    data_ = data;
+    size_ = size;
+    off_ = off;
+  }
+
+  /** Destructor */
+  ~ReadTask() {
+    if (IsDataOwner() && !data_.IsNull()) {
+      CHI_CLIENT->FreeBuffer(HSHM_MCTX, data_);
+    }
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const ReadTask &other, bool deep) {
+    data_ = other.data_;
+    size_ = other.size_;
+    off_ = other.off_;
+    if (!deep) {
+      UnsetDataOwner();
+    }
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar.bulk(DT_EXPOSE, data_, size_);
+    ar(off_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  void SerializeEnd(Ar &ar) {
+    ar.bulk(DT_WRITE, data_, size_);
+    ar(success_);
+  }
+};
+
+/**
+ * Write all dirty cache blocks back to the bdev
+ * */
+struct FlushTask : public Task, TaskFlags<TF_SRL_SYM> {
+  OUT size_t count_; /**< The number of cache blocks written back */
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit FlushTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit FlushTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                     const TaskNode &task_node, const PoolId &pool_id,
+                     const DomainQuery &dom_query)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kFlush;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const FlushTask &other, bool deep) {}
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {}
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(count_);
+  }
+};
+
+/**
+ * Get the statistics of the cache
+ * */
+struct PollStatsTask : public Task, TaskFlags<TF_SRL_SYM> {
+  OUT CacheStats stats_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit PollStatsTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit PollStatsTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                         const TaskNode &task_node, const PoolId &pool_id,
+                         const DomainQuery &dom_query)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kPollStats;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const PollStatsTask &other, bool deep) {}
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {}
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(stats_);
+  }
+};
+
+}  // namespace chi::cache
+
+#endif  // CHI_TASKS_TASK_TEMPL_INCLUDE_cache_cache_TASKS_H_
@@ -0,0 +1 @@
+#include "cache/cache_client.h"
\ No newline at end of file
@@ -0,0 +1,454 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+#include "bdev/bdev_client.h"
+#include "cache/cache_client.h"
+#include "chimaera/api/chimaera_runtime.h"
+#include "chimaera/monitor/monitor.h"
+#include "chimaera/work_orchestrator/comutex.h"
+#include "chimaera_admin/chimaera_admin_client.h"
+
+namespace chi::cache {
+
+/** A cached block of the bdev */
+struct CacheEntry {
+  FullPtr<char> data_;               /**< Block contents in data shm */
+  bool dirty_;                       /**< Not yet written to the bdev */
+  bool hot_;                         /**< In the Am queue, not A1in */
+  std::list<size_t>::iterator pos_;  /**< Position in its queue */
+};
+
+/**
+ * One shard of the cache, managed with 2Q.
+ * Blocks seen once enter the A1in FIFO. Blocks evicted from A1in are
+ * remembered in the A1out ghost queue, and are promoted to the Am LRU
+ * if accessed again before the ghost expires. A sequential scan only
+ * cycles through A1in, so it does not flush the hot blocks in Am.
+ * */
+struct CacheShard {
+  CoMutex lock_;
+  std::unordered_map<size_t, CacheEntry> entries_;
+  std::list<size_t> a1in_; /**< Blocks seen once, front is newest */
+  std::list<size_t> am_;   /**< Blocks seen again, front is MRU */
+  std::list<size_t> a1out_; /**< Ghosts of blocks evicted from A1in */
+  std::unordered_map<size_t, std::list<size_t>::iterator> ghosts_;
+  size_t max_blocks_;      /**< Blocks cached by the shard */
+  size_t max_a1in_;        /**< Target size of A1in */
+  size_t max_a1out_;       /**< Ghosts remembered */
+};
+
+class Server : public Module {
+public:
+  CreateTaskParams params_;
+  bdev::Client bdev_;
+  DomainQuery bdev_query_; /**< The bdev container backing this one */
+  CLS_CONST u32 kNumShards = 8;
+  CLS_CONST int kDestroyFlushTries = 3; /**< Write-back attempts on destroy */
+  CacheShard shards_[kNumShards];
+  std::atomic<size_t> hits_;
+  std::atomic<size_t> misses_;
+  std::atomic<size_t> evictions_;
+  std::atomic<size_t> writebacks_;
+  std::atomic<size_t> dirty_;
+  RollingAverage monitor_[Method::kCount];
+  CLS_CONST LaneGroupId kMdGroup = 0;
+  CLS_CONST LaneGroupId kDataGroup = 1; /**< One lane per shard */
+
+public:
+  Server() = default;
+
+  /** Construct cache */
+  void Create(CreateTask *task, RunContext &rctx) {
+    params_ = task->GetParams();
+    if (params_.block_size_ == 0) {
+      params_.block_size_ = KILOBYTES(64);
+    }
+    bdev_.Init(params_.bdev_id_);
+    bdev_query_ =
+        DomainQuery::GetDirectId(SubDomain::kGlobalContainers, container_id_);
+    size_t num_blocks = params_.capacity_ / params_.block_size_;
+    for (u32 i = 0; i < kNumShards; ++i) {
+      CacheShard &shard = shards_[i];
+      shard.lock_.SetName(
+          hshm::Formatter::format("cache.{}.shard.{}", name_, i));
+      shard.max_blocks_ = std::max<size_t>(num_blocks / kNumShards, 1);
+      shard.max_a1in_ = std::max<size_t>(shard.max_blocks_ / 4, 1);
+      shard.max_a1out_ = std::max<size_t>(shard.max_blocks_ / 2, 1);
+    }
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
+    writebacks_ = 0;
+    dirty_ = 0;
+    CreateLaneGroup(kMdGroup, 1, QUEUE_LOW_LATENCY);
+    CreateLaneGroup(kDataGroup, kNumShards, QUEUE_HIGH_LATENCY);
+
+    // Create monitoring functions
+    for (int i = 0; i < Method::kCount; ++i) {
+      monitor_[i].Shape(hshm::Formatter::format("{}-method-{}", name_, i));
+    }
+  }
+  void MonitorCreate(MonitorModeId mode, CreateTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kCreate, mode, rctx);
+  }
+
+  /** Route I/O to the lane of the shard holding its first block */
+  Lane *MapTaskToLane(const Task *task) override {
+    switch (task->method_) {
+    case Method::kRead: {
+      auto *read_task = reinterpret_cast<const ReadTask *>(task);
+      return GetLaneByHash(kDataGroup, task->prio_,
+                           read_task->off_ / params_.block_size_);
+    }
+    case Method::kWrite: {
+      auto *write_task = reinterpret_cast<const WriteTask *>(task);
+      return GetLaneByHash(kDataGroup, task->prio_,
+                           write_task->off_ / params_.block_size_);
+    }
+    default: {
+      return GetLaneByHash(kMdGroup, task->prio_, 0);
+    }
+    }
+  }
+
+  /**
+   * Destroy cache, writing back dirty blocks.
+   * Blocks whose write back fails are retried, and reported as lost if
+   * they still cannot be written when the cache is freed.
+   * */
+  void Destroy(DestroyTask *task, RunContext &rctx) {
+    for (CacheShard &shard : shards_) {
+      ScopedCoMutex lock(shard.lock_);
+      for (int i = 0; i < kDestroyFlushTries && CountDirty(shard); ++i) {
+        FlushShard(shard);
+      }
+      size_t lost = CountDirty(shard);
+      if (lost) {
+        HELOG(kError, "Cache {} lost {} dirty blocks it could not write back",
+              name_, lost);
+        dirty_ -= lost;
+      }
+      for (auto &it : shard.entries_) {
+        CHI_CLIENT->FreeBuffer(HSHM_MCTX, it.second.data_);
+      }
+      shard.entries_.clear();
+      shard.a1in_.clear();
+      shard.am_.clear();
+      shard.a1out_.clear();
+      shard.ghosts_.clear();
+    }
+  }
+  void MonitorDestroy(MonitorModeId mode, DestroyTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kDestroy, mode, rctx);
+  }
+
+  /** Write to the cached bdev */
+  void Write(WriteTask *task, RunContext &rctx) {
+    char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+    if (params_.mode_ == CacheMode::kWriteThrough) {
+      WriteThrough(task, data);
+    } else {
+      WriteBack(task, data);
+    }
+  }
+  void MonitorWrite(MonitorModeId mode, WriteTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kWrite, mode, rctx);
+  }
+
+  /**
+   * Write to the bdev, then update the blocks already cached.
+   * Writes do not allocate blocks. The shards touched stay locked
+   * across the bdev write, in shard order, so a concurrent miss
+   * cannot cache the old data.
+   * */
+  void WriteThrough(WriteTask *task, char *data) {
+    std::vector<size_t> shard_ids;
+    ForEachBlock(task->off_, task->size_,
+                 [&](size_t blk, size_t blk_off, size_t size, size_t pos) {
+                   shard_ids.emplace_back(blk % kNumShards);
+                 });
+    std::sort(shard_ids.begin(), shard_ids.end());
+    shard_ids.erase(std::unique(shard_ids.begin(), shard_ids.end()),
+                    shard_ids.end());
+    for (size_t shard_id : shard_ids) {
+      shards_[shard_id].lock_.Lock();
+    }
+    task->success_ = bdev_.Write(HSHM_MCTX, bdev_query_, task->data_,
+                                 task->off_, task->size_);
+    ForEachBlock(task->off_, task->size_,
+                 [&](size_t blk, size_t blk_off, size_t size, size_t pos) {
+                   CacheShard &shard = GetShard(blk);
+                   auto it = shard.entries_.find(blk);
+                   if (it != shard.entries_.end()) {
+                     memcpy(it->second.data_.ptr_ + blk_off, data + pos, size);
+                   }
+                 });
+    for (size_t shard_id : shard_ids) {
+      shards_[shard_id].lock_.Unlock();
+    }
+  }
+
+  /**
+   * Copy the data into the cache and mark the blocks dirty.
+   * Blocks are written to the bdev when evicted or flushed.
+   * */
+  void WriteBack(WriteTask *task, char *data) {
+    task->success_ = true;
+    ForEachBlock(
+        task->off_, task->size_,
+        [&](size_t blk, size_t blk_off, size_t size, size_t pos) {
+          CacheShard &shard = GetShard(blk);
+          ScopedCoMutex lock(shard.lock_);
+          // A partial write of a missing block needs the rest of it
+          bool partial = size < params_.block_size_;
+          CacheEntry *entry = Get(shard, blk, partial);
+          if (!entry) {
+            task->success_ = false;
+            return;
+          }
+          memcpy(entry->data_.ptr_ + blk_off, data + pos, size);
+          if (!entry->dirty_) {
+            entry->dirty_ = true;
+            dirty_ += 1;
+          }
+        });
+  }
+
+  /** Read from the cached bdev */
+  void Read(ReadTask *task, RunContext &rctx) {
+    char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+    task->success_ = true;
+    ForEachBlock(task->off_, task->size_,
+                 [&](size_t blk, size_t blk_off, size_t size, size_t pos) {
+                   CacheShard &shard = GetShard(blk);
+                   ScopedCoMutex lock(shard.lock_);
+                   CacheEntry *entry = Get(shard, blk, true);
+                   if (!entry) {
+                     task->success_ = false;
+                     return;
+                   }
+                   memcpy(data + pos, entry->data_.ptr_ + blk_off, size);
+                 });
+  }
+  void MonitorRead(MonitorModeId mode, ReadTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kRead, mode, rctx);
+  }
+
+  /** Write all dirty blocks back to the bdev */
+  void Flush(FlushTask *task, RunContext &rctx) {
+    task->count_ = 0;
+    for (CacheShard &shard : shards_) {
+      ScopedCoMutex lock(shard.lock_);
+      task->count_ += FlushShard(shard);
+    }
+  }
+  void MonitorFlush(MonitorModeId mode, FlushTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kFlush, mode, rctx);
+  }
+
+  /** Poll cache statistics */
+  void PollStats(PollStatsTask *task, RunContext &rctx) {
+    task->stats_.hits_ = hits_.load();
+    task->stats_.misses_ = misses_.load();
+    task->stats_.evictions_ = evictions_.load();
+    task->stats_.writebacks_ = writebacks_.load();
+    task->stats_.dirty_ = dirty_.load();
+  }
+  void MonitorPollStats(MonitorModeId mode, PollStatsTask *task,
+                        RunContext &rctx) {
+    AverageMonitor(Method::kPollStats, mode, rctx);
+  }
+
+private:
+  /** Call \a func(blk, blk_off, size, pos) on each block of a range */
+  template <typename F>
+  void ForEachBlock(size_t off, size_t size, F &&func) {
+    size_t pos = 0;
+    while (pos < size) {
+      size_t blk = (off + pos) / params_.block_size_;
+      size_t blk_off = (off + pos) % params_.block_size_;
+      size_t blk_size = std::min(params_.block_size_ - blk_off, size - pos);
+      func(blk, blk_off, blk_size, pos);
+      pos += blk_size;
+    }
+  }
+
+  /** Get the shard caching a block */
+  CacheShard &GetShard(size_t blk) { return shards_[blk % kNumShards]; }
+
+  /**
+   * Get the entry of a block, caching it on a miss.
+   * The block is read from the bdev if \a fill is set.
+   * The shard must be locked.
+   * */
+  CacheEntry *Get(CacheShard &shard, size_t blk, bool fill) {
+    auto it = shard.entries_.find(blk);
+    if (it != shard.entries_.end()) {
+      CacheEntry &entry = it->second;
+      if (entry.hot_) {
+        shard.am_.splice(shard.am_.begin(), shard.am_, entry.pos_);
+      }
+      hits_ += 1;
+      return &entry;
+    }
+    misses_ += 1;
+    FullPtr<char> data = Reclaim(shard);
+    if (data.shm_.IsNull()) {
+      return nullptr;
+    }
+    if (fill && !bdev_.Read(HSHM_MCTX, bdev_query_, data.shm_,
+                            blk * params_.block_size_, params_.block_size_)) {
+      CHI_CLIENT->FreeBuffer(HSHM_MCTX, data);
+      return nullptr;
+    }
+    CacheEntry &entry = shard.entries_[blk];
+    entry.data_ = data;
+    entry.dirty_ = false;
+    auto ghost = shard.ghosts_.find(blk);
+    if (ghost != shard.ghosts_.end()) {
+      // Seen again after leaving A1in, so it is hot
+      shard.a1out_.erase(ghost->second);
+      shard.ghosts_.erase(ghost);
+      entry.hot_ = true;
+      shard.am_.emplace_front(blk);
+      entry.pos_ = shard.am_.begin();
+    } else {
+      entry.hot_ = false;
+      shard.a1in_.emplace_front(blk);
+      entry.pos_ = shard.a1in_.begin();
+    }
+    return &entry;
+  }
+
+  /**
+   * Get a buffer for a new block, evicting a block if the shard is full.
+   * Victims are taken from the queue 2Q evicts from first, then from the
+   * other. A dirty victim whose write back fails stays cached and dirty,
+   * and only clean victims are tried after that. Returns null if no block
+   * could be evicted, which fails the request.
+   * */
+  FullPtr<char> Reclaim(CacheShard &shard) {
+    if (shard.entries_.size() < shard.max_blocks_) {
+      return CHI_CLIENT->AllocateBuffer(HSHM_MCTX, params_.block_size_);
+    }
+    bool from_a1in = shard.a1in_.size() > shard.max_a1in_ || shard.am_.empty();
+    std::list<size_t> *queues[2] = {from_a1in ? &shard.a1in_ : &shard.am_,
+                                    from_a1in ? &shard.am_ : &shard.a1in_};
+    bool write_back_failed = false;
+    for (std::list<size_t> *queue : queues) {
+      for (auto pos = queue->rbegin(); pos != queue->rend(); ++pos) {
+        size_t victim = *pos;
+        CacheEntry &entry = shard.entries_[victim];
+        if (entry.dirty_) {
+          if (write_back_failed) {
+            continue;
+          }
+          WriteBackEntry(victim, entry);
+          if (entry.dirty_) {
+            write_back_failed = true;
+            continue;
+          }
+        }
+        return Evict(shard, *queue, std::next(pos).base());
+      }
+    }
+    HELOG(kError, "Cache {} has no block to evict", name_);
+    return FullPtr<char>::GetNull();
+  }
+
+  /** Remove a clean block from the shard and return its buffer */
+  FullPtr<char> Evict(CacheShard &shard, std::list<size_t> &queue,
+                      std::list<size_t>::iterator pos) {
+    size_t victim = *pos;
+    queue.erase(pos);
+    if (&queue == &shard.a1in_) {
+      shard.a1out_.emplace_front(victim);
+      shard.ghosts_[victim] = shard.a1out_.begin();
+      if (shard.a1out_.size() > shard.max_a1out_) {
+        shard.ghosts_.erase(shard.a1out_.back());
+        shard.a1out_.pop_back();
+      }
+    }
+    auto it = shard.entries_.find(victim);
+    FullPtr<char> data = it->second.data_;
+    shard.entries_.erase(it);
+    evictions_ += 1;
+    return data;
+  }
+
+  /**
+   * Write back the dirty blocks of a shard. The shard must be locked.
+   * Returns the number of blocks written. Blocks which failed stay dirty.
+   * */
+  size_t FlushShard(CacheShard &shard) {
+    size_t count = 0;
+    for (auto &it : shard.entries_) {
+      if (it.second.dirty_) {
+        WriteBackEntry(it.first, it.second);
+        if (!it.second.dirty_) {
+          count += 1;
+        }
+      }
+    }
+    return count;
+  }
+
+  /** Count the dirty blocks of a shard. The shard must be locked. */
+  size_t CountDirty(CacheShard &shard) {
+    size_t count = 0;
+    for (auto &it : shard.entries_) {
+      count += it.second.dirty_;
+    }
+    return count;
+  }
+
+  /** Write a dirty block to the bdev */
+  void WriteBackEntry(size_t blk, CacheEntry &entry) {
+    if (!bdev_.Write(HSHM_MCTX, bdev_query_, entry.data_.shm_,
+                     blk * params_.block_size_, params_.block_size_)) {
+      HELOG(kError, "Cache {} failed to write back block {}", name_, blk);
+      return;
+    }
+    entry.dirty_ = false;
+    dirty_ -= 1;
+    writebacks_ += 1;
+  }
+
+  /** Rolling average for most tasks */
+  void AverageMonitor(MethodId method, MonitorModeId mode, RunContext &rctx) {
+    switch (mode) {
+    case MonitorMode::kEstLoad: {
+      rctx.load_.cpu_load_ = monitor_[method].Predict();
+      break;
+    }
+    case MonitorMode::kSampleLoad: {
+      monitor_[method].Add(rctx.timer_->GetNsec(), rctx.load_);
+      break;
+    }
+    case MonitorMode::kReinforceLoad: {
+      monitor_[method].DoTrain();
+      break;
+    }
+    }
+  }
+
+public:
+#include "cache/cache_lib_exec.h"
+};
+
+} // namespace chi::cache
+
+CHI_TASK_CC(chi::cache::Server, "cache");
@@ -140,10 +140,17 @@ public:
 #endif
   CHI_TASK_METHODS(SetWorkOrchProcPolicy);
 
-  /** Flush the runtime */
+  /**
+   * Flush the runtime.
+   * Waits for every task submitted before the flush to complete.
+   * Only \a flush_pool is flushed if it is not null. Remote nodes
+   * are flushed as well when \a dom_query spans them
+   * (e.g., DomainQuery::GetGlobalBcast()).
+   * */
   HSHM_INLINE_CROSS_FUN
-  size_t Flush(const hipc::MemContext &mctx, const DomainQuery &dom_query) {
-    FullPtr<FlushTask> task = AsyncFlush(mctx, dom_query);
+  size_t Flush(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+               const PoolId &flush_pool = PoolId::GetNull()) {
+    FullPtr<FlushTask> task = AsyncFlush(mctx, dom_query, flush_pool);
     task->Wait();
     size_t work_done = task->work_done_;
     CHI_CLIENT->DelTask(mctx, task);
@@ -173,6 +180,36 @@ public:
     CHI_CLIENT->DelTask(mctx, task);
     return stats;
   }
+
+  /** PollStats task (coroutine lock contention) */
+  std::vector<CoLockStats> PollLockStats(const hipc::MemContext &mctx,
+                                         const DomainQuery &dom_query) {
+    FullPtr<PollStatsTask> task = AsyncPollStats(mctx, dom_query);
+    task->Wait();
+    std::vector<CoLockStats> locks = task->locks_.vec();
+    CHI_CLIENT->DelTask(mctx, task);
+    return locks;
+  }
+
+  /** PollStats task (exhausted buffer allocations) */
+  BufferStats PollBufferStats(const hipc::MemContext &mctx,
+                              const DomainQuery &dom_query) {
+    FullPtr<PollStatsTask> task = AsyncPollStats(mctx, dom_query);
+    task->Wait();
+    BufferStats buffers = task->buffers_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return buffers;
+  }
+
+  /** PollStats task (work orchestrator policy runs) */
+  std::vector<SchedulerStats> PollSchedulerStats(const hipc::MemContext &mctx,
+                                                 const DomainQuery &dom_query) {
+    FullPtr<PollStatsTask> task = AsyncPollStats(mctx, dom_query);
+    task->Wait();
+    std::vector<SchedulerStats> scheds = task->scheds_.vec();
+    CHI_CLIENT->DelTask(mctx, task);
+    return scheds;
+  }
   CHI_TASK_METHODS(PollStats);
 };
 
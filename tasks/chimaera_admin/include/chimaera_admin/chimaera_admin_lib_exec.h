@@ -650,5 +650,220 @@ void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
     }
   }
 }
+/** Method dispatch table (indexed by method) */
+static const chi::MethodTable &GetMethodTable() {
+  static constexpr chi::RunMethod_t kRun[Method::kCount] = {
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Create(
+        reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Destroy(
+        reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->CreatePool(
+        reinterpret_cast<CreatePoolTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->DestroyContainer(
+        reinterpret_cast<DestroyContainerTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->RegisterModule(
+        reinterpret_cast<RegisterModuleTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->DestroyModule(
+        reinterpret_cast<DestroyModuleTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->UpgradeModule(
+        reinterpret_cast<UpgradeModuleTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->GetPoolId(
+        reinterpret_cast<GetPoolIdTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->StopRuntime(
+        reinterpret_cast<StopRuntimeTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->SetWorkOrchQueuePolicy(
+        reinterpret_cast<SetWorkOrchQueuePolicyTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->SetWorkOrchProcPolicy(
+        reinterpret_cast<SetWorkOrchProcPolicyTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Flush(
+        reinterpret_cast<FlushTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->GetDomainSize(
+        reinterpret_cast<GetDomainSizeTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->UpdateDomain(
+        reinterpret_cast<UpdateDomainTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->PollStats(
+        reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::MonitorMethod_t kMonitor[Method::kCount] = {
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCreate(
+        mode, reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroy(
+        mode, reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCreatePool(
+        mode, reinterpret_cast<CreatePoolTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroyContainer(
+        mode, reinterpret_cast<DestroyContainerTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorRegisterModule(
+        mode, reinterpret_cast<RegisterModuleTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroyModule(
+        mode, reinterpret_cast<DestroyModuleTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorUpgradeModule(
+        mode, reinterpret_cast<UpgradeModuleTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorGetPoolId(
+        mode, reinterpret_cast<GetPoolIdTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorStopRuntime(
+        mode, reinterpret_cast<StopRuntimeTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorSetWorkOrchQueuePolicy(
+        mode, reinterpret_cast<SetWorkOrchQueuePolicyTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorSetWorkOrchProcPolicy(
+        mode, reinterpret_cast<SetWorkOrchProcPolicyTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorFlush(
+        mode, reinterpret_cast<FlushTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorGetDomainSize(
+        mode, reinterpret_cast<GetDomainSizeTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorUpdateDomain(
+        mode, reinterpret_cast<UpdateDomainTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorPollStats(
+        mode, reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::DelMethod_t kDel[Method::kCount] = {
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CreateTask>(
+        mctx, reinterpret_cast<CreateTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyTask>(
+        mctx, reinterpret_cast<DestroyTask *>(task));
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CreatePoolTask>(
+        mctx, reinterpret_cast<CreatePoolTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyContainerTask>(
+        mctx, reinterpret_cast<DestroyContainerTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<RegisterModuleTask>(
+        mctx, reinterpret_cast<RegisterModuleTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyModuleTask>(
+        mctx, reinterpret_cast<DestroyModuleTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<UpgradeModuleTask>(
+        mctx, reinterpret_cast<UpgradeModuleTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<GetPoolIdTask>(
+        mctx, reinterpret_cast<GetPoolIdTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<StopRuntimeTask>(
+        mctx, reinterpret_cast<StopRuntimeTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<SetWorkOrchQueuePolicyTask>(
+        mctx, reinterpret_cast<SetWorkOrchQueuePolicyTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<SetWorkOrchProcPolicyTask>(
+        mctx, reinterpret_cast<SetWorkOrchProcPolicyTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<FlushTask>(
+        mctx, reinterpret_cast<FlushTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<GetDomainSizeTask>(
+        mctx, reinterpret_cast<GetDomainSizeTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<UpdateDomainTask>(
+        mctx, reinterpret_cast<UpdateDomainTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<PollStatsTask>(
+        mctx, reinterpret_cast<PollStatsTask *>(task));
+    },
+  };
+  static constexpr chi::MethodTable kTable = {kRun, kMonitor, kDel, Method::kCount};
+  return kTable;
+}
 
 #endif  // CHI_CHIMAERA_ADMIN_LIB_EXEC_H_
\ No newline at end of file
@@ -439,8 +439,13 @@ struct SetWorkOrchestratorPolicyTask : public Task, TaskFlags<TF_SRL_SYM> {
 using SetWorkOrchQueuePolicyTask = SetWorkOrchestratorPolicyTask<0>;
 using SetWorkOrchProcPolicyTask = SetWorkOrchestratorPolicyTask<1>;
 
-/** A task to flush the runtime */
+/**
+ * A task to flush the runtime.
+ * Completes once every task routed before the flush has ended, either
+ * in a single pool or (if flush_pool_ is null) in all pools.
+ * */
 struct FlushTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN PoolId flush_pool_;
   INOUT size_t work_done_;
 
   /** SHM default constructor */
@@ -451,7 +456,8 @@ struct FlushTask : public Task, TaskFlags<TF_SRL_SYM> {
   HSHM_INLINE_CROSS_FUN
   explicit FlushTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
                      const TaskNode &task_node, const PoolId &pool_id,
-                     const DomainQuery &dom_query)
+                     const DomainQuery &dom_query,
+                     const PoolId &flush_pool = PoolId::GetNull())
       : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
@@ -462,19 +468,21 @@ struct FlushTask : public Task, TaskFlags<TF_SRL_SYM> {
     dom_query_ = dom_query;
 
     // Custom
+    flush_pool_ = flush_pool;
     work_done_ = 0;
   }
 
   /** Duplicate message */
   HSHM_INLINE_CROSS_FUN
   void CopyStart(const FlushTask &other, bool deep) {
+    flush_pool_ = other.flush_pool_;
     work_done_ = other.work_done_;
   }
 
   /** (De)serialize message call */
   template <typename Ar>
   HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
-    ar(work_done_);
+    ar(flush_pool_, work_done_);
   }
 
   /** (De)serialize message return */
@@ -563,17 +571,20 @@ struct UpdateDomainTask : public Task, TaskFlags<TF_SRL_SYM> {
 /** The PollStatsTask task */
 struct PollStatsTask : public Task, TaskFlags<TF_SRL_SYM> {
   OUT chi::ipc::vector<chi::WorkerStats> stats_;
+  OUT chi::ipc::vector<chi::CoLockStats> locks_;
+  OUT chi::BufferStats buffers_;
+  OUT chi::ipc::vector<chi::SchedulerStats> scheds_;
 
   /** SHM default constructor */
   HSHM_INLINE explicit PollStatsTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
-      : Task(alloc), stats_(alloc) {}
+      : Task(alloc), stats_(alloc), locks_(alloc), scheds_(alloc) {}
 
   /** Emplace constructor */
   HSHM_INLINE explicit PollStatsTask(
       const hipc::CtxAllocator<CHI_ALLOC_T> &alloc, const TaskNode &task_node,
       const PoolId &pool_id, const DomainQuery &dom_query)
-      : Task(alloc), stats_(alloc) {
+      : Task(alloc), stats_(alloc), locks_(alloc), scheds_(alloc) {
     // Initialize task
     task_node_ = task_node;
     prio_ = TaskPrioOpt::kLowLatency;
@@ -588,6 +599,9 @@ struct PollStatsTask : public Task, TaskFlags<TF_SRL_SYM> {
   /** Duplicate message */
   void CopyStart(const PollStatsTask &other, bool deep) {
     stats_ = other.stats_;
+    locks_ = other.locks_;
+    buffers_ = other.buffers_;
+    scheds_ = other.scheds_;
   }
 
   /** (De)serialize message call */
@@ -597,7 +611,7 @@ struct PollStatsTask : public Task, TaskFlags<TF_SRL_SYM> {
   /** (De)serialize message return */
   template <typename Ar>
   void SerializeEnd(Ar &ar) {
-    ar(stats_);
+    ar(stats_, locks_, buffers_, scheds_);
   }
 };
 
@@ -23,27 +23,59 @@ namespace chi::Admin {
 class Server : public Module {
 public:
   CLS_CONST LaneGroupId kDefaultGroup = 0;
-  Task *queue_sched_;
-  Task *proc_sched_;
-  RollingAverage monitor_[Method::kCount];
+  CLS_CONST size_t kSchedulePeriodMs = 1000;
+  CLS_CONST size_t kNumCreateLocks = 32;
+  ScheduleTask *queue_sched_;
+  ScheduleTask *proc_sched_;
+  std::vector<std::array<RollingAverage, Method::kCount>>
+      monitor_; /**< Load models of each lane, updated by its worker only */
+  CoMutex flush_lock_;
+  CoMutex policy_lock_;
+  CoMutex create_locks_[kNumCreateLocks];
+  std::unordered_map<PoolId, std::unique_ptr<std::atomic<size_t>>>
+      sched_runs_; /**< Scheduler runs of each policy, under policy_lock_ */
 
 public:
-  Server() : queue_sched_(nullptr), proc_sched_(nullptr) {}
+  Server()
+      : queue_sched_(nullptr), proc_sched_(nullptr),
+        flush_lock_("admin.flush_lock"), policy_lock_("admin.policy_lock") {
+    for (size_t i = 0; i < kNumCreateLocks; ++i) {
+      create_locks_[i].SetName(
+          hshm::Formatter::format("admin.create_lock.{}", i));
+    }
+  }
+
+  /** The load models of the lane a task was routed to */
+  std::array<RollingAverage, Method::kCount> &GetLaneMonitor(
+      RunContext &rctx) {
+    Lane *lane = rctx.route_lane_;
+    if (lane && lane->lane_id_ < monitor_.size()) {
+      return monitor_[lane->lane_id_];
+    }
+    return monitor_[0];
+  }
+
+  /** Train the load model of a method on every lane */
+  void TrainMonitor(MethodId method) {
+    for (std::array<RollingAverage, Method::kCount> &lane_monitor : monitor_) {
+      lane_monitor[method].DoTrain();
+    }
+  }
 
   /** Basic monitoring function */
   void MonitorBase(MonitorModeId mode, MethodId method, Task *task,
                    RunContext &rctx) {
     switch (mode) {
     case MonitorMode::kEstLoad: {
-      rctx.load_.cpu_load_ = monitor_[method].Predict();
+      rctx.load_.cpu_load_ = GetLaneMonitor(rctx)[method].Predict();
       break;
     }
     case MonitorMode::kSampleLoad: {
-      monitor_[method].Add(rctx.timer_->GetNsec(), rctx.load_);
+      GetLaneMonitor(rctx)[method].Add(rctx.timer_->GetNsec(), rctx.load_);
       break;
     }
     case MonitorMode::kReinforceLoad: {
-      monitor_[method].DoTrain();
+      TrainMonitor(method);
       break;
     }
     case MonitorMode::kReplicaAgg: {
@@ -53,11 +85,20 @@ public:
     }
   }
 
-  /** Create the state */
+  /**
+   * Create the state.
+   * Admin work is sharded across one lane per dedicated worker, so that
+   * requests for different pools proceed in parallel.
+   * */
   void Create(CreateTask *task, RunContext &rctx) {
-    CreateLaneGroup(kDefaultGroup, 1, QUEUE_LOW_LATENCY);
-    for (int i = 0; i < Method::kCount; ++i) {
-      monitor_[i].Shape(hshm::Formatter::format("{}-method-{}", name_, i));
+    u32 num_lanes = std::max<u32>(CHI_WORK_ORCHESTRATOR->dworkers_.size(), 1);
+    CreateLaneGroup(kDefaultGroup, num_lanes, QUEUE_LOW_LATENCY);
+    monitor_.resize(num_lanes);
+    for (u32 lane = 0; lane < num_lanes; ++lane) {
+      for (int i = 0; i < Method::kCount; ++i) {
+        monitor_[lane][i].Shape(
+            hshm::Formatter::format("{}-lane-{}-method-{}", name_, lane, i));
+      }
     }
   }
   void MonitorCreate(MonitorModeId mode, CreateTask *task, RunContext &rctx) {
@@ -70,9 +111,41 @@ public:
     MonitorBase(mode, Method::kDestroy, task, rctx);
   }
 
-  /** Route a task to a lane */
+  /**
+   * Route a task to a lane.
+   * Pool management is sharded by the pool's name, so tasks for the same
+   * pool stay ordered. Tasks which only carry the pool's id look its name
+   * up in the registry.
+   * Read-only queries are spread across lanes. Everything else touches
+   * runtime-wide state and stays on the first lane.
+   * */
   Lane *MapTaskToLane(const Task *task) override {
-    return GetLaneByHash(kDefaultGroup, task->prio_, 0);
+    switch (task->method_) {
+    case Method::kCreatePool: {
+      auto create_task = reinterpret_cast<const CreatePoolTask *>(task);
+      return GetLaneByHash(kDefaultGroup, task->prio_,
+                           HashPoolName(create_task->pool_name_));
+    }
+    case Method::kGetPoolId: {
+      auto get_task = reinterpret_cast<const GetPoolIdTask *>(task);
+      return GetLaneByHash(kDefaultGroup, task->prio_,
+                           HashPoolName(get_task->pool_name_));
+    }
+    case Method::kDestroyContainer: {
+      auto destroy_task = reinterpret_cast<const DestroyContainerTask *>(task);
+      return GetLaneByHash(
+          kDefaultGroup, task->prio_,
+          HashPoolName(CHI_MOD_REGISTRY->GetPoolName(destroy_task->id_)));
+    }
+    case Method::kGetDomainSize:
+    case Method::kPollStats: {
+      return GetLaneByHash(kDefaultGroup, task->prio_,
+                           hshm::hash<TaskId>{}(task->task_node_.root_));
+    }
+    default: {
+      return GetLaneByHash(kDefaultGroup, task->prio_, 0);
+    }
+    }
   }
 
   /** Update number of lanes */
@@ -106,73 +179,79 @@ public:
     MonitorBase(mode, Method::kDestroyModule, task, rctx);
   }
 
-  /** Upgrade a module dynamically */
+  /**
+   * Upgrade a module without stopping its pools.
+   * New tasks of the old containers are held while their routed tasks
+   * drain, so the old and new code never serve a container at the same
+   * time. The drained state is then moved to the new containers, which
+   * take over routing. The old containers and library are freed once
+   * nothing references them.
+   * */
   void UpgradeModule(UpgradeModuleTask *task, RunContext &rctx) {
     ScopedCoRwWriteLock upgrade_lock(CHI_MOD_REGISTRY->upgrade_lock_);
     // Get the set of ChiContainers
     std::string lib_name = task->lib_name_.str();
     std::vector<Container *> containers =
         CHI_MOD_REGISTRY->GetContainers(lib_name);
-    std::vector<Container *> new_containers;
+    Container *old_static = CHI_MOD_REGISTRY->GetStaticContainer(lib_name);
     // Load the updated code
     ModuleInfo new_info;
-    CHI_MOD_REGISTRY->LoadModule(lib_name, new_info);
-    // Copy the old state to the new
+    if (!CHI_MOD_REGISTRY->LoadModule(lib_name, new_info)) {
+      HELOG(kError, "Could not load the upgrade of {}", lib_name);
+      return;
+    }
+    // Hold new tasks and drain the ones already routed
+    for (Container *container : containers) {
+      container->retiring_ = true;
+    }
+    for (Container *container : containers) {
+      WaitForDrain(task, container, true);
+    }
+    // Move the old state to the new
+    std::vector<Container *> new_containers;
     for (Container *container : containers) {
       Container *new_container = new_info.alloc_state_();
-      (*new_container) = (*container);
+      (*new_container) = std::move(*container);
       task->old_ = container;
       new_container->Run(Method::kUpgrade, task, rctx);
       new_containers.emplace_back(new_container);
     }
-    // Get current iter count for each worker
-    std::vector<size_t> iter_counts;
-    for (std::unique_ptr<Worker> &worker : CHI_WORK_ORCHESTRATOR->workers_) {
-      iter_counts.push_back(worker->iter_count_);
-    }
-    // Plug all module-related lanes
-    for (Container *container : containers) {
-      container->PlugAllLanes();
-    }
-    // Wait for at least two iterations per-worker
-    for (size_t i = 0; i < iter_counts.size(); ++i) {
-      while (CHI_WORK_ORCHESTRATOR->workers_[i]->iter_count_ <
-             iter_counts[i] + 2) {
-        task->Yield();
-      }
-    }
-    HILOG(kInfo, "Upgrading on worker {}",
-          CHI_WORK_ORCHESTRATOR->GetCurrentWorker()->id_);
-    // Wait for all active tasks to complete
-    for (Container *container : containers) {
-      while (container->GetNumActiveTasks() > 0) {
-        //        HILOG(kInfo, "Active tasks: {}",
-        //        container->GetNumActiveTasks());
-        task->Yield();
-      }
+    // Route new tasks to the new containers
+    RetiredModule retired;
+    if (!CHI_MOD_REGISTRY->SwapModule(new_info, new_containers, retired)) {
+      return;
     }
-    // Plug the module & replace pointers
-    CHI_MOD_REGISTRY->PlugModule(lib_name);
-    CHI_MOD_REGISTRY->ReplaceModule(new_info);
-    for (Container *new_container : new_containers) {
-      CHI_MOD_REGISTRY->ReplaceContainer(new_container);
+    HILOG(kInfo, "Upgraded {} on worker {}, retiring {} containers", lib_name,
+          CHI_WORK_ORCHESTRATOR->GetCurrentWorker()->id_,
+          retired.containers_.size());
+    // Wait out workers which looked up an old container before the swap,
+    // long-running tasks moving over, and tasks still on remote nodes
+    CHI_WORK_ORCHESTRATOR->WaitForWorkers(task);
+    for (Container *container : retired.containers_) {
+      WaitForDrain(task, container, false);
     }
-    // Unplug everything
-    for (Container *container : containers) {
-      container->UnplugAllLanes();
+    if (old_static) {
+      old_static->retiring_ = true;
+      WaitForDrain(task, old_static, false);
     }
-    CHI_MOD_REGISTRY->UnplugModule(lib_name);
+    CHI_MOD_REGISTRY->DestroyRetiredModule(retired);
   }
   void MonitorUpgradeModule(MonitorModeId mode, UpgradeModuleTask *task,
                             RunContext &rctx) {
     MonitorBase(mode, Method::kUpgradeModule, task, rctx);
   }
 
-  /** Create a pool */
+  /**
+   * Create a pool.
+   * Only creations of pools whose names share a lock stripe are
+   * serialized. The stripe is held across the broadcast, so a second
+   * creation of the same pool returns only once the first is complete.
+   * */
   void CreatePool(CreatePoolTask *task, RunContext &rctx) {
-    ScopedCoMutex lock(CHI_CUR_LANE->comux_);
     std::string lib_name = task->lib_name_.str();
     std::string pool_name = task->pool_name_.str();
+    ScopedCoMutex lock(
+        create_locks_[HashPoolName(task->pool_name_) % kNumCreateLocks]);
     // Check local registry for pool
     bool state_existed = false;
     PoolId found_pool = CHI_MOD_REGISTRY->PoolExists(pool_name, task->ctx_.id_);
@@ -221,6 +300,17 @@ public:
       HELOG(kFatal, "Failed to create container: {}", pool_name);
       return;
     }
+    // Limit the tasks of the pool in flight on this node
+    u32 max_inflight = task->ctx_.max_inflight_;
+    u32 max_per_client = task->ctx_.max_inflight_per_client_;
+    auto it = CHI_RUNTIME->server_config_->admission_.find(pool_name);
+    if (it != CHI_RUNTIME->server_config_->admission_.end()) {
+      max_inflight = max_inflight ? max_inflight : it->second.max_inflight_;
+      max_per_client = max_per_client ? max_per_client
+                                      : it->second.max_inflight_per_client_;
+    }
+    CHI_CLIENT->header_->admission_.SetLimit(task->ctx_.id_, max_inflight,
+                                             max_per_client);
     if (task->root_) {
       // Broadcast the state creation to all nodes
       CHI_ADMIN->CreatePool(HSHM_MCTX, task->affinity_, *task);
@@ -235,15 +325,15 @@ public:
                          RunContext &rctx) {
     switch (mode) {
     case MonitorMode::kEstLoad: {
-      rctx.load_.cpu_load_ = monitor_[Method::kCreatePool].Predict();
+      rctx.load_.cpu_load_ = GetLaneMonitor(rctx)[Method::kCreatePool].Predict();
       break;
     }
     case MonitorMode::kSampleLoad: {
-      monitor_[Method::kCreatePool].Add(rctx.timer_->GetNsec(), rctx.load_);
+      GetLaneMonitor(rctx)[Method::kCreatePool].Add(rctx.timer_->GetNsec(), rctx.load_);
       break;
     }
     case MonitorMode::kReinforceLoad: {
-      monitor_[Method::kCreatePool].DoTrain();
+      TrainMonitor(Method::kCreatePool);
       break;
     }
     case MonitorMode::kReplicaAgg: {
@@ -264,15 +354,15 @@ public:
                         RunContext &rctx) {
     switch (mode) {
     case MonitorMode::kEstLoad: {
-      rctx.load_.cpu_load_ = monitor_[Method::kGetPoolId].Predict();
+      rctx.load_.cpu_load_ = GetLaneMonitor(rctx)[Method::kGetPoolId].Predict();
       break;
     }
     case MonitorMode::kSampleLoad: {
-      monitor_[Method::kGetPoolId].Add(rctx.timer_->GetNsec(), rctx.load_);
+      GetLaneMonitor(rctx)[Method::kGetPoolId].Add(rctx.timer_->GetNsec(), rctx.load_);
       break;
     }
     case MonitorMode::kReinforceLoad: {
-      monitor_[Method::kGetPoolId].DoTrain();
+      TrainMonitor(Method::kGetPoolId);
       break;
     }
     case MonitorMode::kReplicaAgg: {
@@ -283,8 +373,15 @@ public:
     }
   }
 
-  /** Destroy a pool */
+  /**
+   * Destroy a pool.
+   * Holds the same lock stripe as CreatePool, so a destruction and a
+   * re-creation of the same pool never overlap.
+   * */
   void DestroyContainer(DestroyContainerTask *task, RunContext &rctx) {
+    std::string pool_name = CHI_MOD_REGISTRY->GetPoolName(task->id_);
+    ScopedCoMutex lock(
+        create_locks_[HashPoolName(pool_name) % kNumCreateLocks]);
     CHI_MOD_REGISTRY->DestroyContainer(task->id_);
   }
   void MonitorDestroyContainer(MonitorModeId mode, DestroyContainerTask *task,
@@ -305,7 +402,9 @@ public:
 
   /** Set work orchestrator policy */
   void SetWorkOrchQueuePolicy(SetWorkOrchQueuePolicyTask *task,
-                              RunContext &rctx) {}
+                              RunContext &rctx) {
+    SetWorkOrchPolicy(task, queue_sched_, task->policy_id_);
+  }
   void MonitorSetWorkOrchQueuePolicy(MonitorModeId mode,
                                      SetWorkOrchQueuePolicyTask *task,
                                      RunContext &rctx) {
@@ -314,27 +413,64 @@ public:
 
   /** Set work orchestration policy */
   void SetWorkOrchProcPolicy(SetWorkOrchProcPolicyTask *task,
-                             RunContext &rctx) {}
+                             RunContext &rctx) {
+    SetWorkOrchPolicy(task, proc_sched_, task->policy_id_);
+  }
   void MonitorSetWorkOrchProcPolicy(MonitorModeId mode,
                                     SetWorkOrchProcPolicyTask *task,
                                     RunContext &rctx) {
     MonitorBase(mode, Method::kSetWorkOrchProcPolicy, task, rctx);
   }
 
-  /** Flush the runtime */
-  void Flush(FlushTask *task, RunContext &rctx) {}
+  /**
+   * Flush the runtime.
+   * Each container counts its tasks per flush epoch. The flush starts a
+   * new epoch and blocks until the previous one has drained. Tasks of a
+   * pool which were forwarded to other nodes are waited on through the
+   * remote queue. Admin tasks are not waited on, since they may be
+   * waiting on this flush (e.g., UpgradeModule).
+   * */
+  void Flush(FlushTask *task, RunContext &rctx) {
+    ScopedCoRwReadLock upgrade_lock(CHI_MOD_REGISTRY->upgrade_lock_);
+    ScopedCoMutex flush_lock(flush_lock_);
+    WaitForIngress(task);
+    std::vector<Container *> containers;
+    if (task->flush_pool_.IsNull()) {
+      for (Container *container : CHI_MOD_REGISTRY->GetAllContainers()) {
+        if (container->pool_id_ != chi::ADMIN_POOL_ID) {
+          containers.emplace_back(container);
+        }
+      }
+    } else {
+      containers = CHI_MOD_REGISTRY->GetPoolContainers(task->flush_pool_);
+      std::vector<Container *> remote_containers =
+          CHI_MOD_REGISTRY->GetPoolContainers(CHI_REMOTE_QUEUE->pool_id_);
+      containers.insert(containers.end(), remote_containers.begin(),
+                        remote_containers.end());
+    }
+    std::vector<u32> epochs;
+    epochs.reserve(containers.size());
+    for (Container *container : containers) {
+      u32 epoch = container->BeginFlushEpoch();
+      task->work_done_ += container->GetNumFlushing(epoch);
+      epochs.emplace_back(epoch);
+    }
+    for (size_t i = 0; i < containers.size(); ++i) {
+      WaitForFlushEpoch(task, containers[i], epochs[i]);
+    }
+  }
   void MonitorFlush(MonitorModeId mode, FlushTask *task, RunContext &rctx) {
     switch (mode) {
     case MonitorMode::kEstLoad: {
-      rctx.load_.cpu_load_ = monitor_[Method::kFlush].Predict();
+      rctx.load_.cpu_load_ = GetLaneMonitor(rctx)[Method::kFlush].Predict();
       break;
     }
     case MonitorMode::kSampleLoad: {
-      monitor_[Method::kFlush].Add(rctx.timer_->GetNsec(), rctx.load_);
+      GetLaneMonitor(rctx)[Method::kFlush].Add(rctx.timer_->GetNsec(), rctx.load_);
       break;
     }
     case MonitorMode::kReinforceLoad: {
-      monitor_[Method::kFlush].DoTrain();
+      TrainMonitor(Method::kFlush);
       break;
     }
     case MonitorMode::kReplicaAgg: {
@@ -363,6 +499,13 @@ public:
       stats.worker_id_ = worker->id_;
       stats.num_tasks_ = worker->active_.active_lanes_.GetStats(stats.lanes_);
     }
+    CHI_COLOCK_PROFILER->GetStats(task->locks_);
+    task->buffers_ = CHI_CLIENT->GetBufferStats();
+    ScopedCoMutex policy_lock(policy_lock_);
+    task->scheds_.reserve(sched_runs_.size());
+    for (auto &it : sched_runs_) {
+      task->scheds_.emplace_back(SchedulerStats{it.first, it.second->load()});
+    }
   }
   void MonitorPollStats(MonitorModeId mode, PollStatsTask *task,
                         RunContext &rctx) {
@@ -373,6 +516,96 @@ public:
     }
   }
 
+private:
+  /** Hash a pool name to pick its lane and creation lock */
+  static size_t HashPoolName(const chi::ipc::string &pool_name) {
+    return HashPoolName(pool_name.str());
+  }
+  static size_t HashPoolName(const std::string &pool_name) {
+    return std::hash<std::string>{}(pool_name);
+  }
+
+  /**
+   * Replace the periodic scheduling task of a work orchestrator policy.
+   * The old policy finishes its current run and stops at its next period
+   * boundary before the new policy starts, so two policies never schedule
+   * at the same time.
+   * */
+  void SetWorkOrchPolicy(Task *task, ScheduleTask *&sched,
+                         const PoolId &policy_id) {
+    ScopedCoMutex policy_lock(policy_lock_);
+    if (sched) {
+      sched->Stop();
+      while (!sched->IsComplete()) {
+        task->Yield();
+      }
+      CHI_CLIENT->DelTask(HSHM_MCTX, sched);
+      sched = nullptr;
+    }
+    std::unique_ptr<std::atomic<size_t>> &runs = sched_runs_[policy_id];
+    if (!runs) {
+      runs = std::make_unique<std::atomic<size_t>>(0);
+    }
+    FullPtr<ScheduleTask> new_sched = CHI_CLIENT->NewTask<ScheduleTask>(
+        HSHM_MCTX, CHI_CLIENT->MakeTaskNodeId(), policy_id,
+        DomainQuery::GetLocalHash(0), kSchedulePeriodMs);
+    new_sched->runs_ = runs.get();
+    CHI_CLIENT->ScheduleTask(nullptr, new_sched);
+    sched = new_sched.ptr_;
+    HILOG(kInfo, "(node {}) Switched work orchestrator policy to {}",
+          CHI_CLIENT->node_id_, policy_id);
+  }
+
+  /**
+   * Wait until tasks submitted before the flush have left the ingress
+   * queues and been routed to (and counted by) their containers.
+   * Tasks forwarded to the remote queue are counted on its containers.
+   * */
+  void WaitForIngress(FlushTask *task) {
+    CHI_WORK_ORCHESTRATOR->WaitForWorkers(task, true);
+  }
+
+  /**
+   * Block until a retiring container has no routed tasks, or with
+   * \a work_only, none besides long-running tasks paused between runs.
+   * */
+  void WaitForDrain(Task *task, Container *container, bool work_only) {
+    auto num_inflight = [container, work_only]() {
+      return work_only ? container->GetNumInFlightWork()
+                       : container->GetNumInFlightTasks();
+    };
+    while (num_inflight() > 0) {
+      container->drain_waiter_ = task;
+      if (num_inflight() == 0) {
+        // Nobody will signal us if we withdraw the waiter ourselves
+        Task *waiter = task;
+        if (container->drain_waiter_.compare_exchange_strong(waiter,
+                                                             nullptr)) {
+          break;
+        }
+      }
+      task->SetBlocked(1);
+      task->Yield();
+    }
+  }
+
+  /** Block until the tasks of a container's flush epoch have ended */
+  void WaitForFlushEpoch(FlushTask *task, Container *container, u32 epoch) {
+    while (container->GetNumFlushing(epoch) > 0) {
+      container->flush_waiter_ = task;
+      if (container->GetNumFlushing(epoch) == 0) {
+        // Nobody will signal us if we withdraw the waiter ourselves
+        Task *waiter = task;
+        if (container->flush_waiter_.compare_exchange_strong(waiter,
+                                                             nullptr)) {
+          break;
+        }
+      }
+      task->SetBlocked(1);
+      task->Yield();
+    }
+  }
+
 public:
 #include "chimaera_admin/chimaera_admin_lib_exec.h"
 };
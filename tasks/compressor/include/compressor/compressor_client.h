@@ -0,0 +1,91 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef CHI_compressor_H_
+#define CHI_compressor_H_
+
+#include "compressor_tasks.h"
+
+namespace chi::compressor {
+
+/** Create compressor requests */
+class Client : public ModuleClient {
+public:
+  /** Default constructor */
+  Client() = default;
+
+  /** Destructor */
+  ~Client() = default;
+
+  /** Create a pool */
+  HSHM_INLINE_CROSS_FUN
+  void Create(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+              const DomainQuery &affinity, const chi::string &pool_name,
+              const CreateContext &ctx = CreateContext()) {
+    FullPtr<CreateTask> task =
+        AsyncCreate(mctx, dom_query, affinity, pool_name, ctx);
+    task->Wait();
+    Init(task->ctx_.id_);
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(Create);
+
+  /** Destroy pool + queue */
+  HSHM_INLINE_CROSS_FUN
+  void Destroy(const hipc::MemContext &mctx, const DomainQuery &dom_query) {
+    CHI_ADMIN->DestroyContainer(mctx, dom_query, pool_id_);
+  }
+
+  /**
+   * Compress \a size bytes of \a data into \a out, a buffer of
+   * \a out_cap bytes (see GetCompressBound). \a codec may be
+   * Codec::kAuto, in which case it is set to the codec chosen.
+   * Returns the compressed size, or 0 on failure.
+   * */
+  HSHM_INLINE_CROSS_FUN
+  size_t Compress(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+                  u32 &codec, const hipc::Pointer &data, size_t size,
+                  const hipc::Pointer &out, size_t out_cap) {
+    FullPtr<CompressTask> task =
+        AsyncCompress(mctx, dom_query, codec, data, size, out, out_cap);
+    task.ptr_->Wait();
+    codec = task->codec_;
+    size_t out_size = task->success_ ? task->out_size_ : 0;
+    CHI_CLIENT->DelTask(mctx, task);
+    return out_size;
+  }
+  CHI_TASK_METHODS(Compress);
+
+  /**
+   * Decompress \a size bytes of \a data compressed with \a codec into
+   * \a out, a buffer of \a out_cap bytes.
+   * Returns the decompressed size, or 0 on failure.
+   * */
+  HSHM_INLINE_CROSS_FUN
+  size_t Decompress(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+                    u32 codec, const hipc::Pointer &data, size_t size,
+                    const hipc::Pointer &out, size_t out_cap) {
+    FullPtr<DecompressTask> task =
+        AsyncDecompress(mctx, dom_query, codec, data, size, out, out_cap);
+    task.ptr_->Wait();
+    size_t out_size = task->success_ ? task->out_size_ : 0;
+    CHI_CLIENT->DelTask(mctx, task);
+    return out_size;
+  }
+  CHI_TASK_METHODS(Decompress);
+
+  CHI_AUTOGEN_METHODS // keep at class bottom
+};
+
+} // namespace chi::compressor
+
+#endif // CHI_compressor_H_
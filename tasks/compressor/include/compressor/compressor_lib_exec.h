@@ -0,0 +1,297 @@
+#ifndef CHI_COMPRESSOR_LIB_EXEC_H_
+#define CHI_COMPRESSOR_LIB_EXEC_H_
+
+/** Execute a task */
+void Run(u32 method, Task *task, RunContext &rctx) override {
+  switch (method) {
+    case Method::kCreate: {
+      Create(reinterpret_cast<CreateTask *>(task), rctx);
+      break;
+    }
+    case Method::kDestroy: {
+      Destroy(reinterpret_cast<DestroyTask *>(task), rctx);
+      break;
+    }
+    case Method::kCompress: {
+      Compress(reinterpret_cast<CompressTask *>(task), rctx);
+      break;
+    }
+    case Method::kDecompress: {
+      Decompress(reinterpret_cast<DecompressTask *>(task), rctx);
+      break;
+    }
+  }
+}
+/** Execute a task */
+void Monitor(MonitorModeId mode, MethodId method, Task *task, RunContext &rctx) override {
+  switch (method) {
+    case Method::kCreate: {
+      MonitorCreate(mode, reinterpret_cast<CreateTask *>(task), rctx);
+      break;
+    }
+    case Method::kDestroy: {
+      MonitorDestroy(mode, reinterpret_cast<DestroyTask *>(task), rctx);
+      break;
+    }
+    case Method::kCompress: {
+      MonitorCompress(mode, reinterpret_cast<CompressTask *>(task), rctx);
+      break;
+    }
+    case Method::kDecompress: {
+      MonitorDecompress(mode, reinterpret_cast<DecompressTask *>(task), rctx);
+      break;
+    }
+  }
+}
+/** Delete a task */
+void Del(const hipc::MemContext &mctx, u32 method, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      CHI_CLIENT->DelTask<CreateTask>(mctx, reinterpret_cast<CreateTask *>(task));
+      break;
+    }
+    case Method::kDestroy: {
+      CHI_CLIENT->DelTask<DestroyTask>(mctx, reinterpret_cast<DestroyTask *>(task));
+      break;
+    }
+    case Method::kCompress: {
+      CHI_CLIENT->DelTask<CompressTask>(mctx, reinterpret_cast<CompressTask *>(task));
+      break;
+    }
+    case Method::kDecompress: {
+      CHI_CLIENT->DelTask<DecompressTask>(mctx, reinterpret_cast<DecompressTask *>(task));
+      break;
+    }
+  }
+}
+/** Duplicate a task */
+void CopyStart(u32 method, const Task *orig_task, Task *dup_task, bool deep) override {
+  switch (method) {
+    case Method::kCreate: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const CreateTask*>(orig_task), 
+        reinterpret_cast<CreateTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kDestroy: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const DestroyTask*>(orig_task), 
+        reinterpret_cast<DestroyTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kCompress: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const CompressTask*>(orig_task), 
+        reinterpret_cast<CompressTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kDecompress: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const DecompressTask*>(orig_task), 
+        reinterpret_cast<DecompressTask*>(dup_task), deep);
+      break;
+    }
+  }
+}
+/** Duplicate a task */
+void NewCopyStart(u32 method, const Task *orig_task, FullPtr<Task> &dup_task, bool deep) override {
+  switch (method) {
+    case Method::kCreate: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const CreateTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kDestroy: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const DestroyTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kCompress: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const CompressTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kDecompress: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const DecompressTask*>(orig_task), dup_task, deep);
+      break;
+    }
+  }
+}
+/** Serialize a task when initially pushing into remote */
+void SaveStart(
+    u32 method, BinaryOutputArchive<true> &ar,
+    Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar << *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar << *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kCompress: {
+      ar << *reinterpret_cast<CompressTask*>(task);
+      break;
+    }
+    case Method::kDecompress: {
+      ar << *reinterpret_cast<DecompressTask*>(task);
+      break;
+    }
+  }
+}
+/** Deserialize a task when popping from remote queue */
+TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> &ar) override {
+  TaskPointer task_ptr;
+  switch (method) {
+    case Method::kCreate: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<CreateTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<CreateTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kDestroy: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<DestroyTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<DestroyTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kCompress: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<CompressTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<CompressTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kDecompress: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<DecompressTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<DecompressTask*>(task_ptr.ptr_);
+      break;
+    }
+  }
+  return task_ptr;
+}
+/** Serialize a task when returning from remote queue */
+void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar << *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar << *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kCompress: {
+      ar << *reinterpret_cast<CompressTask*>(task);
+      break;
+    }
+    case Method::kDecompress: {
+      ar << *reinterpret_cast<DecompressTask*>(task);
+      break;
+    }
+  }
+}
+/** Deserialize a task when popping from remote queue */
+void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar >> *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar >> *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kCompress: {
+      ar >> *reinterpret_cast<CompressTask*>(task);
+      break;
+    }
+    case Method::kDecompress: {
+      ar >> *reinterpret_cast<DecompressTask*>(task);
+      break;
+    }
+  }
+}
+/** Method dispatch table (indexed by method) */
+static const chi::MethodTable &GetMethodTable() {
+  static constexpr chi::RunMethod_t kRun[Method::kCount] = {
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Create(
+        reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Destroy(
+        reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Compress(
+        reinterpret_cast<CompressTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Decompress(
+        reinterpret_cast<DecompressTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::MonitorMethod_t kMonitor[Method::kCount] = {
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCreate(
+        mode, reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroy(
+        mode, reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCompress(
+        mode, reinterpret_cast<CompressTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDecompress(
+        mode, reinterpret_cast<DecompressTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::DelMethod_t kDel[Method::kCount] = {
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CreateTask>(
+        mctx, reinterpret_cast<CreateTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyTask>(
+        mctx, reinterpret_cast<DestroyTask *>(task));
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CompressTask>(
+        mctx, reinterpret_cast<CompressTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DecompressTask>(
+        mctx, reinterpret_cast<DecompressTask *>(task));
+    },
+  };
+  static constexpr chi::MethodTable kTable = {kRun, kMonitor, kDel, Method::kCount};
+  return kTable;
+}
+
+#endif  // CHI_COMPRESSOR_LIB_EXEC_H_
\ No newline at end of file
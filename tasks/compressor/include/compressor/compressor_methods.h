@@ -0,0 +1,11 @@
+#ifndef CHI_COMPRESSOR_METHODS_H_
+#define CHI_COMPRESSOR_METHODS_H_
+
+/** The set of methods in the compressor task */
+struct Method : public chi::TaskMethod {
+  TASK_METHOD_T kCompress = 10;
+  TASK_METHOD_T kDecompress = 11;
+  TASK_METHOD_T kCount = 12;
+};
+
+#endif  // CHI_COMPRESSOR_METHODS_H_
\ No newline at end of file
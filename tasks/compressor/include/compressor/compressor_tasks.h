@@ -0,0 +1,138 @@
+//
+// Created by lukemartinlogan on 8/11/23.
+//
+
+#ifndef CHI_TASKS_TASK_TEMPL_INCLUDE_compressor_compressor_TASKS_H_
+#define CHI_TASKS_TASK_TEMPL_INCLUDE_compressor_compressor_TASKS_H_
+
+#include "chimaera/chimaera_namespace.h"
+
+namespace chi::compressor {
+
+#include "compressor_methods.h"
+CHI_NAMESPACE_INIT
+
+/** The compression libraries */
+struct Codec {
+  CLS_CONST u32 kNone = 0;   /**< Copy the data as-is */
+  CLS_CONST u32 kZlib = 1;
+  CLS_CONST u32 kLz4 = 2;
+  CLS_CONST u32 kZstd = 3;
+  CLS_CONST u32 kSnappy = 4;
+  CLS_CONST u32 kCount = 5;
+  /** Pick the codec by sampling the ratio and speed of each */
+  CLS_CONST u32 kAuto = UINT32_MAX;
+};
+
+/** An output buffer large enough to compress \a size bytes with any codec */
+HSHM_INLINE_CROSS_FUN
+static size_t GetCompressBound(size_t size) {
+  // Snappy has the largest worst case: 32 + size + size / 6
+  return size + size / 6 + 64;
+}
+
+/**
+ * A task to create compressor
+ * */
+struct CreateTaskParams {
+  CLS_CONST char *lib_name_ = "chimaera_compressor";
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams() = default;
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc) {}
+
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void serialize(Ar &ar) {}
+};
+typedef chi::Admin::CreatePoolBaseTask<CreateTaskParams> CreateTask;
+
+/** A task to destroy compressor */
+typedef chi::Admin::DestroyContainerTask DestroyTask;
+
+/**
+ * Compress or decompress \a size_ bytes of \a data_ into \a out_,
+ * a buffer of \a out_cap_ bytes
+ * */
+template <int method>
+struct CodecTaskTempl : public Task, TaskFlags<TF_SRL_SYM> {
+  IN hipc::Pointer data_;
+  IN size_t size_;
+  IN hipc::Pointer out_;
+  IN size_t out_cap_;
+  INOUT u32 codec_; /**< The Codec, set if kAuto was requested */
+  OUT size_t out_size_;
+  OUT bool success_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit CodecTaskTempl(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit CodecTaskTempl(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                          const TaskNode &task_node, const PoolId &pool_id,
+                          const DomainQuery &dom_query, u32 codec,
+                          const hipc::Pointer &data, size_t size,
+                          const hipc::Pointer &out, size_t out_cap)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    if constexpr (method == 0) {
+      method_ = Method::kCompress;
+    } else {
+      method_ = Method::kDecompress;
+    }
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    codec_ = codec;
+    data_ = data;
+    size_ = size;
+    out_ = out;
+    out_cap_ = out_cap;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const CodecTaskTempl &other, bool deep) {
+    codec_ = other.codec_;
+    data_ = other.data_;
+    size_ = other.size_;
+    out_ = other.out_;
+    out_cap_ = other.out_cap_;
+    if (!deep) {
+      UnsetDataOwner();
+    }
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar.bulk(DT_WRITE, data_, size_);
+    ar.bulk(DT_EXPOSE, out_, out_cap_);
+    ar(codec_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar.bulk(DT_WRITE, out_, out_cap_);
+    ar(codec_, out_size_, success_);
+  }
+};
+
+/** A task to compress a buffer */
+using CompressTask = CodecTaskTempl<0>;
+
+/** A task to decompress a buffer */
+using DecompressTask = CodecTaskTempl<1>;
+
+}  // namespace chi::compressor
+
+#endif  // CHI_TASKS_TASK_TEMPL_INCLUDE_compressor_compressor_TASKS_H_
@@ -0,0 +1 @@
+#include "compressor/compressor_client.h"
\ No newline at end of file
@@ -0,0 +1,206 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <hermes_shm/util/compress/lz4.h>
+#include <hermes_shm/util/compress/snappy.h>
+#include <hermes_shm/util/compress/zlib.h>
+#include <hermes_shm/util/compress/zstd.h>
+#include <hermes_shm/util/timer.h>
+
+#include "chimaera/api/chimaera_runtime.h"
+#include "chimaera/monitor/monitor.h"
+#include "chimaera_admin/chimaera_admin_client.h"
+#include "compressor/compressor_client.h"
+
+namespace chi::compressor {
+
+class Server : public Module {
+public:
+  std::atomic<u32> auto_codec_;  /**< The codec last picked by sampling */
+  std::atomic<size_t> auto_count_;
+  RollingAverage monitor_[Method::kCount];
+  CLS_CONST LaneGroupId kDefaultGroup = 0;
+  /** Bytes of input compressed with each codec when sampling */
+  CLS_CONST size_t kSampleSize = KILOBYTES(64);
+  /** Auto tasks between samplings */
+  CLS_CONST size_t kSamplePeriod = 64;
+
+public:
+  Server() = default;
+
+  /** Construct compressor */
+  void Create(CreateTask *task, RunContext &rctx) {
+    auto_codec_ = Codec::kAuto;
+    auto_count_ = 0;
+    // Compression is CPU-bound, so one lane per worker that can poll it
+    size_t num_lanes =
+        std::max<size_t>(CHI_WORK_ORCHESTRATOR->oworkers_.size(), 1);
+    CreateLaneGroup(kDefaultGroup, num_lanes, QUEUE_HIGH_LATENCY);
+
+    // Create monitoring functions
+    for (int i = 0; i < Method::kCount; ++i) {
+      monitor_[i].Shape(hshm::Formatter::format("{}-method-{}", name_, i));
+    }
+  }
+  void MonitorCreate(MonitorModeId mode, CreateTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kCreate, mode, rctx);
+  }
+
+  /** Route a task to the least loaded lane */
+  Lane *MapTaskToLane(const Task *task) override {
+    return GetLeastLoadedLane(
+        kDefaultGroup, task->prio_,
+        [](Load &lhs, Load &rhs) { return lhs.cpu_load_ < rhs.cpu_load_; });
+  }
+
+  /** Destroy compressor */
+  void Destroy(DestroyTask *task, RunContext &rctx) {}
+  void MonitorDestroy(MonitorModeId mode, DestroyTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kDestroy, mode, rctx);
+  }
+
+  /** Compress a buffer */
+  void Compress(CompressTask *task, RunContext &rctx) {
+    char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+    char *out = HSHM_MEMORY_MANAGER->Convert<char>(task->out_);
+    if (task->codec_ == Codec::kAuto) {
+      task->codec_ = GetAutoCodec(data, task->size_);
+    }
+    task->out_size_ = task->out_cap_;
+    task->success_ = RunCodec(task->codec_, true, data, task->size_, out,
+                              task->out_size_);
+  }
+  void MonitorCompress(MonitorModeId mode, CompressTask *task,
+                       RunContext &rctx) {
+    AverageMonitor(Method::kCompress, mode, rctx);
+  }
+
+  /** Decompress a buffer */
+  void Decompress(DecompressTask *task, RunContext &rctx) {
+    char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+    char *out = HSHM_MEMORY_MANAGER->Convert<char>(task->out_);
+    task->out_size_ = task->out_cap_;
+    task->success_ = RunCodec(task->codec_, false, data, task->size_, out,
+                              task->out_size_);
+  }
+  void MonitorDecompress(MonitorModeId mode, DecompressTask *task,
+                         RunContext &rctx) {
+    AverageMonitor(Method::kDecompress, mode, rctx);
+  }
+
+private:
+  /**
+   * Get the codec for a Codec::kAuto task.
+   * Every kSamplePeriod tasks, the start of the input is compressed
+   * with each codec, and the codec saving the most bytes per
+   * nanosecond is kept. Data that does not compress is copied.
+   * */
+  u32 GetAutoCodec(char *data, size_t size) {
+    u32 codec = auto_codec_.load();
+    size_t count = auto_count_++;
+    if (codec != Codec::kAuto && count % kSamplePeriod != 0) {
+      return codec;
+    }
+    size_t sample_size = std::min(size, kSampleSize);
+    std::vector<char> sample(GetCompressBound(sample_size));
+    u32 best_codec = Codec::kNone;
+    double best_score = 0;
+    for (u32 i = Codec::kNone + 1; i < Codec::kCount; ++i) {
+      size_t out_size = sample.size();
+      hshm::Timer t;
+      t.Resume();
+      bool ret = RunCodec(i, true, data, sample_size, sample.data(), out_size);
+      t.Pause();
+      if (!ret || out_size >= sample_size) {
+        continue;
+      }
+      double score = (double)(sample_size - out_size) / (t.GetNsec() + 1);
+      if (score > best_score) {
+        best_score = score;
+        best_codec = i;
+      }
+    }
+    auto_codec_ = best_codec;
+    return best_codec;
+  }
+
+  /**
+   * Compress or decompress with a codec.
+   * \a out_size is the capacity of \a out, and is set to the bytes produced.
+   * */
+  bool RunCodec(u32 codec, bool compress, char *data, size_t size, char *out,
+                size_t &out_size) {
+    switch (codec) {
+    case Codec::kNone: {
+      if (out_size < size) {
+        return false;
+      }
+      memcpy(out, data, size);
+      out_size = size;
+      return true;
+    }
+    case Codec::kZlib: {
+      return RunCodec<hshm::Zlib>(compress, data, size, out, out_size);
+    }
+    case Codec::kLz4: {
+      return RunCodec<hshm::Lz4>(compress, data, size, out, out_size);
+    }
+    case Codec::kZstd: {
+      return RunCodec<hshm::Zstd>(compress, data, size, out, out_size);
+    }
+    case Codec::kSnappy: {
+      return RunCodec<hshm::Snappy>(compress, data, size, out, out_size);
+    }
+    default: {
+      HELOG(kError, "Unknown codec {}", codec);
+      return false;
+    }
+    }
+  }
+
+  /** Compress or decompress with an hshm codec */
+  template <typename CompressT>
+  bool RunCodec(bool compress, char *data, size_t size, char *out,
+                size_t &out_size) {
+    CompressT codec;
+    if (compress) {
+      return codec.Compress(out, out_size, data, size);
+    } else {
+      return codec.Decompress(out, out_size, data, size);
+    }
+  }
+
+  /** Rolling average for most tasks */
+  void AverageMonitor(MethodId method, MonitorModeId mode, RunContext &rctx) {
+    switch (mode) {
+    case MonitorMode::kEstLoad: {
+      rctx.load_.cpu_load_ = monitor_[method].Predict();
+      break;
+    }
+    case MonitorMode::kSampleLoad: {
+      monitor_[method].Add(rctx.timer_->GetNsec(), rctx.load_);
+      break;
+    }
+    case MonitorMode::kReinforceLoad: {
+      monitor_[method].DoTrain();
+      break;
+    }
+    }
+  }
+
+public:
+#include "compressor/compressor_lib_exec.h"
+};
+
+} // namespace chi::compressor
+
+CHI_TASK_CC(chi::compressor::Server, "compressor");
@@ -0,0 +1,136 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef CHI_kvstore_H_
+#define CHI_kvstore_H_
+
+#include "kvstore_tasks.h"
+
+namespace chi::kvstore {
+
+/** Create kvstore requests */
+class Client : public ModuleClient {
+public:
+  /** Default constructor */
+  Client() = default;
+
+  /** Destructor */
+  ~Client() = default;
+
+  /** Create a kvstore logging to the bdev pool \a bdev_id */
+  HSHM_INLINE_CROSS_FUN
+  void Create(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+              const DomainQuery &affinity, const chi::string &pool_name,
+              const PoolId &bdev_id, u32 compact_period_ms = 1000,
+              const CreateContext &ctx = CreateContext()) {
+    FullPtr<CreateTask> task = AsyncCreate(mctx, dom_query, affinity,
+                                           pool_name, ctx, bdev_id,
+                                           compact_period_ms);
+    task->Wait();
+    Init(task->ctx_.id_);
+    CHI_CLIENT->DelTask(mctx, task);
+  }
+  CHI_TASK_METHODS(Create);
+
+  /** Destroy pool + queue */
+  HSHM_INLINE_CROSS_FUN
+  void Destroy(const hipc::MemContext &mctx, const DomainQuery &dom_query) {
+    CHI_ADMIN->DestroyContainer(mctx, dom_query, pool_id_);
+  }
+
+  /** Store a value under a key */
+  HSHM_INLINE_CROSS_FUN
+  bool Put(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+           const chi::string &key, const hipc::Pointer &data, size_t size) {
+    FullPtr<PutTask> task = AsyncPut(mctx, dom_query, key, data, size);
+    task.ptr_->Wait();
+    bool success = task->success_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return success;
+  }
+  CHI_TASK_METHODS(Put);
+
+  /**
+   * Read the value of a key into a buffer of \a size bytes.
+   * \a value_size is set to the full size of the value.
+   * */
+  HSHM_INLINE_CROSS_FUN
+  bool Get(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+           const chi::string &key, const hipc::Pointer &data, size_t size,
+           size_t &value_size) {
+    FullPtr<GetTask> task = AsyncGet(mctx, dom_query, key, data, size);
+    task.ptr_->Wait();
+    bool success = task->success_;
+    value_size = task->value_size_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return success;
+  }
+  CHI_TASK_METHODS(Get);
+
+  /** Remove a key */
+  HSHM_INLINE_CROSS_FUN
+  bool Delete(const hipc::MemContext &mctx, const DomainQuery &dom_query,
+              const chi::string &key) {
+    FullPtr<DeleteTask> task = AsyncDelete(mctx, dom_query, key);
+    task.ptr_->Wait();
+    bool success = task->success_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return success;
+  }
+  CHI_TASK_METHODS(Delete);
+
+  /** List up to \a max_keys keys starting with \a prefix */
+  HSHM_INLINE_CROSS_FUN
+  std::vector<std::string> Scan(const hipc::MemContext &mctx,
+                                const DomainQuery &dom_query,
+                                const chi::string &prefix, size_t max_keys) {
+    FullPtr<ScanTask> task = AsyncScan(mctx, dom_query, prefix, max_keys);
+    task.ptr_->Wait();
+    std::vector<std::string> keys;
+    keys.reserve(task->keys_.size());
+    for (chi::ipc::string &key : task->keys_) {
+      keys.emplace_back(key.str());
+    }
+    CHI_CLIENT->DelTask(mctx, task);
+    return keys;
+  }
+  CHI_TASK_METHODS(Scan);
+
+  /** Compact the log now, returning the bytes reclaimed */
+  HSHM_INLINE_CROSS_FUN
+  size_t Compact(const hipc::MemContext &mctx, const DomainQuery &dom_query) {
+    FullPtr<CompactTask> task = AsyncCompact(mctx, dom_query, 0);
+    task.ptr_->Wait();
+    size_t reclaimed = task->reclaimed_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return reclaimed;
+  }
+  CHI_TASK_METHODS(Compact);
+
+  /** Get the statistics of the kvstore */
+  HSHM_INLINE_CROSS_FUN
+  KvStats PollStats(const hipc::MemContext &mctx,
+                    const DomainQuery &dom_query) {
+    FullPtr<PollStatsTask> task = AsyncPollStats(mctx, dom_query);
+    task.ptr_->Wait();
+    KvStats stats = task->stats_;
+    CHI_CLIENT->DelTask(mctx, task);
+    return stats;
+  }
+  CHI_TASK_METHODS(PollStats);
+
+  CHI_AUTOGEN_METHODS // keep at class bottom
+};
+
+} // namespace chi::kvstore
+
+#endif // CHI_kvstore_H_
@@ -0,0 +1,505 @@
+#ifndef CHI_KVSTORE_LIB_EXEC_H_
+#define CHI_KVSTORE_LIB_EXEC_H_
+
+/** Execute a task */
+void Run(u32 method, Task *task, RunContext &rctx) override {
+  switch (method) {
+    case Method::kCreate: {
+      Create(reinterpret_cast<CreateTask *>(task), rctx);
+      break;
+    }
+    case Method::kDestroy: {
+      Destroy(reinterpret_cast<DestroyTask *>(task), rctx);
+      break;
+    }
+    case Method::kPut: {
+      Put(reinterpret_cast<PutTask *>(task), rctx);
+      break;
+    }
+    case Method::kGet: {
+      Get(reinterpret_cast<GetTask *>(task), rctx);
+      break;
+    }
+    case Method::kDelete: {
+      Delete(reinterpret_cast<DeleteTask *>(task), rctx);
+      break;
+    }
+    case Method::kScan: {
+      Scan(reinterpret_cast<ScanTask *>(task), rctx);
+      break;
+    }
+    case Method::kCompact: {
+      Compact(reinterpret_cast<CompactTask *>(task), rctx);
+      break;
+    }
+    case Method::kPollStats: {
+      PollStats(reinterpret_cast<PollStatsTask *>(task), rctx);
+      break;
+    }
+  }
+}
+/** Execute a task */
+void Monitor(MonitorModeId mode, MethodId method, Task *task, RunContext &rctx) override {
+  switch (method) {
+    case Method::kCreate: {
+      MonitorCreate(mode, reinterpret_cast<CreateTask *>(task), rctx);
+      break;
+    }
+    case Method::kDestroy: {
+      MonitorDestroy(mode, reinterpret_cast<DestroyTask *>(task), rctx);
+      break;
+    }
+    case Method::kPut: {
+      MonitorPut(mode, reinterpret_cast<PutTask *>(task), rctx);
+      break;
+    }
+    case Method::kGet: {
+      MonitorGet(mode, reinterpret_cast<GetTask *>(task), rctx);
+      break;
+    }
+    case Method::kDelete: {
+      MonitorDelete(mode, reinterpret_cast<DeleteTask *>(task), rctx);
+      break;
+    }
+    case Method::kScan: {
+      MonitorScan(mode, reinterpret_cast<ScanTask *>(task), rctx);
+      break;
+    }
+    case Method::kCompact: {
+      MonitorCompact(mode, reinterpret_cast<CompactTask *>(task), rctx);
+      break;
+    }
+    case Method::kPollStats: {
+      MonitorPollStats(mode, reinterpret_cast<PollStatsTask *>(task), rctx);
+      break;
+    }
+  }
+}
+/** Delete a task */
+void Del(const hipc::MemContext &mctx, u32 method, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      CHI_CLIENT->DelTask<CreateTask>(mctx, reinterpret_cast<CreateTask *>(task));
+      break;
+    }
+    case Method::kDestroy: {
+      CHI_CLIENT->DelTask<DestroyTask>(mctx, reinterpret_cast<DestroyTask *>(task));
+      break;
+    }
+    case Method::kPut: {
+      CHI_CLIENT->DelTask<PutTask>(mctx, reinterpret_cast<PutTask *>(task));
+      break;
+    }
+    case Method::kGet: {
+      CHI_CLIENT->DelTask<GetTask>(mctx, reinterpret_cast<GetTask *>(task));
+      break;
+    }
+    case Method::kDelete: {
+      CHI_CLIENT->DelTask<DeleteTask>(mctx, reinterpret_cast<DeleteTask *>(task));
+      break;
+    }
+    case Method::kScan: {
+      CHI_CLIENT->DelTask<ScanTask>(mctx, reinterpret_cast<ScanTask *>(task));
+      break;
+    }
+    case Method::kCompact: {
+      CHI_CLIENT->DelTask<CompactTask>(mctx, reinterpret_cast<CompactTask *>(task));
+      break;
+    }
+    case Method::kPollStats: {
+      CHI_CLIENT->DelTask<PollStatsTask>(mctx, reinterpret_cast<PollStatsTask *>(task));
+      break;
+    }
+  }
+}
+/** Duplicate a task */
+void CopyStart(u32 method, const Task *orig_task, Task *dup_task, bool deep) override {
+  switch (method) {
+    case Method::kCreate: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const CreateTask*>(orig_task), 
+        reinterpret_cast<CreateTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kDestroy: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const DestroyTask*>(orig_task), 
+        reinterpret_cast<DestroyTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kPut: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const PutTask*>(orig_task), 
+        reinterpret_cast<PutTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kGet: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const GetTask*>(orig_task), 
+        reinterpret_cast<GetTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kDelete: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const DeleteTask*>(orig_task), 
+        reinterpret_cast<DeleteTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kScan: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const ScanTask*>(orig_task), 
+        reinterpret_cast<ScanTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kCompact: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const CompactTask*>(orig_task), 
+        reinterpret_cast<CompactTask*>(dup_task), deep);
+      break;
+    }
+    case Method::kPollStats: {
+      chi::CALL_COPY_START(
+        reinterpret_cast<const PollStatsTask*>(orig_task), 
+        reinterpret_cast<PollStatsTask*>(dup_task), deep);
+      break;
+    }
+  }
+}
+/** Duplicate a task */
+void NewCopyStart(u32 method, const Task *orig_task, FullPtr<Task> &dup_task, bool deep) override {
+  switch (method) {
+    case Method::kCreate: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const CreateTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kDestroy: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const DestroyTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kPut: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const PutTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kGet: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const GetTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kDelete: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const DeleteTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kScan: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const ScanTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kCompact: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const CompactTask*>(orig_task), dup_task, deep);
+      break;
+    }
+    case Method::kPollStats: {
+      chi::CALL_NEW_COPY_START(reinterpret_cast<const PollStatsTask*>(orig_task), dup_task, deep);
+      break;
+    }
+  }
+}
+/** Serialize a task when initially pushing into remote */
+void SaveStart(
+    u32 method, BinaryOutputArchive<true> &ar,
+    Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar << *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar << *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kPut: {
+      ar << *reinterpret_cast<PutTask*>(task);
+      break;
+    }
+    case Method::kGet: {
+      ar << *reinterpret_cast<GetTask*>(task);
+      break;
+    }
+    case Method::kDelete: {
+      ar << *reinterpret_cast<DeleteTask*>(task);
+      break;
+    }
+    case Method::kScan: {
+      ar << *reinterpret_cast<ScanTask*>(task);
+      break;
+    }
+    case Method::kCompact: {
+      ar << *reinterpret_cast<CompactTask*>(task);
+      break;
+    }
+    case Method::kPollStats: {
+      ar << *reinterpret_cast<PollStatsTask*>(task);
+      break;
+    }
+  }
+}
+/** Deserialize a task when popping from remote queue */
+TaskPointer LoadStart(    u32 method, BinaryInputArchive<true> &ar) override {
+  TaskPointer task_ptr;
+  switch (method) {
+    case Method::kCreate: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<CreateTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<CreateTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kDestroy: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<DestroyTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<DestroyTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kPut: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<PutTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<PutTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kGet: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<GetTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<GetTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kDelete: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<DeleteTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<DeleteTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kScan: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<ScanTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<ScanTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kCompact: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<CompactTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<CompactTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kPollStats: {
+      task_ptr.ptr_ = CHI_CLIENT->NewEmptyTask<PollStatsTask>(
+             HSHM_DEFAULT_MEM_CTX, task_ptr.shm_);
+      ar >> *reinterpret_cast<PollStatsTask*>(task_ptr.ptr_);
+      break;
+    }
+  }
+  return task_ptr;
+}
+/** Serialize a task when returning from remote queue */
+void SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar << *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar << *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kPut: {
+      ar << *reinterpret_cast<PutTask*>(task);
+      break;
+    }
+    case Method::kGet: {
+      ar << *reinterpret_cast<GetTask*>(task);
+      break;
+    }
+    case Method::kDelete: {
+      ar << *reinterpret_cast<DeleteTask*>(task);
+      break;
+    }
+    case Method::kScan: {
+      ar << *reinterpret_cast<ScanTask*>(task);
+      break;
+    }
+    case Method::kCompact: {
+      ar << *reinterpret_cast<CompactTask*>(task);
+      break;
+    }
+    case Method::kPollStats: {
+      ar << *reinterpret_cast<PollStatsTask*>(task);
+      break;
+    }
+  }
+}
+/** Deserialize a task when popping from remote queue */
+void LoadEnd(u32 method, BinaryInputArchive<false> &ar, Task *task) override {
+  switch (method) {
+    case Method::kCreate: {
+      ar >> *reinterpret_cast<CreateTask*>(task);
+      break;
+    }
+    case Method::kDestroy: {
+      ar >> *reinterpret_cast<DestroyTask*>(task);
+      break;
+    }
+    case Method::kPut: {
+      ar >> *reinterpret_cast<PutTask*>(task);
+      break;
+    }
+    case Method::kGet: {
+      ar >> *reinterpret_cast<GetTask*>(task);
+      break;
+    }
+    case Method::kDelete: {
+      ar >> *reinterpret_cast<DeleteTask*>(task);
+      break;
+    }
+    case Method::kScan: {
+      ar >> *reinterpret_cast<ScanTask*>(task);
+      break;
+    }
+    case Method::kCompact: {
+      ar >> *reinterpret_cast<CompactTask*>(task);
+      break;
+    }
+    case Method::kPollStats: {
+      ar >> *reinterpret_cast<PollStatsTask*>(task);
+      break;
+    }
+  }
+}
+/** Method dispatch table (indexed by method) */
+static const chi::MethodTable &GetMethodTable() {
+  static constexpr chi::RunMethod_t kRun[Method::kCount] = {
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Create(
+        reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Destroy(
+        reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Put(
+        reinterpret_cast<PutTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Get(
+        reinterpret_cast<GetTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Delete(
+        reinterpret_cast<DeleteTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Scan(
+        reinterpret_cast<ScanTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->Compact(
+        reinterpret_cast<CompactTask *>(task), rctx);
+    },
+    [](Container *exec, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->PollStats(
+        reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::MonitorMethod_t kMonitor[Method::kCount] = {
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCreate(
+        mode, reinterpret_cast<CreateTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDestroy(
+        mode, reinterpret_cast<DestroyTask *>(task), rctx);
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorPut(
+        mode, reinterpret_cast<PutTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorGet(
+        mode, reinterpret_cast<GetTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorDelete(
+        mode, reinterpret_cast<DeleteTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorScan(
+        mode, reinterpret_cast<ScanTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorCompact(
+        mode, reinterpret_cast<CompactTask *>(task), rctx);
+    },
+    [](Container *exec, MonitorModeId mode, Task *task, RunContext &rctx) {
+      static_cast<Server *>(exec)->MonitorPollStats(
+        mode, reinterpret_cast<PollStatsTask *>(task), rctx);
+    },
+  };
+  static constexpr chi::DelMethod_t kDel[Method::kCount] = {
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CreateTask>(
+        mctx, reinterpret_cast<CreateTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DestroyTask>(
+        mctx, reinterpret_cast<DestroyTask *>(task));
+    },
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<PutTask>(
+        mctx, reinterpret_cast<PutTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<GetTask>(
+        mctx, reinterpret_cast<GetTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<DeleteTask>(
+        mctx, reinterpret_cast<DeleteTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<ScanTask>(
+        mctx, reinterpret_cast<ScanTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<CompactTask>(
+        mctx, reinterpret_cast<CompactTask *>(task));
+    },
+    [](const hipc::MemContext &mctx, Task *task) {
+      CHI_CLIENT->DelTask<PollStatsTask>(
+        mctx, reinterpret_cast<PollStatsTask *>(task));
+    },
+  };
+  static constexpr chi::MethodTable kTable = {kRun, kMonitor, kDel, Method::kCount};
+  return kTable;
+}
+
+#endif  // CHI_KVSTORE_LIB_EXEC_H_
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef CHI_KVSTORE_METHODS_H_
+#define CHI_KVSTORE_METHODS_H_
+
+/** The set of methods in the kvstore task */
+struct Method : public chi::TaskMethod {
+  TASK_METHOD_T kPut = 10;
+  TASK_METHOD_T kGet = 11;
+  TASK_METHOD_T kDelete = 12;
+  TASK_METHOD_T kScan = 13;
+  TASK_METHOD_T kCompact = 14;
+  TASK_METHOD_T kPollStats = 15;
+  TASK_METHOD_T kCount = 16;
+};
+
+#endif  // CHI_KVSTORE_METHODS_H_
\ No newline at end of file
@@ -0,0 +1,390 @@
+//
+// Created by lukemartinlogan on 8/11/23.
+//
+
+#ifndef CHI_TASKS_TASK_TEMPL_INCLUDE_kvstore_kvstore_TASKS_H_
+#define CHI_TASKS_TASK_TEMPL_INCLUDE_kvstore_kvstore_TASKS_H_
+
+#include "chimaera/chimaera_namespace.h"
+
+namespace chi::kvstore {
+
+#include "kvstore_methods.h"
+CHI_NAMESPACE_INIT
+
+/** Key-value store statistics */
+struct KvStats {
+  size_t keys_;        /**< Keys stored */
+  size_t live_bytes_;  /**< Bytes of values reachable from the index */
+  size_t log_bytes_;   /**< Bytes of bdev held by log segments */
+  size_t compactions_; /**< Log segments reclaimed by compaction */
+  size_t moved_bytes_; /**< Bytes of values moved by compaction */
+
+  template <typename Ar>
+  void serialize(Ar &ar) {
+    ar(keys_, live_bytes_, log_bytes_, compactions_, moved_bytes_);
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const KvStats &stats) {
+    os << hshm::Formatter::format(
+        "Keys: {}, Live: {} bytes, Log: {} bytes, Compactions: {}, "
+        "Moved: {} bytes",
+        stats.keys_, stats.live_bytes_, stats.log_bytes_, stats.compactions_,
+        stats.moved_bytes_);
+    return os;
+  }
+};
+
+/**
+ * A task to create kvstore
+ * */
+struct CreateTaskParams {
+  CLS_CONST char *lib_name_ = "chimaera_kvstore";
+  IN PoolId bdev_id_;          /**< The bdev pool holding the log */
+  IN u32 compact_period_ms_;   /**< Period of compaction, 0 to disable */
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams() = default;
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc) {}
+
+  HSHM_INLINE_CROSS_FUN
+  CreateTaskParams(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                   const PoolId &bdev_id, u32 compact_period_ms = 1000) {
+    bdev_id_ = bdev_id;
+    compact_period_ms_ = compact_period_ms;
+  }
+
+  template <typename Ar>
+  void serialize(Ar &ar) {
+    ar(bdev_id_, compact_period_ms_);
+  }
+};
+typedef chi::Admin::CreatePoolBaseTask<CreateTaskParams> CreateTask;
+
+/** A task to destroy kvstore */
+typedef chi::Admin::DestroyContainerTask DestroyTask;
+
+/**
+ * Store a value under a key, replacing any prior value
+ * */
+struct PutTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN chi::ipc::string key_;
+  IN hipc::Pointer data_;
+  IN size_t size_;
+  OUT bool success_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit PutTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), key_(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit PutTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                   const TaskNode &task_node, const PoolId &pool_id,
+                   const DomainQuery &dom_query, const chi::string &key,
+                   const hipc::Pointer &data, size_t size)
+      : Task(alloc), key_(alloc, key) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kPut;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    data_ = data;
+    size_ = size;
+  }
+
+  /** The key that LanePolicy::kKey keeps on one ingress lane */
+  HSHM_INLINE
+  u32 GetLaneKey() const { return std::hash<std::string>{}(key_.str()); }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const PutTask &other, bool deep) {
+    key_ = other.key_;
+    data_ = other.data_;
+    size_ = other.size_;
+    if (!deep) {
+      UnsetDataOwner();
+    }
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar(key_);
+    ar.bulk(DT_WRITE, data_, size_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(success_);
+  }
+};
+
+/**
+ * Read the value of a key into a buffer of \a size_ bytes
+ * */
+struct GetTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN chi::ipc::string key_;
+  IN hipc::Pointer data_;
+  IN size_t size_;
+  OUT size_t value_size_; /**< The size of the value, even if truncated */
+  OUT bool success_;      /**< Whether the key exists */
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit GetTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), key_(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit GetTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                   const TaskNode &task_node, const PoolId &pool_id,
+                   const DomainQuery &dom_query, const chi::string &key,
+                   const hipc::Pointer &data, size_t size)
+      : Task(alloc), key_(alloc, key) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kGet;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    data_ = data;
+    size_ = size;
+  }
+
+  /** The key that LanePolicy::kKey keeps on one ingress lane */
+  HSHM_INLINE
+  u32 GetLaneKey() const { return std::hash<std::string>{}(key_.str()); }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const GetTask &other, bool deep) {
+    key_ = other.key_;
+    data_ = other.data_;
+    size_ = other.size_;
+    if (!deep) {
+      UnsetDataOwner();
+    }
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar(key_);
+    ar.bulk(DT_EXPOSE, data_, size_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar.bulk(DT_WRITE, data_, size_);
+    ar(value_size_, success_);
+  }
+};
+
+/**
+ * Remove a key
+ * */
+struct DeleteTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN chi::ipc::string key_;
+  OUT bool success_; /**< Whether the key existed */
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit DeleteTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), key_(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit DeleteTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                      const TaskNode &task_node, const PoolId &pool_id,
+                      const DomainQuery &dom_query, const chi::string &key)
+      : Task(alloc), key_(alloc, key) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kDelete;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+  }
+
+  /** The key that LanePolicy::kKey keeps on one ingress lane */
+  HSHM_INLINE
+  u32 GetLaneKey() const { return std::hash<std::string>{}(key_.str()); }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const DeleteTask &other, bool deep) { key_ = other.key_; }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar(key_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(success_);
+  }
+};
+
+/**
+ * List up to \a max_keys_ keys starting with a prefix, in sorted order
+ * */
+struct ScanTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN chi::ipc::string prefix_;
+  IN size_t max_keys_;
+  OUT chi::ipc::vector<chi::ipc::string> keys_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit ScanTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc), prefix_(alloc), keys_(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit ScanTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                    const TaskNode &task_node, const PoolId &pool_id,
+                    const DomainQuery &dom_query, const chi::string &prefix,
+                    size_t max_keys)
+      : Task(alloc), prefix_(alloc, prefix), keys_(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kScan;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+
+    // Custom params
+    max_keys_ = max_keys;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const ScanTask &other, bool deep) {
+    prefix_ = other.prefix_;
+    max_keys_ = other.max_keys_;
+    keys_ = other.keys_;
+  }
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {
+    ar(prefix_, max_keys_);
+  }
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(keys_);
+  }
+};
+
+/**
+ * Reclaim log segments that are mostly garbage.
+ * Runs periodically if \a period_ms is non-zero.
+ * */
+struct CompactTask : public Task, TaskFlags<TF_SRL_SYM> {
+  OUT size_t reclaimed_; /**< Bytes of log reclaimed */
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit CompactTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit CompactTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                       const TaskNode &task_node, const PoolId &pool_id,
+                       const DomainQuery &dom_query, u32 period_ms)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    pool_ = pool_id;
+    method_ = Method::kCompact;
+    if (period_ms) {
+      task_flags_.SetBits(TASK_LONG_RUNNING);
+      prio_ = TaskPrioOpt::kHighLatency;
+    } else {
+      task_flags_.SetBits(0);
+      prio_ = TaskPrioOpt::kLowLatency;
+    }
+    dom_query_ = dom_query;
+
+    SetPeriodMs(period_ms);
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const CompactTask &other, bool deep) {}
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {}
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(reclaimed_);
+  }
+};
+
+/**
+ * Get the statistics of the kvstore
+ * */
+struct PollStatsTask : public Task, TaskFlags<TF_SRL_SYM> {
+  OUT KvStats stats_;
+
+  /** SHM default constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit PollStatsTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc)
+      : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_INLINE_CROSS_FUN
+  explicit PollStatsTask(const hipc::CtxAllocator<CHI_ALLOC_T> &alloc,
+                         const TaskNode &task_node, const PoolId &pool_id,
+                         const DomainQuery &dom_query)
+      : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    prio_ = TaskPrioOpt::kLowLatency;
+    pool_ = pool_id;
+    method_ = Method::kPollStats;
+    task_flags_.SetBits(0);
+    dom_query_ = dom_query;
+  }
+
+  /** Duplicate message */
+  HSHM_INLINE_CROSS_FUN
+  void CopyStart(const PollStatsTask &other, bool deep) {}
+
+  /** (De)serialize message call */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeStart(Ar &ar) {}
+
+  /** (De)serialize message return */
+  template <typename Ar>
+  HSHM_INLINE_CROSS_FUN void SerializeEnd(Ar &ar) {
+    ar(stats_);
+  }
+};
+
+}  // namespace chi::kvstore
+
+#endif  // CHI_TASKS_TASK_TEMPL_INCLUDE_kvstore_kvstore_TASKS_H_
@@ -0,0 +1 @@
+#include "kvstore/kvstore_client.h"
\ No newline at end of file
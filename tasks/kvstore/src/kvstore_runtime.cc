@@ -0,0 +1,455 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "bdev/bdev_client.h"
+#include "chimaera/api/chimaera_runtime.h"
+#include "chimaera/monitor/monitor.h"
+#include "chimaera/work_orchestrator/comutex.h"
+#include "chimaera_admin/chimaera_admin_client.h"
+#include "kvstore/kvstore_client.h"
+
+namespace chi::kvstore {
+
+/** The location of a value in the log */
+struct KvRecord {
+  u32 seg_;     /**< The segment holding the value */
+  size_t off_;  /**< Offset of the value in the segment */
+  size_t size_; /**< Size of the value */
+};
+
+/** A segment of the log, one bdev block */
+struct KvSegment {
+  Block block_;  /**< The bdev block of the segment */
+  size_t tail_;  /**< Bytes appended */
+  size_t live_;  /**< Bytes of values still in the index */
+};
+
+/**
+ * The keys hashing to one lane.
+ * Values are appended to the active segment, which is buffered in
+ * data shm and written to the bdev in one I/O once full. Overwritten
+ * and deleted values become garbage in their segment until it is
+ * compacted.
+ * */
+struct KvPartition {
+  CoMutex lock_;
+  std::unordered_map<std::string, KvRecord> index_;
+  std::unordered_map<u32, KvSegment> segs_;
+  u32 active_;          /**< The segment being appended, or kNoSegment */
+  u32 next_seg_;        /**< Id of the next segment */
+  FullPtr<char> buf_;   /**< Contents of the active segment */
+};
+
+class Server : public Module {
+public:
+  CreateTaskParams params_;
+  bdev::Client bdev_;
+  DomainQuery bdev_query_; /**< The bdev container holding the log */
+  CLS_CONST u32 kNumPartitions = 8;
+  KvPartition parts_[kNumPartitions];
+  CompactTask *compact_task_;
+  std::atomic<size_t> compactions_;
+  std::atomic<size_t> moved_bytes_;
+  RollingAverage monitor_[Method::kCount];
+  CLS_CONST LaneGroupId kMdGroup = 0;
+  CLS_CONST LaneGroupId kDataGroup = 1; /**< One lane per partition */
+  /** The largest contiguous block the bdev allocates */
+  CLS_CONST size_t kSegmentSize = MEGABYTES(1);
+  CLS_CONST u32 kNoSegment = UINT32_MAX;
+  /** Segments with at most this fraction live are compacted */
+  CLS_CONST float kCompactRatio = .5;
+
+public:
+  Server() = default;
+
+  /** Construct kvstore */
+  void Create(CreateTask *task, RunContext &rctx) {
+    params_ = task->GetParams();
+    bdev_.Init(params_.bdev_id_);
+    bdev_query_ =
+        DomainQuery::GetDirectId(SubDomain::kGlobalContainers, container_id_);
+    for (u32 i = 0; i < kNumPartitions; ++i) {
+      KvPartition &part = parts_[i];
+      part.lock_.SetName(
+          hshm::Formatter::format("kvstore.{}.partition.{}", name_, i));
+      part.active_ = kNoSegment;
+      part.next_seg_ = 0;
+    }
+    compactions_ = 0;
+    moved_bytes_ = 0;
+    CreateLaneGroup(kMdGroup, 1, QUEUE_LOW_LATENCY);
+    CreateLaneGroup(kDataGroup, kNumPartitions, QUEUE_LOW_LATENCY);
+
+    // Create monitoring functions
+    for (int i = 0; i < Method::kCount; ++i) {
+      monitor_[i].Shape(hshm::Formatter::format("{}-method-{}", name_, i));
+    }
+
+    // Schedule background compaction
+    compact_task_ = nullptr;
+    if (params_.compact_period_ms_) {
+      Client client;
+      client.Init(pool_id_);
+      compact_task_ =
+          client
+              .AsyncCompact(HSHM_MCTX,
+                            DomainQuery::GetDirectId(SubDomain::kContainerSet,
+                                                     container_id_),
+                            params_.compact_period_ms_)
+              .ptr_;
+    }
+  }
+  void MonitorCreate(MonitorModeId mode, CreateTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kCreate, mode, rctx);
+  }
+
+  /** Route keyed tasks to the lane of their partition */
+  Lane *MapTaskToLane(const Task *task) override {
+    switch (task->method_) {
+    case Method::kPut: {
+      auto *put_task = reinterpret_cast<const PutTask *>(task);
+      return GetLaneByHash(kDataGroup, task->prio_,
+                           HashKey(put_task->key_.str()));
+    }
+    case Method::kGet: {
+      auto *get_task = reinterpret_cast<const GetTask *>(task);
+      return GetLaneByHash(kDataGroup, task->prio_,
+                           HashKey(get_task->key_.str()));
+    }
+    case Method::kDelete: {
+      auto *del_task = reinterpret_cast<const DeleteTask *>(task);
+      return GetLaneByHash(kDataGroup, task->prio_,
+                           HashKey(del_task->key_.str()));
+    }
+    default: {
+      return GetLaneByHash(kMdGroup, task->prio_, 0);
+    }
+    }
+  }
+
+  /** Destroy kvstore */
+  void Destroy(DestroyTask *task, RunContext &rctx) {
+    if (compact_task_) {
+      compact_task_->SetTriggerComplete();
+      while (!compact_task_->IsComplete()) {
+        task->Yield();
+      }
+      CHI_CLIENT->DelTask(HSHM_MCTX, compact_task_);
+      compact_task_ = nullptr;
+    }
+    std::vector<Block> blocks;
+    for (KvPartition &part : parts_) {
+      ScopedCoMutex lock(part.lock_);
+      for (auto &it : part.segs_) {
+        blocks.emplace_back(it.second.block_);
+      }
+      if (!part.buf_.shm_.IsNull()) {
+        CHI_CLIENT->FreeBuffer(HSHM_MCTX, part.buf_);
+      }
+      part.index_.clear();
+      part.segs_.clear();
+      part.active_ = kNoSegment;
+    }
+    if (blocks.size()) {
+      bdev_.FreeBatch(HSHM_MCTX, bdev_query_, blocks);
+    }
+  }
+  void MonitorDestroy(MonitorModeId mode, DestroyTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kDestroy, mode, rctx);
+  }
+
+  /** Store a value under a key */
+  void Put(PutTask *task, RunContext &rctx) {
+    std::string key = task->key_.str();
+    KvPartition &part = GetPartition(key);
+    ScopedCoMutex lock(part.lock_);
+    char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+    task->success_ = Append(part, key, data, task->size_);
+  }
+  void MonitorPut(MonitorModeId mode, PutTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kPut, mode, rctx);
+  }
+
+  /** Read the value of a key */
+  void Get(GetTask *task, RunContext &rctx) {
+    std::string key = task->key_.str();
+    KvPartition &part = GetPartition(key);
+    ScopedCoMutex lock(part.lock_);
+    auto it = part.index_.find(key);
+    if (it == part.index_.end()) {
+      task->value_size_ = 0;
+      task->success_ = false;
+      return;
+    }
+    KvRecord &rec = it->second;
+    size_t size = std::min(rec.size_, task->size_);
+    task->value_size_ = rec.size_;
+    task->success_ = true;
+    if (size == 0) {
+      return;
+    }
+    if (rec.seg_ == part.active_) {
+      char *data = HSHM_MEMORY_MANAGER->Convert<char>(task->data_);
+      memcpy(data, part.buf_.ptr_ + rec.off_, size);
+    } else {
+      KvSegment &seg = part.segs_[rec.seg_];
+      task->success_ = bdev_.Read(HSHM_MCTX, bdev_query_, task->data_,
+                                  seg.block_.off_ + rec.off_, size);
+    }
+  }
+  void MonitorGet(MonitorModeId mode, GetTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kGet, mode, rctx);
+  }
+
+  /** Remove a key */
+  void Delete(DeleteTask *task, RunContext &rctx) {
+    std::string key = task->key_.str();
+    KvPartition &part = GetPartition(key);
+    ScopedCoMutex lock(part.lock_);
+    auto it = part.index_.find(key);
+    if (it == part.index_.end()) {
+      task->success_ = false;
+      return;
+    }
+    part.segs_[it->second.seg_].live_ -= it->second.size_;
+    part.index_.erase(it);
+    task->success_ = true;
+  }
+  void MonitorDelete(MonitorModeId mode, DeleteTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kDelete, mode, rctx);
+  }
+
+  /** List keys starting with a prefix */
+  void Scan(ScanTask *task, RunContext &rctx) {
+    std::string prefix = task->prefix_.str();
+    std::vector<std::string> keys;
+    for (KvPartition &part : parts_) {
+      ScopedCoMutex lock(part.lock_);
+      for (auto &it : part.index_) {
+        if (it.first.compare(0, prefix.size(), prefix) == 0) {
+          keys.emplace_back(it.first);
+        }
+      }
+    }
+    std::sort(keys.begin(), keys.end());
+    if (keys.size() > task->max_keys_) {
+      keys.resize(task->max_keys_);
+    }
+    task->keys_.reserve(keys.size());
+    for (std::string &key : keys) {
+      task->keys_.emplace_back(key);
+    }
+  }
+  void MonitorScan(MonitorModeId mode, ScanTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kScan, mode, rctx);
+  }
+
+  /**
+   * Reclaim sealed segments that are mostly garbage.
+   * Each victim is read in one I/O, its live values are appended to the
+   * active segment, and its block is returned to the bdev.
+   * */
+  void Compact(CompactTask *task, RunContext &rctx) {
+    task->reclaimed_ = 0;
+    std::vector<Block> blocks;
+    for (KvPartition &part : parts_) {
+      ScopedCoMutex lock(part.lock_);
+      task->reclaimed_ += CompactPartition(part, blocks);
+    }
+    if (blocks.size()) {
+      bdev_.FreeBatch(HSHM_MCTX, bdev_query_, blocks);
+    }
+  }
+  void MonitorCompact(MonitorModeId mode, CompactTask *task, RunContext &rctx) {
+    AverageMonitor(Method::kCompact, mode, rctx);
+  }
+
+  /** Poll kvstore statistics */
+  void PollStats(PollStatsTask *task, RunContext &rctx) {
+    KvStats &stats = task->stats_;
+    stats.keys_ = 0;
+    stats.live_bytes_ = 0;
+    stats.log_bytes_ = 0;
+    for (KvPartition &part : parts_) {
+      ScopedCoMutex lock(part.lock_);
+      stats.keys_ += part.index_.size();
+      for (auto &it : part.segs_) {
+        stats.live_bytes_ += it.second.live_;
+        stats.log_bytes_ += it.second.block_.size_;
+      }
+    }
+    stats.compactions_ = compactions_.load();
+    stats.moved_bytes_ = moved_bytes_.load();
+  }
+  void MonitorPollStats(MonitorModeId mode, PollStatsTask *task,
+                        RunContext &rctx) {
+    AverageMonitor(Method::kPollStats, mode, rctx);
+  }
+
+private:
+  /** Hash a key to its partition */
+  static size_t HashKey(const std::string &key) {
+    return std::hash<std::string>{}(key);
+  }
+
+  /** Get the partition of a key */
+  KvPartition &GetPartition(const std::string &key) {
+    return parts_[HashKey(key) % kNumPartitions];
+  }
+
+  /**
+   * Append a value to the log of a partition and index it.
+   * The partition must be locked.
+   * */
+  bool Append(KvPartition &part, const std::string &key, const char *data,
+              size_t size) {
+    if (size > kSegmentSize) {
+      HELOG(kError, "Value of {} bytes exceeds the segment size {}", size,
+            kSegmentSize);
+      return false;
+    }
+    if (part.active_ == kNoSegment ||
+        part.segs_[part.active_].tail_ + size > kSegmentSize) {
+      if (!OpenSegment(part)) {
+        return false;
+      }
+    }
+    KvSegment &seg = part.segs_[part.active_];
+    memcpy(part.buf_.ptr_ + seg.tail_, data, size);
+    auto it = part.index_.find(key);
+    if (it != part.index_.end()) {
+      part.segs_[it->second.seg_].live_ -= it->second.size_;
+    }
+    part.index_[key] = KvRecord{part.active_, seg.tail_, size};
+    seg.tail_ += size;
+    seg.live_ += size;
+    return true;
+  }
+
+  /** Seal the active segment and start a new one */
+  bool OpenSegment(KvPartition &part) {
+    if (!SealSegment(part)) {
+      return false;
+    }
+    std::vector<Block> blocks =
+        bdev_.Allocate(HSHM_MCTX, bdev_query_, kSegmentSize);
+    if (blocks.size() != 1 || blocks[0].size_ < kSegmentSize) {
+      HELOG(kError, "Could not allocate a log segment for {}", name_);
+      if (blocks.size()) {
+        bdev_.FreeBatch(HSHM_MCTX, bdev_query_, blocks);
+      }
+      return false;
+    }
+    if (part.buf_.shm_.IsNull()) {
+      part.buf_ = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, kSegmentSize);
+    }
+    u32 seg_id = part.next_seg_++;
+    part.segs_[seg_id] = KvSegment{blocks[0], 0, 0};
+    part.active_ = seg_id;
+    return true;
+  }
+
+  /** Write the active segment to the bdev */
+  bool SealSegment(KvPartition &part) {
+    if (part.active_ == kNoSegment) {
+      return true;
+    }
+    KvSegment &seg = part.segs_[part.active_];
+    if (seg.tail_ && !bdev_.Write(HSHM_MCTX, bdev_query_, part.buf_.shm_,
+                                  seg.block_.off_, seg.tail_)) {
+      HELOG(kError, "Could not write a log segment of {}", name_);
+      return false;
+    }
+    part.active_ = kNoSegment;
+    return true;
+  }
+
+  /** Compact the segments of a partition. The partition must be locked. */
+  size_t CompactPartition(KvPartition &part, std::vector<Block> &blocks) {
+    std::vector<u32> victims;
+    for (auto &it : part.segs_) {
+      KvSegment &seg = it.second;
+      if (it.first != part.active_ && seg.live_ <= seg.tail_ * kCompactRatio) {
+        victims.emplace_back(it.first);
+      }
+    }
+    if (victims.empty()) {
+      return 0;
+    }
+    size_t reclaimed = 0;
+    FullPtr<char> buf;
+    for (u32 seg_id : victims) {
+      KvSegment seg = part.segs_[seg_id];
+      if (seg.live_) {
+        if (buf.shm_.IsNull()) {
+          buf = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, kSegmentSize);
+        }
+        if (!bdev_.Read(HSHM_MCTX, bdev_query_, buf.shm_, seg.block_.off_,
+                        seg.tail_)) {
+          continue;
+        }
+        // Move the values still indexed
+        std::vector<std::pair<std::string, KvRecord>> moves;
+        for (auto &it : part.index_) {
+          if (it.second.seg_ == seg_id) {
+            moves.emplace_back(it);
+          }
+        }
+        bool moved = true;
+        for (auto &move : moves) {
+          moved &= Append(part, move.first, buf.ptr_ + move.second.off_,
+                          move.second.size_);
+          moved_bytes_ += move.second.size_;
+        }
+        if (!moved) {
+          continue;
+        }
+      }
+      part.segs_.erase(seg_id);
+      blocks.emplace_back(seg.block_);
+      reclaimed += seg.block_.size_;
+      compactions_ += 1;
+    }
+    if (!buf.shm_.IsNull()) {
+      CHI_CLIENT->FreeBuffer(HSHM_MCTX, buf);
+    }
+    return reclaimed;
+  }
+
+  /** Rolling average for most tasks */
+  void AverageMonitor(MethodId method, MonitorModeId mode, RunContext &rctx) {
+    switch (mode) {
+    case MonitorMode::kEstLoad: {
+      rctx.load_.cpu_load_ = monitor_[method].Predict();
+      break;
+    }
+    case MonitorMode::kSampleLoad: {
+      monitor_[method].Add(rctx.timer_->GetNsec(), rctx.load_);
+      break;
+    }
+    case MonitorMode::kReinforceLoad: {
+      monitor_[method].DoTrain();
+      break;
+    }
+    }
+  }
+
+public:
+#include "kvstore/kvstore_lib_exec.h"
+};
+
+} // namespace chi::kvstore
+
+CHI_TASK_CC(chi::kvstore::Server, "kvstore");
@@ -176,6 +176,10 @@ public:
 
     // Submit task
     if (dom_queries.size() == 0) {
+      // Routed again from scratch, so uncount it on the static container
+      if (orig_task->IsInFlight()) {
+        orig_task->rctx_.exec_->EndInFlight(orig_task);
+      }
       CHI_CLIENT->ScheduleTask(nullptr, FullPtr<Task>(orig_task));
       return;
     } else if (dom_queries.size() == 1) {
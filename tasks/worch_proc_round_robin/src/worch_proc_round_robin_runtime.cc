@@ -38,6 +38,9 @@ class Server : public Module {
 
   /** Schedule running processes */
   void Schedule(ScheduleTask *task, RunContext &rctx) {
+    if (!task->BeginRun()) {
+      return;
+    }
     CHI_WORK_ORCHESTRATOR->DedicateCores();
   }
   void MonitorSchedule(MonitorModeId mode, ScheduleTask *task,
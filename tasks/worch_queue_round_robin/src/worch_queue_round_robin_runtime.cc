@@ -11,6 +11,8 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "chimaera/api/chimaera_runtime.h"
+#include "chimaera/work_orchestrator/lane_balancer.h"
+#include "chimaera/work_orchestrator/work_orchestrator.h"
 #include "chimaera_admin/chimaera_admin_client.h"
 #include "worch_queue_round_robin/worch_queue_round_robin_client.h"
 
@@ -21,6 +23,7 @@ class Server : public Module {
   CLS_CONST LaneGroupId kDefaultGroup = 0;
   u32 count_lowlat_;
   u32 count_highlat_;
+  LaneBalancer balancer_;
 
  public:
   /** Construct work orchestrator queue scheduler */
@@ -41,21 +44,62 @@ class Server : public Module {
   void MonitorDestroy(MonitorModeId mode, DestroyTask *task, RunContext &rctx) {
   }
 
-  /** Check if low latency */
+  /**
+   * Check if low latency.
+   * Lanes do not accumulate an estimated load (the worker does not run
+   * kEstLoad per routed task), so this is the lane's priority.
+   * */
   bool IsLowLatency(Lane &lane) {
-    size_t num_tasks = lane.size();
-    if (num_tasks == 0) {
-      return lane.prio_ == TaskPrioOpt::kLowLatency;
-    }
-    size_t avg_cpu_load = lane.load_.cpu_load_ / num_tasks;
-    size_t avg_io_load = lane.load_.io_load_ / num_tasks;
-    return avg_cpu_load < KILOBYTES(50) && avg_io_load < KILOBYTES(8);
+    return lane.prio_ == TaskPrioOpt::kLowLatency;
   }
 
-  /** Schedule work orchestrator queues */
+  /**
+   * Predict the work queued in a lane.
+   * Lanes do not accumulate an estimated load, so the number of queued
+   * tasks is the proxy, each costing about a microsecond.
+   * */
+  size_t PredictLoad(Lane &lane) { return lane.size() * MICROSECONDS(1); }
+
+  /**
+   * Schedule work orchestrator queues.
+   * Reassigns lanes so that the predicted work of each worker is roughly
+   * even. Low-latency lanes stay on dedicated workers.
+   * */
   void Schedule(ScheduleTask *task, RunContext &rctx) {
-    // TODO(llogan): Finish
-    return;
+    if (!task->BeginRun()) {
+      return;
+    }
+    WorkOrchestrator *orch = CHI_WORK_ORCHESTRATOR;
+    std::vector<WorkerId> dworkers, oworkers;
+    for (Worker *worker : orch->dworkers_) {
+      dworkers.emplace_back(worker->id_);
+    }
+    for (Worker *worker : orch->oworkers_) {
+      oworkers.emplace_back(worker->id_);
+    }
+    if (dworkers.empty()) {
+      dworkers = oworkers;
+    } else if (oworkers.empty()) {
+      oworkers = dworkers;
+    }
+    // Snapshot the load of every lane
+    std::vector<Lane *> lanes;
+    std::vector<LaneLoadInfo> loads;
+    for (Container *container : CHI_MOD_REGISTRY->GetAllContainers()) {
+      for (std::shared_ptr<LaneGroup> &lane_group : container->lane_groups_) {
+        for (Lane &lane : lane_group->all_lanes_) {
+          lanes.emplace_back(&lane);
+          loads.emplace_back(
+              LaneLoadInfo{PredictLoad(lane), lane.worker_id_,
+                           IsLowLatency(lane)});
+        }
+      }
+    }
+    // Ask the owning workers to hand off the lanes
+    for (LaneMigration &migration :
+         balancer_.Balance(loads, dworkers, oworkers)) {
+      lanes[migration.lane_]->RequestMigration(migration.worker_id_);
+    }
   }
   void MonitorSchedule(MonitorModeId mode, ScheduleTask *task,
                        RunContext &rctx) {}
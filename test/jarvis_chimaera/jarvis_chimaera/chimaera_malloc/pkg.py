@@ -25,7 +25,20 @@ class ChimaeraMalloc(Interceptor):
 
         :return: List(dict)
         """
-        return []
+        return [
+            {
+                'name': 'threshold',
+                'msg': 'Allocations of at least this size go to shared memory',
+                'type': str,
+                'default': '1m',
+            },
+            {
+                'name': 'stats',
+                'msg': 'Dump allocation statistics at exit and on SIGUSR2',
+                'type': bool,
+                'default': False,
+            },
+        ]
 
     def _configure(self, **kwargs):
         """
@@ -39,6 +52,8 @@ class ChimaeraMalloc(Interceptor):
         if self.env['CHI_MALLOC'] is None:
             raise Exception('Could not find hermes_mpi')
         print(f'Found libchimaera_malloc.so at {self.env["CHI_MALLOC"]}')
+        self.env['CHI_MALLOC_THRESHOLD'] = self.config['threshold']
+        self.env['CHI_MALLOC_STATS'] = '1' if self.config['stats'] else '0'
 
     def modify_env(self):
         """
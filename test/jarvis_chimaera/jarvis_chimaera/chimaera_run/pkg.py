@@ -77,6 +77,15 @@ class ChimaeraRun(Service):
                 'class': 'communication',
                 'rank': 1,
             },
+            {
+                'name': 'hugepages',
+                'msg': 'Shared memory regions backed by hugepages '
+                       '(e.g., "task,data,rdata")',
+                'type': str,
+                'default': '',
+                'class': 'communication',
+                'rank': 1,
+            },
             {
                 'name': 'shm_name',
                 'msg': 'The base shared-memory name',
@@ -273,6 +282,11 @@ class ChimaeraRun(Service):
                 'lane_depth': self.config['lane_depth'],
             }
         }
+        hugepages = self.config['hugepages'].split(',')
+        qm = chimaera_server['queue_manager']
+        qm['shm_hugepages'] = 'task' in hugepages
+        qm['data_shm_hugepages'] = 'data' in hugepages
+        qm['rdata_shm_hugepages'] = 'rdata' in hugepages
         if self.config['worker_cpus'] is not None:
             chimaera_server['work_orchestrator']['cpus'] = self.config['worker_cpus']
         if len(self.config['monitor_out']):
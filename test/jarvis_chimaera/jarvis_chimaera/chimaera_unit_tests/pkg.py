@@ -26,7 +26,34 @@ class ChimaeraUnitTests(Application):
                                'TestSerialize',
                                'TestUpgrade',
                                'TestPython',
-                               'TestMalloc']
+                               'TestMalloc',
+                               'TestMallocStats',
+                               'TestBdevQos',
+                               'TestCoLockStats',
+                               'TestUpgradeInFlight',
+                               'TestFlushPool',
+                               'TestSwitchWorkOrchPolicy',
+                               'TestLaneBalancerSkew',
+                               'TestLaneBalancerLowLatency',
+                               'TestLaneBalancerStable',
+                               'TestCreatePoolsConcurrent',
+                               'TestBdevIoV',
+                               'TestBdevRamV',
+                               'TestBdevDirect',
+                               'TestBdevRamHugepages',
+                               'TestBdevRamThpNuma',
+                               'TestBdevStriped',
+                               'TestBdevStripedV',
+                               'TestBdevFreeBatch',
+                               'TestBdevChecksum',
+                               'TestCacheBdev',
+                               'TestKvstore',
+                               'TestCompressor',
+                               'TestTaskCache',
+                               'TestBufferWaitTimeout',
+                               'TestAdmission',
+                               'TestLanePolicy',
+                               'TestMallocThreadCache']
 
         self.test_rocm_execs = ['TestRocm']
         self.test_cuda_execs = ['TestCuda']
@@ -80,7 +107,7 @@ class ChimaeraUnitTests(Application):
         nprocs = self.config['nprocs']
         if self.config['nprocs'] is None:
             nprocs = len(self.jarvis.hostfile) 
-        if self.config['TEST_CASE'] == 'TestMalloc': 
+        if self.config['TEST_CASE'] in ['TestMalloc', 'TestMallocStats']:
             Exec(f'test_ipc_exec {self.config["TEST_CASE"]}',
                  LocalExecInfo(hostfile=self.jarvis.hostfile,
                                env=self.mod_env,
@@ -10,19 +10,54 @@
  * have access to the file, you may request a copy from help@hdfgroup.org.   *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#include <fcntl.h>
 #include <hermes_shm/util/affinity.h>
 #include <hermes_shm/util/timer.h>
 #include <mpi.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
 
 #include "basic_test.h"
 #include "bdev/bdev_client.h"
+#include "cache/cache_client.h"
 #include "chimaera/api/chimaera_client.h"
 #include "chimaera_admin/chimaera_admin_client.h"
+#include "compressor/compressor_client.h"
+#include "kvstore/kvstore_client.h"
 #include "omp.h"
 #include "small_message/small_message_client.h"
+#include "worch_queue_round_robin/worch_queue_round_robin_client.h"
 
 CHI_NAMESPACE_INIT
 
+/** Get the statistics of the lock named \a name on this node */
+static bool GetLockStats(const std::string &name, chi::CoLockStats &stats) {
+  std::vector<chi::CoLockStats> locks =
+      CHI_ADMIN->PollLockStats(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0));
+  for (chi::CoLockStats &lock : locks) {
+    if (lock.name_.str() == name) {
+      stats = lock;
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Get the number of scheduler runs of a work orchestrator policy */
+static size_t GetSchedulerRuns(const chi::PoolId &policy_id) {
+  std::vector<chi::SchedulerStats> scheds = CHI_ADMIN->PollSchedulerStats(
+      HSHM_MCTX, chi::DomainQuery::GetLocalHash(0));
+  for (chi::SchedulerStats &sched : scheds) {
+    if (sched.policy_id_ == policy_id) {
+      return sched.runs_;
+    }
+  }
+  return 0;
+}
+
 TEST_CASE("TestIpc") {
   CHIMAERA_CLIENT_INIT();
 
@@ -140,6 +175,202 @@ TEST_CASE("TestFlush") {
   HILOG(kInfo, "Latency: {} MOps", ops / t.GetUsec());
 }
 
+TEST_CASE("TestFlushPool") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::small_message::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_small_message");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ipc_test");
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  size_t ops = 256;
+  std::vector<FullPtr<chi::small_message::MdTask>> tasks;
+  tasks.reserve(ops);
+  for (size_t i = 0; i < ops; ++i) {
+    int cont_id = 1 + ((i + 1) % nprocs);
+    tasks.emplace_back(client.AsyncMd(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers,
+                                        cont_id),
+        0, 0));
+  }
+  // Only the small_message pool is flushed, but on every node
+  CHI_ADMIN->Flush(HSHM_MCTX, DomainQuery::GetGlobalBcast(), client.pool_id_);
+  for (FullPtr<chi::small_message::MdTask> &task : tasks) {
+    REQUIRE(task->IsComplete());
+    CHI_CLIENT->DelTask(HSHM_MCTX, task);
+  }
+}
+
+TEST_CASE("TestCoLockStats") {
+  CHIMAERA_CLIENT_INIT();
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Locks built in arrays are named too
+  chi::CoLockStats before, after;
+  REQUIRE(GetLockStats("admin.create_lock.0", before));
+  REQUIRE(GetLockStats("admin.flush_lock", before));
+
+  // Concurrent flushes queue on the admin flush lock
+  size_t num_flushes = 16;
+  std::vector<FullPtr<chi::Admin::FlushTask>> tasks;
+  for (size_t i = 0; i < num_flushes; ++i) {
+    tasks.emplace_back(
+        CHI_ADMIN->AsyncFlush(HSHM_MCTX, chi::DomainQuery::GetLocalHash(0)));
+  }
+  for (FullPtr<chi::Admin::FlushTask> &task : tasks) {
+    task->Wait();
+    CHI_CLIENT->DelTask(HSHM_MCTX, task);
+  }
+  REQUIRE(GetLockStats("admin.flush_lock", after));
+  REQUIRE(after.acquires_ >= before.acquires_ + num_flushes);
+  REQUIRE(after.contended_ > before.contended_);
+  REQUIRE(after.contended_ <= after.acquires_);
+  REQUIRE(after.total_wait_ns_ > before.total_wait_ns_);
+  REQUIRE(after.max_wait_ns_ > 0);
+  REQUIRE(!after.max_wait_holder_.IsNull());
+}
+
+TEST_CASE("TestSwitchWorkOrchPolicy") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::small_message::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_small_message");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ipc_test");
+  const char *policy_names[2] = {"worch_queue_test_a", "worch_queue_test_b"};
+  chi::worch_queue_round_robin::Client policies[2];
+  for (int i = 0; i < 2; ++i) {
+    policies[i].Create(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+        chi::DomainQuery::GetGlobalBcast(), policy_names[i]);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Switch between the policies while tasks are in flight
+  size_t ops = 1024;
+  std::vector<FullPtr<chi::small_message::MdTask>> tasks;
+  tasks.reserve(ops);
+  for (size_t i = 0; i < ops; ++i) {
+    int cont_id = 1 + ((i + 1) % nprocs);
+    tasks.emplace_back(client.AsyncMd(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers,
+                                        cont_id),
+        0, 0));
+    if (rank == 0 && i % 128 == 0) {
+      CHI_ADMIN->SetWorkOrchQueuePolicy(
+          HSHM_MCTX, DomainQuery::GetLocalHash(0),
+          policies[(i / 128) % 2].pool_id_);
+    }
+  }
+  for (FullPtr<chi::small_message::MdTask> &task : tasks) {
+    task->Wait();
+    REQUIRE(task->ret_ == 1);
+    CHI_CLIENT->DelTask(HSHM_MCTX, task);
+  }
+
+  // The replaced policy stops scheduling, while the new one keeps running
+  if (rank == 0) {
+    CHI_ADMIN->SetWorkOrchQueuePolicy(HSHM_MCTX, DomainQuery::GetLocalHash(0),
+                                      policies[0].pool_id_);
+    size_t old_runs = GetSchedulerRuns(policies[1].pool_id_);
+    size_t new_runs = GetSchedulerRuns(policies[0].pool_id_);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    REQUIRE(GetSchedulerRuns(policies[1].pool_id_) == old_runs);
+    REQUIRE(GetSchedulerRuns(policies[0].pool_id_) > new_runs);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+TEST_CASE("TestCreatePoolsConcurrent") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_small_message");
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Create many pools at once, each of them twice
+  size_t num_pools = 64;
+  chi::small_message::Client client;
+  std::vector<FullPtr<chi::small_message::CreateTask>> tasks;
+  tasks.reserve(2 * num_pools);
+  for (size_t i = 0; i < 2 * num_pools; ++i) {
+    std::string pool_name = hshm::Formatter::format(
+        "concurrent_pool_{}_{}", rank, i % num_pools);
+    tasks.emplace_back(client.AsyncCreate(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+        chi::DomainQuery::GetGlobalBcast(), pool_name.c_str()));
+  }
+  for (FullPtr<chi::small_message::CreateTask> &task : tasks) {
+    task->Wait();
+    REQUIRE(!task->ctx_.id_.IsNull());
+  }
+  for (size_t i = 0; i < num_pools; ++i) {
+    REQUIRE(tasks[i]->ctx_.id_ == tasks[i + num_pools]->ctx_.id_);
+    std::string pool_name = tasks[i]->pool_name_.str();
+    PoolId pool_id = CHI_ADMIN->GetPoolId(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+        pool_name.c_str());
+    REQUIRE(tasks[i]->ctx_.id_ == pool_id);
+  }
+
+  // Destroy and re-create each pool back to back. Both are routed by the
+  // pool's name, so the re-creation always sees the pool destroyed.
+  std::vector<FullPtr<chi::Admin::DestroyContainerTask>> destroys;
+  std::vector<FullPtr<chi::small_message::CreateTask>> recreates;
+  destroys.reserve(num_pools);
+  recreates.reserve(num_pools);
+  for (size_t i = 0; i < num_pools; ++i) {
+    std::string pool_name = tasks[i]->pool_name_.str();
+    destroys.emplace_back(CHI_ADMIN->AsyncDestroyContainer(
+        HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(), tasks[i]->ctx_.id_));
+    recreates.emplace_back(client.AsyncCreate(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+        chi::DomainQuery::GetGlobalBcast(), pool_name.c_str()));
+  }
+  for (size_t i = 0; i < num_pools; ++i) {
+    destroys[i]->Wait();
+    recreates[i]->Wait();
+    REQUIRE(!recreates[i]->ctx_.id_.IsNull());
+    REQUIRE(recreates[i]->ctx_.id_ != tasks[i]->ctx_.id_);
+    std::string pool_name = recreates[i]->pool_name_.str();
+    PoolId pool_id = CHI_ADMIN->GetPoolId(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+        pool_name.c_str());
+    REQUIRE(recreates[i]->ctx_.id_ == pool_id);
+    CHI_CLIENT->DelTask(HSHM_MCTX, destroys[i]);
+    CHI_CLIENT->DelTask(HSHM_MCTX, recreates[i]);
+  }
+  for (FullPtr<chi::small_message::CreateTask> &task : tasks) {
+    CHI_CLIENT->DelTask(HSHM_MCTX, task);
+  }
+}
+
 void TestIpcMultithread(int nprocs) {
   CHIMAERA_CLIENT_INIT();
 
@@ -284,7 +515,63 @@ TEST_CASE("TestUpgrade") {
         ops * (depth + 1) / t.GetUsec());
 }
 
-void TestBdevIo(const std::string &path) {
+TEST_CASE("TestUpgradeInFlight") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::small_message::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_small_message");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ipc_test");
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Md tasks with depth suspend mid-execution on their subtasks. The upgrade
+  // holds new tasks until those drain, but still lets the subtasks in, and
+  // only moves the state once the old containers are idle.
+  int depth = 4;
+  size_t ops = 1024;
+  std::vector<FullPtr<chi::small_message::MdTask>> tasks;
+  tasks.reserve(2 * ops);
+  for (size_t i = 0; i < ops; ++i) {
+    tasks.emplace_back(client.AsyncMd(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, i),
+        depth, 0));
+  }
+  FullPtr<chi::Admin::UpgradeModuleTask> upgrade =
+      CHI_ADMIN->AsyncUpgradeModule(HSHM_MCTX,
+                                    chi::DomainQuery::GetGlobalBcast(),
+                                    "chimaera_small_message");
+  for (size_t i = 0; i < ops; ++i) {
+    tasks.emplace_back(client.AsyncMd(
+        HSHM_MCTX,
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, i),
+        depth, 0));
+  }
+  for (FullPtr<chi::small_message::MdTask> &task : tasks) {
+    task->Wait();
+    REQUIRE(task->ret_ == 1);
+    CHI_CLIENT->DelTask(HSHM_MCTX, task);
+  }
+  upgrade->Wait();
+  CHI_CLIENT->DelTask(HSHM_MCTX, upgrade);
+
+  // The upgraded containers serve new tasks after the old ones are freed
+  REQUIRE(client.Md(HSHM_MCTX,
+                    chi::DomainQuery::GetDirectHash(
+                        chi::SubDomain::kGlobalContainers, 0),
+                    depth, 0) == 1);
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+void TestBdevIo(const std::string &pool_name, const std::string &path,
+                size_t dev_size = GIGABYTES(1)) {
   CHIMAERA_CLIENT_INIT();
 
   int rank, nprocs;
@@ -297,8 +584,8 @@ void TestBdevIo(const std::string &path) {
   client.Create(
       HSHM_MCTX,
       chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
-      chi::DomainQuery::GetGlobalBcast(), "tempdir",
-      "fs::///tmp/chi_test_bdev.bin", GIGABYTES(1));
+      chi::DomainQuery::GetGlobalBcast(), pool_name.c_str(), path.c_str(),
+      dev_size);
   MPI_Barrier(MPI_COMM_WORLD);
   hshm::Timer t;
 
@@ -350,9 +637,817 @@ void TestBdevIo(const std::string &path) {
   CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_read);
 }
 
-TEST_CASE("TestBdevIo") { TestBdevIo("fs::///tmp/chi_test_bdev.bin"); }
+TEST_CASE("TestBdevIo") {
+  TestBdevIo("tempdir", "fs::///tmp/chi_test_bdev.bin");
+}
+
+TEST_CASE("TestBdevRam") { TestBdevIo("ramdisk", "ram:://"); }
+
+TEST_CASE("TestBdevRamHugepages") {
+  TestBdevIo("ramdisk_huge", "ram://?hugetlb&populate", MEGABYTES(64));
+}
+
+TEST_CASE("TestBdevRamThpNuma") {
+  TestBdevIo("ramdisk_thp", "ram://?thp&populate&numa=0", MEGABYTES(64));
+}
+
+void TestBdevIoV(const std::string &pool_name, const std::string &path) {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::bdev::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), pool_name.c_str(), path.c_str(),
+      GIGABYTES(1));
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  size_t io_size = KILOBYTES(256);
+  hipc::FullPtr<char> io_write = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size);
+  hipc::FullPtr<char> io_read = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size);
+  size_t ops = 16;
+  for (size_t i = 0; i < ops; ++i) {
+    chi::DomainQuery dom_query =
+        chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, i);
+    // Allocate 4 blocks and lay the buffer out across them
+    std::vector<chi::Block> blocks;
+    for (size_t j = 0; j < 4; ++j) {
+      std::vector<chi::Block> part =
+          client.Allocate(HSHM_MCTX, dom_query, io_size / 4);
+      blocks.insert(blocks.end(), part.begin(), part.end());
+    }
+    std::vector<chi::bdev::IoSegment> write_segs, read_segs;
+    size_t buf_off = 0;
+    for (chi::Block &block : blocks) {
+      size_t size = std::min(block.size_, io_size - buf_off);
+      write_segs.emplace_back(
+          chi::bdev::IoSegment{io_write.shm_ + buf_off, size, block.off_});
+      read_segs.emplace_back(
+          chi::bdev::IoSegment{io_read.shm_ + buf_off, size, block.off_});
+      buf_off += size;
+    }
+    REQUIRE(buf_off == io_size);
+    // Write and read back all blocks in one task each
+    for (size_t j = 0; j < io_size; ++j) {
+      io_write.ptr_[j] = (char)(i + j);
+    }
+    memset(io_read.ptr_, 0, io_size);
+    REQUIRE(client.WriteV(HSHM_MCTX, dom_query, write_segs));
+    REQUIRE(client.ReadV(HSHM_MCTX, dom_query, read_segs));
+    REQUIRE(memcmp(io_write.ptr_, io_read.ptr_, io_size) == 0);
+    for (chi::Block &block : blocks) {
+      client.Free(HSHM_MCTX, dom_query, block);
+    }
+  }
+
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_write);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_read);
+}
+
+TEST_CASE("TestBdevIoV") {
+  TestBdevIoV("tempdir_vec", "fs::///tmp/chi_test_bdev_vec.bin");
+}
+
+TEST_CASE("TestBdevRamV") { TestBdevIoV("ramdisk_vec", "ram:://"); }
+
+TEST_CASE("TestBdevStriped") {
+  TestBdevIo("tempdir_stripe",
+             "fs::///tmp/chi_test_stripe_a.bin,/tmp/chi_test_stripe_b.bin"
+             "?stripe=64k");
+}
+
+TEST_CASE("TestBdevStripedV") {
+  TestBdevIoV("tempdir_stripe_vec",
+              "fs::///tmp/chi_test_stripe_vec_a.bin,"
+              "/tmp/chi_test_stripe_vec_b.bin?stripe=64k");
+}
+
+TEST_CASE("TestBdevDirect") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::bdev::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "tempdir_direct",
+      "fs::///tmp/chi_test_bdev_direct.bin?direct", GIGABYTES(1));
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  size_t io_size = MEGABYTES(1);
+  hipc::FullPtr<char> io_write =
+      CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size, KILOBYTES(4));
+  hipc::FullPtr<char> io_read =
+      CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size, KILOBYTES(4));
+  REQUIRE((size_t)io_write.ptr_ % KILOBYTES(4) == 0);
+  REQUIRE((size_t)io_read.ptr_ % KILOBYTES(4) == 0);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+  std::vector<chi::Block> blocks =
+      client.Allocate(HSHM_MCTX, dom_query, io_size);
+  chi::Block block = blocks[0];
+  REQUIRE(block.off_ % KILOBYTES(4) == 0);
+
+  // Aligned I/O goes straight to the device
+  memset(io_write.ptr_, 10, io_size);
+  memset(io_read.ptr_, 0, io_size);
+  client.Write(HSHM_MCTX, dom_query, io_write.shm_, block.off_, io_size);
+  client.Read(HSHM_MCTX, dom_query, io_read.shm_, block.off_, io_size);
+  REQUIRE(memcmp(io_write.ptr_, io_read.ptr_, io_size) == 0);
+
+  // Misaligned I/O is bounced and keeps the surrounding bytes
+  size_t off = 100, size = 1000;
+  memset(io_write.ptr_ + 3, 11, size);
+  client.Write(HSHM_MCTX, dom_query, io_write.shm_ + 3, block.off_ + off,
+               size);
+  client.Read(HSHM_MCTX, dom_query, io_read.shm_, block.off_, io_size);
+  for (size_t i = 0; i < KILOBYTES(4); ++i) {
+    char expected = (off <= i && i < off + size) ? 11 : 10;
+    REQUIRE(io_read.ptr_[i] == expected);
+  }
+
+  client.Free(HSHM_MCTX, dom_query, block);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_write);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_read);
+}
+
+TEST_CASE("TestBdevFreeBatch") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::bdev::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ramdisk_free_batch", "ram://",
+      MEGABYTES(64));
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+  std::vector<chi::Block> blocks;
+  for (size_t i = 0; i < 256; ++i) {
+    std::vector<chi::Block> part =
+        client.Allocate(HSHM_MCTX, dom_query, KILOBYTES(4));
+    REQUIRE(part.size() == 1);
+    blocks.emplace_back(part[0]);
+  }
+  chi::BdevStats before = client.PollStats(HSHM_MCTX, dom_query);
+  client.FreeBatch(HSHM_MCTX, dom_query, blocks);
+  chi::BdevStats after = client.PollStats(HSHM_MCTX, dom_query);
+  if (nprocs == 1) {
+    // The freed blocks are returned to the free list and reused
+    REQUIRE(after.free_ == before.free_ + MEGABYTES(1));
+    std::vector<chi::Block> reused =
+        client.Allocate(HSHM_MCTX, dom_query, KILOBYTES(4));
+    REQUIRE(reused.size() == 1);
+    bool found = false;
+    for (chi::Block &block : blocks) {
+      found |= block.off_ == reused[0].off_;
+    }
+    REQUIRE(found);
+    client.FreeBatch(HSHM_MCTX, dom_query, reused);
+  }
+}
+
+TEST_CASE("TestBdevChecksum") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::bdev::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  std::string path = "/tmp/chi_test_bdev_crc.bin";
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "tempdir_crc",
+      ("fs://" + path + "?checksum").c_str(), MEGABYTES(64));
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  size_t io_size = KILOBYTES(64);
+  hipc::FullPtr<char> io_write = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size);
+  hipc::FullPtr<char> io_read = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+  std::vector<chi::Block> blocks =
+      client.Allocate(HSHM_MCTX, dom_query, io_size);
+  chi::Block block = blocks[0];
+
+  // Full and partial writes are verified on read
+  memset(io_write.ptr_, 10, io_size);
+  REQUIRE(client.Write(HSHM_MCTX, dom_query, io_write.shm_, block));
+  REQUIRE(client.Write(HSHM_MCTX, dom_query, io_write.shm_ + 5,
+                       block.off_ + 100, 1000));
+  REQUIRE(client.Read(HSHM_MCTX, dom_query, io_read.shm_, block));
+  REQUIRE(client.Read(HSHM_MCTX, dom_query, io_read.shm_, block.off_ + 7,
+                      100));
+  chi::BdevStats stats = client.PollStats(HSHM_MCTX, dom_query);
+  REQUIRE(stats.checksum_errors_ == 0);
+
+  // Corrupt the data behind the runtime's back
+  if (nprocs == 1) {
+    char garbage[16];
+    memset(garbage, 11, sizeof(garbage));
+    for (int id = 0; id < 8; ++id) {
+      std::string dev = hshm::Formatter::format("{}.{}", path, id);
+      int fd = open(dev.c_str(), O_WRONLY);
+      if (fd < 0) {
+        continue;
+      }
+      REQUIRE(pwrite(fd, garbage, sizeof(garbage), block.off_ + 4096) ==
+              sizeof(garbage));
+      close(fd);
+    }
+    REQUIRE(!client.Read(HSHM_MCTX, dom_query, io_read.shm_, block));
+    stats = client.PollStats(HSHM_MCTX, dom_query);
+    REQUIRE(stats.checksum_errors_ == 1);
+  }
 
-TEST_CASE("TestBdevRam") { TestBdevIo("ram:://"); }
+  client.Free(HSHM_MCTX, dom_query, block);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_write);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_read);
+}
+
+TEST_CASE("TestBdevQos") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::bdev::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  // Each tenant may issue 100 I/O per second
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ramdisk_qos", "ram://",
+      MEGABYTES(64), chi::CreateContext(), chi::QosLimits(),
+      chi::QosLimits(0, 100));
+  MPI_Barrier(MPI_COMM_WORLD);
+  client.SetTenant(rank + 1);
+
+  size_t io_size = KILOBYTES(4);
+  hipc::FullPtr<char> io_write = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+  std::vector<chi::Block> blocks =
+      client.Allocate(HSHM_MCTX, dom_query, io_size);
+  chi::Block block = blocks[0];
+  memset(io_write.ptr_, 10, io_size);
+
+  // The first 11 I/O use up the burst of 10 tokens (the bucket may be
+  // overdrawn by one). The other 19 wait 10ms each, at least 190ms.
+  hshm::Timer t;
+  t.Resume();
+  for (size_t i = 0; i < 30; ++i) {
+    REQUIRE(client.Write(HSHM_MCTX, dom_query, io_write.shm_, block));
+  }
+  t.Pause();
+  HILOG(kInfo, "Throttled I/O took {} ms", t.GetMsec());
+  REQUIRE(t.GetUsec() >= 190000);
+
+  // Lifting the limit lets the tenant run unthrottled
+  client.SetQos(HSHM_MCTX, dom_query, rank + 1, chi::QosLimits());
+  for (size_t i = 0; i < 30; ++i) {
+    REQUIRE(client.Write(HSHM_MCTX, dom_query, io_write.shm_, block));
+  }
+
+  client.Free(HSHM_MCTX, dom_query, block);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_write);
+}
+
+TEST_CASE("TestCacheBdev") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_cache");
+  chi::bdev::Client bdev;
+  bdev.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ramdisk_cache", "ram://",
+      MEGABYTES(64));
+  chi::cache::Client cache;
+  cache.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "cache_wb", bdev.pool_id_,
+      MEGABYTES(16), KILOBYTES(64), chi::cache::CacheMode::kWriteBack);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  size_t io_size = KILOBYTES(96);
+  hipc::FullPtr<char> io_write = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size);
+  hipc::FullPtr<char> io_read = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, io_size);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+  std::vector<chi::Block> blocks =
+      bdev.Allocate(HSHM_MCTX, dom_query, MEGABYTES(1));
+  chi::Block block = blocks[0];
+  size_t off = block.off_ + KILOBYTES(16);
+  memset(io_write.ptr_, 10 + rank, io_size);
+
+  // The write stays in the cache until flushed
+  REQUIRE(cache.Write(HSHM_MCTX, dom_query, io_write.shm_, off, io_size));
+  chi::cache::CacheStats stats = cache.PollStats(HSHM_MCTX, dom_query);
+  REQUIRE(stats.dirty_ > 0);
+  chi::cache::CacheStats prior = stats;
+  REQUIRE(cache.Read(HSHM_MCTX, dom_query, io_read.shm_, off, io_size));
+  REQUIRE(memcmp(io_write.ptr_, io_read.ptr_, io_size) == 0);
+  stats = cache.PollStats(HSHM_MCTX, dom_query);
+  REQUIRE(stats.hits_ > prior.hits_);
+  cache.Flush(HSHM_MCTX, dom_query);
+
+  // The bdev has the data after the flush
+  memset(io_read.ptr_, 0, io_size);
+  REQUIRE(bdev.Read(HSHM_MCTX, dom_query, io_read.shm_, off, io_size));
+  REQUIRE(memcmp(io_write.ptr_, io_read.ptr_, io_size) == 0);
+  HILOG(kInfo, "Cache stats: {}", cache.PollStats(HSHM_MCTX, dom_query));
+
+  // The cache shard locks report their acquisitions
+  if (nprocs == 1) {
+    size_t acquires = 0;
+    for (int i = 0; i < 8; ++i) {
+      chi::CoLockStats lock_stats;
+      std::string name = hshm::Formatter::format("cache.cache_wb.shard.{}", i);
+      REQUIRE(GetLockStats(name, lock_stats));
+      acquires += lock_stats.acquires_;
+    }
+    REQUIRE(acquires > 0);
+  }
+
+  bdev.Free(HSHM_MCTX, dom_query, block);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_write);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, io_read);
+}
+
+TEST_CASE("TestKvstore") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_kvstore");
+  chi::bdev::Client bdev;
+  bdev.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ramdisk_kvstore", "ram://",
+      MEGABYTES(256));
+  // Compaction only runs when requested
+  chi::kvstore::Client kvs;
+  kvs.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "kvstore", bdev.pool_id_, 0);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  size_t num_keys = 128;
+  size_t val_size = KILOBYTES(64);
+  hipc::FullPtr<char> val = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, val_size);
+  hipc::FullPtr<char> out = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, val_size);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+  auto key_of = [rank](size_t i) {
+    return hshm::Formatter::format("rank{}/key{}", rank, i);
+  };
+
+  // Write every key twice, so the first log segments become garbage
+  for (int round = 0; round < 2; ++round) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      memset(val.ptr_, (int)(i + round), val_size);
+      REQUIRE(kvs.Put(HSHM_MCTX, dom_query, key_of(i), val.shm_, val_size));
+    }
+  }
+  for (size_t i = 0; i < num_keys; i += 2) {
+    REQUIRE(kvs.Delete(HSHM_MCTX, dom_query, key_of(i)));
+  }
+  REQUIRE(!kvs.Delete(HSHM_MCTX, dom_query, key_of(0)));
+
+  // Scan only sees this rank's remaining keys
+  std::vector<std::string> keys = kvs.Scan(
+      HSHM_MCTX, dom_query, hshm::Formatter::format("rank{}/", rank), 1000);
+  REQUIRE(keys.size() == num_keys / 2);
+  REQUIRE(std::is_sorted(keys.begin(), keys.end()));
+
+  kvs.Compact(HSHM_MCTX, dom_query);
+  chi::kvstore::KvStats stats = kvs.PollStats(HSHM_MCTX, dom_query);
+  HILOG(kInfo, "Kvstore stats: {}", stats);
+  REQUIRE(stats.compactions_ > 0);
+
+  // Values survive compaction
+  for (size_t i = 0; i < num_keys; ++i) {
+    size_t value_size;
+    bool found = kvs.Get(HSHM_MCTX, dom_query, key_of(i), out.shm_, val_size,
+                         value_size);
+    REQUIRE(found == (i % 2 == 1));
+    if (!found) {
+      continue;
+    }
+    REQUIRE(value_size == val_size);
+    memset(val.ptr_, (int)(i + 1), val_size);
+    REQUIRE(memcmp(val.ptr_, out.ptr_, val_size) == 0);
+  }
+
+  // The partition locks report their acquisitions
+  if (nprocs == 1) {
+    size_t acquires = 0;
+    for (int i = 0; i < 8; ++i) {
+      chi::CoLockStats lock_stats;
+      std::string name =
+          hshm::Formatter::format("kvstore.kvstore.partition.{}", i);
+      REQUIRE(GetLockStats(name, lock_stats));
+      acquires += lock_stats.acquires_;
+    }
+    REQUIRE(acquires > 0);
+  }
+
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, val);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, out);
+}
+
+TEST_CASE("TestCompressor") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_compressor");
+  chi::compressor::Client client;
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "compressor");
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  size_t size = MEGABYTES(1);
+  size_t cap = chi::compressor::GetCompressBound(size);
+  hipc::FullPtr<char> data = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, size);
+  hipc::FullPtr<char> comp = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, cap);
+  hipc::FullPtr<char> decomp = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, size);
+  for (size_t i = 0; i < size; ++i) {
+    data.ptr_[i] = (char)(i % 61);
+  }
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+
+  std::vector<u32> codecs = {
+      chi::compressor::Codec::kNone, chi::compressor::Codec::kZlib,
+      chi::compressor::Codec::kLz4, chi::compressor::Codec::kZstd,
+      chi::compressor::Codec::kSnappy, chi::compressor::Codec::kAuto};
+  for (u32 codec : codecs) {
+    size_t comp_size = client.Compress(HSHM_MCTX, dom_query, codec, data.shm_,
+                                       size, comp.shm_, cap);
+    REQUIRE(comp_size > 0);
+    REQUIRE(codec != chi::compressor::Codec::kAuto);
+    // Repetitive data should shrink with every real codec
+    if (codec != chi::compressor::Codec::kNone) {
+      REQUIRE(comp_size < size);
+    }
+    memset(decomp.ptr_, 0, size);
+    size_t decomp_size =
+        client.Decompress(HSHM_MCTX, dom_query, codec, comp.shm_, comp_size,
+                          decomp.shm_, size);
+    REQUIRE(decomp_size == size);
+    REQUIRE(memcmp(data.ptr_, decomp.ptr_, size) == 0);
+    HILOG(kInfo, "Codec {} compressed {} bytes to {}", codec, size, comp_size);
+  }
+
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, data);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, comp);
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, decomp);
+}
+
+TEST_CASE("TestTaskCache") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::small_message::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_small_message");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ipc_test");
+  MPI_Barrier(MPI_COMM_WORLD);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+
+  // A freed task is reused by the next task of its type
+  hipc::FullPtr<chi::small_message::MdTask> task =
+      client.AsyncMd(HSHM_MCTX, dom_query, 0, 0);
+  task->Wait();
+  REQUIRE(task->ret_ == 1);
+  chi::small_message::MdTask *prior = task.ptr_;
+  CHI_CLIENT->DelTask(HSHM_MCTX, task);
+  task = client.AsyncMd(HSHM_MCTX, dom_query, 0, 0);
+  task->Wait();
+  REQUIRE(task->ret_ == 1);
+  if (CHI_CLIENT->task_cache_depth_ > 0) {
+    REQUIRE(task.ptr_ == prior);
+  }
+  CHI_CLIENT->DelTask(HSHM_MCTX, task);
+
+  // Freeing more tasks than the cache holds goes back to the allocator
+  std::vector<hipc::FullPtr<chi::small_message::MdTask>> tasks;
+  for (size_t i = 0; i < 2 * CHI_CLIENT->task_cache_depth_ + 1; ++i) {
+    tasks.emplace_back(client.AsyncMd(HSHM_MCTX, dom_query, 0, 0));
+  }
+  for (hipc::FullPtr<chi::small_message::MdTask> &t : tasks) {
+    t->Wait();
+    REQUIRE(t->ret_ == 1);
+    CHI_CLIENT->DelTask(HSHM_MCTX, t);
+  }
+}
+
+TEST_CASE("TestBufferWaitTimeout") {
+  CHIMAERA_CLIENT_INIT();
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // A buffer larger than data shm can never be allocated
+  chi::BufferStats before = CHI_CLIENT->GetBufferStats();
+  size_t timeout_ms = CHI_CLIENT->buffer_wait_timeout_ms_;
+  CHI_CLIENT->buffer_wait_timeout_ms_ = 100;
+  hshm::Timer t;
+  t.Resume();
+  hipc::FullPtr<char> p =
+      CHI_CLIENT->AllocateBuffer(HSHM_MCTX, (size_t)1 << 40);
+  t.Pause();
+  CHI_CLIENT->buffer_wait_timeout_ms_ = timeout_ms;
+  REQUIRE(p.shm_.IsNull());
+  REQUIRE(t.GetUsec() >= 100000);
+  chi::BufferStats after = CHI_CLIENT->GetBufferStats();
+  REQUIRE(after.exhausted_ > before.exhausted_);
+  REQUIRE(after.timeouts_ > before.timeouts_);
+
+  // Buffers can be allocated again afterwards
+  p = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, KILOBYTES(4));
+  REQUIRE(!p.shm_.IsNull());
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, p);
+}
+
+TEST_CASE("TestAdmission") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::small_message::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_small_message");
+  // At most 4 tasks of the pool are in flight per client
+  chi::CreateContext ctx;
+  ctx.max_inflight_per_client_ = 4;
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ipc_test_admission", ctx);
+  MPI_Barrier(MPI_COMM_WORLD);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+
+  // Hold every slot of this client with tasks that are admitted but never
+  // sent, so no slot frees up while the limit is checked
+  bool reject = CHI_CLIENT->admission_reject_;
+  CHI_CLIENT->admission_reject_ = true;
+  chi::AdmissionTable &table = CHI_CLIENT->header_->admission_;
+  std::vector<hipc::FullPtr<chi::small_message::MdTask>> held;
+  for (size_t i = 0; i < 4; ++i) {
+    held.emplace_back(client.AsyncMdAlloc(
+        HSHM_MCTX, CHI_CLIENT->MakeTaskNodeId(), dom_query, 0, 0));
+    REQUIRE(CHI_CLIENT->Admit(held.back().ptr_, true));
+  }
+  int slot = table.Find(client.pool_id_, HSHM_SYSTEM_INFO->pid_, false);
+  REQUIRE(slot >= 0);
+  REQUIRE(table.Get(slot).inflight_.load() == 4);
+
+  // Tasks past the limit are rejected instead of queued
+  chi::AdmissionStats before = CHI_CLIENT->GetAdmissionStats();
+  std::vector<hipc::FullPtr<chi::small_message::MdTask>> tasks;
+  for (size_t i = 0; i < 16; ++i) {
+    tasks.emplace_back(client.AsyncMd(HSHM_MCTX, dom_query, 0, 0));
+    REQUIRE(tasks.back()->IsRejected());
+    REQUIRE(table.Get(slot).inflight_.load() == 4);
+  }
+  // A rejected fire & forget task is deleted, and counted as dropped
+  client.AsyncMd(HSHM_MCTX, dom_query, 0, TASK_FIRE_AND_FORGET);
+  chi::AdmissionStats after = CHI_CLIENT->GetAdmissionStats();
+  REQUIRE(after.rejected_ - before.rejected_ >= 17);
+  REQUIRE(after.dropped_ - before.dropped_ >= 1);
+  // TASK_KEEP_REJECTED returns a rejected task without sending it again
+  tasks[0]->Wait(TASK_COMPLETE | TASK_KEEP_REJECTED);
+  REQUIRE(tasks[0]->IsRejected());
+  REQUIRE(table.Get(slot).inflight_.load() == 4);
+
+  // A blocked task sleeps until a slot is released
+  CHI_CLIENT->admission_reject_ = false;
+  int blocked_ret = 0;
+  std::thread blocked(
+      [&]() { blocked_ret = client.Md(HSHM_MCTX, dom_query, 0, 0); });
+  while (CHI_CLIENT->GetAdmissionStats().waiters_ == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE(blocked_ret == 0);
+  for (hipc::FullPtr<chi::small_message::MdTask> &t : held) {
+    CHI_CLIENT->ReleaseAdmission(t.ptr_);
+    CHI_CLIENT->DelTask(HSHM_MCTX, t);
+  }
+  blocked.join();
+  REQUIRE(blocked_ret == 1);
+
+  // Waiting on a rejected task sends it again, so every task runs
+  for (hipc::FullPtr<chi::small_message::MdTask> &t : tasks) {
+    t->Wait();
+    REQUIRE(!t->IsRejected());
+    REQUIRE(t->ret_ == 1);
+    CHI_CLIENT->DelTask(HSHM_MCTX, t);
+  }
+  // The sync wrappers never return the output of a rejected task
+  CHI_CLIENT->admission_reject_ = true;
+  for (size_t i = 0; i < 64; ++i) {
+    REQUIRE(client.Md(HSHM_MCTX, dom_query, 0, 0) == 1);
+  }
+  CHI_CLIENT->admission_reject_ = reject;
+
+  // Blocking admission completes every task
+  for (size_t i = 0; i < 64; ++i) {
+    REQUIRE(client.Md(HSHM_MCTX, dom_query, 0, 0) == 1);
+  }
+}
+
+TEST_CASE("TestLanePolicy") {
+  CHIMAERA_CLIENT_INIT();
+
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  chi::small_message::Client client;
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_small_message");
+  client.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ipc_test");
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // A thread with a sticky lane sends every task to the same lane
+  chi::LanePolicy policy = CHI_CLIENT->lane_policy_;
+  CHI_CLIENT->lane_policy_ = chi::LanePolicy::kSticky;
+  std::vector<size_t> before = CHI_CLIENT->GetLaneStats();
+  size_t ops = 64;
+  for (size_t i = 0; i < ops; ++i) {
+    int ret = client.Md(HSHM_MCTX,
+                        chi::DomainQuery::GetDirectHash(
+                            chi::SubDomain::kGlobalContainers, i),
+                        0, 0);
+    REQUIRE(ret == 1);
+  }
+  std::vector<size_t> after = CHI_CLIENT->GetLaneStats();
+  CHI_CLIENT->lane_policy_ = policy;
+  REQUIRE(after.size() == before.size());
+  size_t lanes_used = 0;
+  for (size_t lane_id = 0; lane_id < after.size(); ++lane_id) {
+    size_t count = after[lane_id] - before[lane_id];
+    if (count) {
+      REQUIRE(count == ops);
+      ++lanes_used;
+    }
+  }
+  REQUIRE(lanes_used == 1);
+
+  // A thread on a CPU only uses the lanes polled on the CPU's NUMA node
+  cpu_set_t old_mask;
+  sched_getaffinity(0, sizeof(old_mask), &old_mask);
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  CPU_SET(0, &mask);
+  REQUIRE(sched_setaffinity(0, sizeof(mask), &mask) == 0);
+  int node = chi::ConfigurationManager::GetNumaNode(0);
+  chi::ingress::LaneGroup &lane_group =
+      CHI_CLIENT->GetQueue(chi::PROCESS_QUEUE_ID)
+          ->GetGroup(chi::TaskPrioOpt::kLowLatency);
+  bool node_has_lanes = false;
+  for (chi::LaneId lane_id = 0; lane_id < after.size(); ++lane_id) {
+    node_has_lanes |= lane_group.GetLane(lane_id).numa_node_ == node;
+  }
+  CHI_CLIENT->lane_policy_ = chi::LanePolicy::kNuma;
+  before = CHI_CLIENT->GetLaneStats();
+  for (size_t i = 0; i < ops; ++i) {
+    int ret = client.Md(HSHM_MCTX,
+                        chi::DomainQuery::GetDirectHash(
+                            chi::SubDomain::kGlobalContainers, i),
+                        0, 0);
+    REQUIRE(ret == 1);
+  }
+  after = CHI_CLIENT->GetLaneStats();
+  CHI_CLIENT->lane_policy_ = policy;
+  sched_setaffinity(0, sizeof(old_mask), &old_mask);
+  size_t numa_ops = 0;
+  for (chi::LaneId lane_id = 0; lane_id < after.size(); ++lane_id) {
+    size_t count = after[lane_id] - before[lane_id];
+    if (count && node_has_lanes) {
+      REQUIRE(lane_group.GetLane(lane_id).numa_node_ == node);
+    }
+    numa_ops += count;
+  }
+  REQUIRE(numa_ops == ops);
+
+  // Tasks on one key share a lane, even when other keys of the same
+  // container are spread over the lanes
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_bdev");
+  CHI_ADMIN->RegisterModule(HSHM_MCTX, chi::DomainQuery::GetGlobalBcast(),
+                            "chimaera_kvstore");
+  chi::bdev::Client bdev;
+  bdev.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "ramdisk_lane_policy", "ram://",
+      MEGABYTES(64));
+  chi::kvstore::Client kvs;
+  kvs.Create(
+      HSHM_MCTX,
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0),
+      chi::DomainQuery::GetGlobalBcast(), "kvstore_lane_policy", bdev.pool_id_,
+      0);
+  MPI_Barrier(MPI_COMM_WORLD);
+  chi::DomainQuery dom_query =
+      chi::DomainQuery::GetDirectHash(chi::SubDomain::kGlobalContainers, 0);
+  size_t val_size = KILOBYTES(4);
+  hipc::FullPtr<char> val = CHI_CLIENT->AllocateBuffer(HSHM_MCTX, val_size);
+  memset(val.ptr_, 1, val_size);
+  CHI_CLIENT->lane_policy_ = chi::LanePolicy::kKey;
+  std::string key = hshm::Formatter::format("rank{}/key", rank);
+  before = CHI_CLIENT->GetLaneStats();
+  for (size_t i = 0; i < ops; ++i) {
+    REQUIRE(kvs.Put(HSHM_MCTX, dom_query, key, val.shm_, val_size));
+  }
+  after = CHI_CLIENT->GetLaneStats();
+  lanes_used = 0;
+  for (size_t lane_id = 0; lane_id < after.size(); ++lane_id) {
+    size_t count = after[lane_id] - before[lane_id];
+    if (count) {
+      REQUIRE(count == ops);
+      ++lanes_used;
+    }
+  }
+  REQUIRE(lanes_used == 1);
+  before = CHI_CLIENT->GetLaneStats();
+  for (size_t i = 0; i < ops; ++i) {
+    std::string key_i = hshm::Formatter::format("rank{}/key{}", rank, i);
+    REQUIRE(kvs.Put(HSHM_MCTX, dom_query, key_i, val.shm_, val_size));
+  }
+  after = CHI_CLIENT->GetLaneStats();
+  CHI_CLIENT->lane_policy_ = policy;
+  lanes_used = 0;
+  for (size_t lane_id = 0; lane_id < after.size(); ++lane_id) {
+    if (after[lane_id] != before[lane_id]) {
+      ++lanes_used;
+    }
+  }
+  if (after.size() > 1) {
+    REQUIRE(lanes_used > 1);
+  }
+  CHI_CLIENT->FreeBuffer(HSHM_MCTX, val);
+}
 
 #ifdef CHIMAERA_ENABLE_PYTHON
 
@@ -0,0 +1,116 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <random>
+
+#include "basic_test.h"
+#include "chimaera/work_orchestrator/lane_balancer.h"
+
+using chi::LaneBalancer;
+using chi::LaneLoadInfo;
+using chi::LaneMigration;
+using chi::WorkerId;
+
+/** Sum the load of each worker */
+static std::unordered_map<WorkerId, size_t> GetWorkerLoads(
+    const std::vector<LaneLoadInfo> &lanes, bool low_latency) {
+  std::unordered_map<WorkerId, size_t> loads;
+  for (const LaneLoadInfo &lane : lanes) {
+    if (lane.low_latency_ == low_latency) {
+      loads[lane.worker_id_] += lane.load_;
+    }
+  }
+  return loads;
+}
+
+/** Run scheduling rounds until the balancer stops moving lanes */
+static size_t Simulate(LaneBalancer &balancer,
+                       std::vector<LaneLoadInfo> &lanes,
+                       const std::vector<WorkerId> &dworkers,
+                       const std::vector<WorkerId> &oworkers) {
+  size_t rounds = 0;
+  for (; rounds < 64; ++rounds) {
+    std::vector<LaneMigration> migrations =
+        balancer.Balance(lanes, dworkers, oworkers);
+    if (migrations.empty()) {
+      break;
+    }
+    for (LaneMigration &migration : migrations) {
+      lanes[migration.lane_].worker_id_ = migration.worker_id_;
+    }
+  }
+  return rounds;
+}
+
+TEST_CASE("TestLaneBalancerSkew") {
+  // 4 overlapped workers, all 32 lanes start on worker 2
+  std::vector<WorkerId> dworkers = {0, 1};
+  std::vector<WorkerId> oworkers = {2, 3, 4, 5};
+  std::mt19937 rng(1024);
+  std::uniform_int_distribution<size_t> dist(1, 100);
+  std::vector<LaneLoadInfo> lanes;
+  size_t total = 0;
+  for (int i = 0; i < 32; ++i) {
+    size_t load = dist(rng);
+    total += load;
+    lanes.emplace_back(LaneLoadInfo{load, 2, false});
+  }
+  LaneBalancer balancer;
+  size_t rounds = Simulate(balancer, lanes, dworkers, oworkers);
+  REQUIRE(rounds < 64);
+
+  // Every worker got a share and the makespan is near the average
+  std::unordered_map<WorkerId, size_t> loads = GetWorkerLoads(lanes, false);
+  size_t max_load = 0;
+  for (WorkerId worker_id : oworkers) {
+    REQUIRE(loads[worker_id] > 0);
+    max_load = std::max(max_load, loads[worker_id]);
+  }
+  REQUIRE(max_load <= total / oworkers.size() + 100);
+  for (LaneLoadInfo &lane : lanes) {
+    REQUIRE(lane.worker_id_ >= 2);
+  }
+}
+
+TEST_CASE("TestLaneBalancerLowLatency") {
+  // Low-latency lanes placed on an overlapped worker return to dedicated ones
+  std::vector<WorkerId> dworkers = {0, 1};
+  std::vector<WorkerId> oworkers = {2, 3};
+  std::vector<LaneLoadInfo> lanes;
+  for (int i = 0; i < 8; ++i) {
+    lanes.emplace_back(LaneLoadInfo{10, 3, true});
+    lanes.emplace_back(LaneLoadInfo{1000, 2, false});
+  }
+  LaneBalancer balancer;
+  Simulate(balancer, lanes, dworkers, oworkers);
+  std::unordered_map<WorkerId, size_t> low = GetWorkerLoads(lanes, true);
+  std::unordered_map<WorkerId, size_t> high = GetWorkerLoads(lanes, false);
+  for (LaneLoadInfo &lane : lanes) {
+    if (lane.low_latency_) {
+      REQUIRE(lane.worker_id_ <= 1);
+    } else {
+      REQUIRE(lane.worker_id_ >= 2);
+    }
+  }
+  REQUIRE(low[0] == low[1]);
+  REQUIRE(high[2] == high[3]);
+}
+
+TEST_CASE("TestLaneBalancerStable") {
+  // A balanced placement is left alone
+  std::vector<WorkerId> dworkers = {0};
+  std::vector<WorkerId> oworkers = {1, 2};
+  std::vector<LaneLoadInfo> lanes = {
+      {50, 1, false}, {50, 2, false}, {5, 0, true}};
+  LaneBalancer balancer;
+  REQUIRE(balancer.Balance(lanes, dworkers, oworkers).empty());
+}
@@ -1,8 +1,14 @@
+#include <dlfcn.h>
 #include <hermes_shm/util/affinity.h>
 #include <hermes_shm/util/timer.h>
 #include <mpi.h>
+#include <unistd.h>
 
 #include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
 
 #include "basic_test.h"
 #include "bdev/bdev_client.h"
@@ -20,3 +26,109 @@ TEST_CASE("TestMalloc") {
   free(x);
   free(y);
 }
+
+/** Run with the interposer preloaded */
+TEST_CASE("TestMallocThreadCache") {
+  CHIMAERA_CLIENT_INIT();
+  REQUIRE(dlsym(RTLD_DEFAULT, "chi_malloc_dump_stats") != nullptr);
+  size_t size = hshm::Unit<size_t>::Megabytes(2);
+
+  // Large allocations come from shm, and a freed one is handed out again
+  // by the thread's cache
+  void *a = malloc(size);
+  REQUIRE(CHI_CLIENT->data_alloc_->ContainsPtr(a));
+  free(a);
+  void *b = malloc(size);
+  REQUIRE(b == a);
+  free(b);
+
+  std::atomic<int> errors = 0;
+#pragma omp parallel for num_threads(4)
+  for (int i = 0; i < 64; ++i) {
+    // Repeated allocations of a size class reuse the thread's cache
+    char *x = (char *)malloc(size);
+    errors += !CHI_CLIENT->data_alloc_->ContainsPtr(x);
+    memset(x, i, size);
+    // Growing within the size class keeps the data in place
+    x = (char *)realloc(x, size + 1024);
+    errors += x[size - 1] != (char)i;
+    x = (char *)realloc(x, 2 * size);
+    errors += x[size - 1] != (char)i;
+    free(x);
+  }
+  REQUIRE(errors == 0);
+  char *z = (char *)calloc(1, size);
+  REQUIRE(z[size - 1] == 0);
+  free(z);
+}
+
+/** Read the interposer's statistics report */
+static std::string ReadMallocStats(void (*dump_stats)(int)) {
+  FILE *file = tmpfile();
+  REQUIRE(file != nullptr);
+  dump_stats(fileno(file));
+  std::string report;
+  char buf[4096];
+  lseek(fileno(file), 0, SEEK_SET);
+  ssize_t count;
+  while ((count = read(fileno(file), buf, sizeof(buf))) > 0) {
+    report.append(buf, count);
+  }
+  fclose(file);
+  return report;
+}
+
+/** Parse the total allocation count of \a kind ("heap" or "shm ") */
+static size_t GetTotalAllocs(const std::string &report, const char *kind) {
+  size_t pos = report.find("  total:");
+  REQUIRE(pos != std::string::npos);
+  pos = report.find(std::string(kind) + " allocs ", pos);
+  REQUIRE(pos != std::string::npos);
+  return std::stoull(report.substr(pos + strlen(kind) + 8));
+}
+
+/** Run with the interposer preloaded and CHI_MALLOC_STATS=1 */
+TEST_CASE("TestMallocStats") {
+  CHIMAERA_CLIENT_INIT();
+  auto dump_stats =
+      (void (*)(int))dlsym(RTLD_DEFAULT, "chi_malloc_dump_stats");
+  REQUIRE(dump_stats != nullptr);
+  const char *stats_env = getenv("CHI_MALLOC_STATS");
+  REQUIRE(stats_env != nullptr);
+  REQUIRE(std::string(stats_env) == "1");
+
+  std::string before = ReadMallocStats(dump_stats);
+  size_t heap_before = GetTotalAllocs(before, "heap");
+  size_t shm_before = GetTotalAllocs(before, "shm ");
+
+  // Small allocations go to the heap, large ones to shm
+  std::vector<void *> heap_ptrs;
+  for (int i = 0; i < 64; ++i) {
+    heap_ptrs.emplace_back(malloc(1024));
+  }
+  size_t large_size = hshm::Unit<size_t>::Megabytes(16);
+  void *large = malloc(large_size);
+  REQUIRE(large != nullptr);
+  char large_str[64];
+  snprintf(large_str, sizeof(large_str), "%p: ", large);
+
+  std::string after = ReadMallocStats(dump_stats);
+  REQUIRE(GetTotalAllocs(after, "heap") >= heap_before + 64);
+  REQUIRE(GetTotalAllocs(after, "shm ") >= shm_before + 1);
+  // The large allocation is among the largest outstanding ones
+  size_t table = after.find("largest outstanding allocations:");
+  REQUIRE(table != std::string::npos);
+  size_t entry = after.find(large_str, table);
+  REQUIRE(entry != std::string::npos);
+  REQUIRE(after.find(" shm\n", entry) != std::string::npos);
+
+  // Freed allocations leave the table
+  free(large);
+  for (void *ptr : heap_ptrs) {
+    free(ptr);
+  }
+  std::string freed = ReadMallocStats(dump_stats);
+  table = freed.find("largest outstanding allocations:");
+  REQUIRE(table != std::string::npos);
+  REQUIRE(freed.find(large_str, table) == std::string::npos);
+}